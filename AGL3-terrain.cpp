@@ -11,6 +11,15 @@
 #include <cmath>
 #include <algorithm>
 #include <array>
+#include <chrono>
+#include <deque>
+#include <random>
+#include <atomic>
+#include <csignal>
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#endif
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -20,10 +29,21 @@
 #include <AGL3Drawable.hpp>
 #include <Config.hpp>
 #include <TileManager.hpp>
+#include <Viewshed.hpp>
+#include <MapRenderer.hpp>
+#include <TileServer.hpp>
+#include <SoftRasterizer.hpp>
+#include <MeshExporter.hpp>
+#include <Contours.hpp>
+#include <TerrainAnalysis.hpp>
+#include <PolygonStats.hpp>
 #include <FrameHistory.hpp>
 
 const float PI = M_PI;
 
+// Chwila uruchomienia programu (inicjalizacja statyczna) - czas do pierwszej klatki
+static const auto launchTime = std::chrono::high_resolution_clock::now();
+
 class MySphere : public AGLDrawable {
 public:
     MySphere() : AGLDrawable(0) {
@@ -53,14 +73,15 @@ public:
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
 
     }
-    void draw(const glm::mat4& view, const glm::mat4& projection) {
+    void draw(const glm::mat4& view, const glm::mat4& projection, const glm::dvec3& eye = glm::dvec3(0.0)) {
         bindProgram();
         bindBuffers();
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
 
+        // Przesunięcie względem kamery liczone w podwójnej precyzji
         glm::mat4 model(1.0f);
-        model = glm::translate( model, center );
+        model = glm::translate( model, glm::vec3( glm::dvec3(center) - eye ) );
         model = glm::scale    ( model, glm::vec3(scale * scaleFactor) );
 
         glUniformMatrix4fv(10, 1, GL_FALSE, glm::value_ptr(model));
@@ -212,6 +233,13 @@ public:
         return glm::lookAt(position, target, up);
     }
 
+    // Macierz widoku z kamerą w początku układu - do rysowania współrzędnych względnych (pozycja - kamera)
+    glm::mat4 getRelativeViewMatrix() const {
+        glm::vec3 direction = glm::normalize(front);
+
+        return glm::lookAt(glm::vec3(0.0f), direction * 1000.0f, up);
+    }
+
     glm::mat4 getProjectionMatrix(float aspect) const {
         if (!this->ortho)
             return glm::perspective(glm::radians(Fov), aspect, 0.1f, this->drawDistance);
@@ -231,6 +259,10 @@ public:
         this->position = pos;
     }
 
+    virtual glm::dvec3 getWorldPosition() const {
+        return glm::dvec3(this->position);
+    }
+
     float getDrawDistance(float aspect = 1.0f) const {
         if (!this->ortho) return this->drawDistance;
 
@@ -317,19 +349,22 @@ protected:
 
 class EarthCamera : public Camera {
 public:
-    float  latitudeAngle = 0.0f, 
-          longitudeAngle = 0.0f,
-               elevation = 300.0f;
+    double  latitudeAngle = 0.0, 
+           longitudeAngle = 0.0;
+    float       elevation = 300.0f;
+
+    // Pozycja w świecie w podwójnej precyzji (Camera::position to jej kopia we float)
+    glm::dvec3 worldPosition = glm::dvec3(0.0);
     
-    float earthCenterDistance = 637800.0;
+    double earthCenterDistance = 637800.0;
 public:
     EarthCamera(float lonAngle = 0.0f, float latAngle = 0.0f, float hAngle = 0.0f, float vAngle = 0.0f, float elevation = 300.0f)    
         : Camera(glm::vec3(0.0f), hAngle, vAngle) {
             if (glm::abs(latAngle) >  90.0f) throw std::invalid_argument( "Latitude angle of camera must be in [-90, 90] range.");
             if (glm::abs(lonAngle) > 180.0f) throw std::invalid_argument("Longitude angle of camera must be in [-180, 180] range.");
 
-            this->latitudeAngle  = glm::radians( latAngle );
-            this->longitudeAngle = glm::radians( lonAngle );
+            this->latitudeAngle  = glm::radians( (double)latAngle );
+            this->longitudeAngle = glm::radians( (double)lonAngle );
             this->elevation = elevation;
 
             this->moveModifier = 1000.0f;
@@ -342,13 +377,17 @@ public:
     }
 
     void setPosition(glm::vec3 const& pos) override {
-        this->longitudeAngle = glm::radians(pos.x);
-        this->latitudeAngle  = glm::radians(pos.y);
+        this->longitudeAngle = glm::radians((double)pos.x);
+        this->latitudeAngle  = glm::radians((double)pos.y);
         this->elevation      = pos.z;
 
         calculateVectors();
     }
 
+    glm::dvec3 getWorldPosition() const override {
+        return this->worldPosition;
+    }
+
     glm::vec3 getMoveVector(glm::vec3 const& offset, bool useUpVector = false) const override {
         glm::vec3 moveVec = offset.x * right + offset.y * front;
 
@@ -356,11 +395,11 @@ public:
     }
     
     void move(glm::vec3 const& moveVector) override {
-        this->position += moveVector * this->moveModifier;
+        this->worldPosition += glm::dvec3(moveVector) * (double)this->moveModifier;
 
-        double radius = glm::length(this->position);
-        this->longitudeAngle = std::atan( (double)position.z / position.x );
-        this->latitudeAngle  = std::asin( (double)position.y / radius );
+        double radius = glm::length(this->worldPosition);
+        this->longitudeAngle = std::atan( worldPosition.z / worldPosition.x );
+        this->latitudeAngle  = std::asin( worldPosition.y / radius );
 
         float dLat = PI * (this->latitudeAngle > 0 ? 1 : -1);
         while (glm::abs(this->latitudeAngle) > PI / 2.0f) this->latitudeAngle -= dLat;
@@ -376,13 +415,14 @@ public:
     }
 protected:
     void calculateVectors() override {
-        position = glm::vec3(
+        worldPosition = glm::dvec3(
             (earthCenterDistance + elevation) * cos(latitudeAngle) * cos(longitudeAngle),
             (earthCenterDistance + elevation) * sin(latitudeAngle),                                    
             (earthCenterDistance + elevation) * cos(latitudeAngle) * sin(longitudeAngle) 
         );
+        position = glm::vec3(worldPosition);
 
-        up = glm::normalize(position);
+        up = glm::vec3( glm::normalize(worldPosition) );
         
         glm::vec3 baseDirection = glm::vec3(
             cos(verticalAngle) * cos(Yaw),
@@ -458,6 +498,13 @@ public:
         fps_counter          = config.getValue("fps_counter");
         lower_draw_distance  = config.getValue("lower_draw_distance");
         enable_mouse         = config.getValue("enable_mouse");
+        stream_tiles         = config.getValue("stream_tiles");
+        prefetch_tiles       = config.getValue("prefetch_tiles");
+        fill_holes           = config.getValue("fill_holes");
+        huge_pages           = config.getValue("huge_pages");
+        brick_layout         = config.getValue("brick_layout");
+        soft_render          = config.getValue("soft_render");
+        adaptive_mesh        = config.getValue("adaptive_mesh");
 
         if (raw_mouse_input && glfwRawMouseMotionSupported())
             glfwSetInputMode(win(), GLFW_RAW_MOUSE_MOTION, GLFW_TRUE);
@@ -467,6 +514,10 @@ public:
         this->startingPositionSet = true;
     }
     void MainLoop();
+    void Benchmark(std::string const& name);
+    bool Render(std::string const& list);
+    void Serve(int port);
+    bool Export(std::string const& path, float error, MeshProjection projection);
 private:
     // settings
     float move     = 0.25;
@@ -479,7 +530,7 @@ private:
 
     // config
     Config config;
-    bool debug, resize_mode, raw_mouse_input, fps_counter, lower_draw_distance, enable_mouse;
+    bool debug, resize_mode, raw_mouse_input, fps_counter, lower_draw_distance, enable_mouse, stream_tiles, prefetch_tiles, fill_holes, huge_pages, brick_layout, soft_render, adaptive_mesh;
     
     // game state
     glm::vec3 position;
@@ -513,6 +564,12 @@ void MyGame::MainLoop() {
     t.setLimits(min, max);
     
     t.setPath( this->base_path );
+    t.setStreaming( this->stream_tiles );
+    t.setPrefetch( this->prefetch_tiles );
+    t.setHoleFilling( this->fill_holes );
+    t.setHugePages( this->huge_pages );
+    t.setBrickLayout( this->brick_layout );
+    t.setMeshError( this->adaptive_mesh ? RtinBuilder::DEFAULT_ERROR : 0.0f );
     t.loadAllTiles();
 
     if (!this->startingPositionSet)
@@ -544,12 +601,24 @@ void MyGame::MainLoop() {
     MySphere earthSurface;
     earthSurface.center = glm::vec3(0.0f, 0.0f, 0.0f);
 
+    Viewshed viewshed(t);
+    TerrainAnalysis analysis(t);
+    ContourLayer contours;
+    GpuFrameTimer gpuTimer;
+
     unsigned int frames = 0, framesSinceLodChange = 0;
+    bool firstFrameShown = false;           // frames zerowane co sekundę (licznik FPS)
 
     glm::mat4 viewMatrix, projectionMatrix;
+    glm::dvec3 eye;
     glm::vec3 moveVector;
 
-    bool t_pressed = false, z_pressed = false, i_pressed = false, n_pressed = false, tab_pressed = false;
+    // Prędkość kamery (stopnie/s) z przesunięć pozycji między klatkami, wygładzona
+    glm::vec3 lastPosition = this->position;
+    glm::vec2 velocity = glm::vec2(0.0f);
+    float drawDistance;
+
+    bool t_pressed = false, z_pressed = false, i_pressed = false, n_pressed = false, tab_pressed = false, v_pressed = false, h_pressed = false, o_pressed = false, m_pressed = false, k_pressed = false, j_pressed = false, g_pressed = false;
     float acc = 1.0, movementSpeed = 1.0f, lastLodChange = 0.0f;
     unsigned short new_lod = this->lod;
     Camera *currentCam = &mainCam;
@@ -616,6 +685,7 @@ void MyGame::MainLoop() {
             this->autoLOD = false;
         }
 
+        gpuTimer.begin();
         glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
 
         AGLErrors("main-loopbegin");
@@ -626,29 +696,62 @@ void MyGame::MainLoop() {
 
         currentCam = this->in3DMode ? &earthCam : &mainCam;
 
-        viewMatrix       = currentCam->getViewMatrix();
+        // W 3D rysujemy względem kamery (pozycje liczone w podwójnej precyzji na CPU)
+        eye              = this->in3DMode ? currentCam->getWorldPosition() : glm::dvec3(0.0);
+        viewMatrix       = this->in3DMode ? currentCam->getRelativeViewMatrix() : currentCam->getViewMatrix();
         projectionMatrix = currentCam->getProjectionMatrix( (resize_mode ? 1/aspect : 1.0f) );
 
-        t.draw(viewMatrix, projectionMatrix, this->position, currentCam->getDrawDistance( (resize_mode ? 1/aspect : 1.0f) ) * (this->lower_draw_distance ? 0.3f : 1.0f) );
+        drawDistance     = currentCam->getDrawDistance( (resize_mode ? 1/aspect : 1.0f) ) * (this->lower_draw_distance ? 0.3f : 1.0f);
+
+        if (deltaTime > 0.0)
+            velocity = glm::mix( velocity, glm::vec2(this->position - lastPosition) / (float)deltaTime, 0.2f );
+        lastPosition = this->position;
+
+        t.update(this->position, velocity, drawDistance);
+        t.draw(viewMatrix, projectionMatrix, this->position, eye, drawDistance);
+
+        // Warstwice tylko w 2D, na kaflach (nie na piramidzie przeglądowej)
+        if (contours.isEnabled() && !this->in3DMode && t.getOverviewLevel() < 0) {
+            if (contours.update( t.getTilesInRange(this->position, drawDistance * 1.2f) )) {
+                ContourStats const& cs = contours.getStats();
+                printf("Warstwice co %.0f m: %zu kafli (%zu nowych, %u wątków)  -  śledzenie %8.2f ms (suma %8.2f ms), łączenie %6.2f ms  -  %zu linii, %zu punktów\n",
+                            contours.getCache().getGeometryInterval(), cs.tiles, cs.traced, cs.threads, cs.trace_ms, cs.tile_ms, cs.stitch_ms, cs.lines, cs.points);
+            }
+            contours.draw(viewMatrix, projectionMatrix, t.getXCondensation());
+        }
         
-        earthSurface.draw(viewMatrix, projectionMatrix);
+        earthSurface.draw(viewMatrix, projectionMatrix, eye);
 
+        gpuTimer.end();
         AGLErrors("main-afterdraw");
 
         glfwSwapBuffers(win()); // =============================   Swap buffers
         glfwPollEvents();
 
+        if (!firstFrameShown) {
+            firstFrameShown = true;
+            glFinish();
+            printf("Pierwsza klatka:                 %.0f ms od uruchomienia (TileManager %.1f ms, w tym indeksy %.1f ms)\n",
+                std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - launchTime).count(), t.getInitTimeMs(), t.getIndexTimeMs());
+        }
+
         // =====================================================        Steering
 
         // FPS counter
         if ( fps_counter && currentTime - lastSecondTime >= 1.0 ) { // If last prinf() was more than 1 sec ago
             // printf and reset timer
-            printf("%4d FPS  -  %5.1f mil. triangles  -  %8.4f ms/frame  -  LOD: %d%s\n", 
+            printf("%4d FPS  -  %5.1f mil. triangles  -  %8.4f ms/frame  -  GPU: %8.4f ms  -  VRAM: %u/%u tiles  -  LOD: %d%s%s%s%s\n", 
                         frames, 
                         t.getTriangleCount() / 1000000.0, 
                         fh.mean(), 
+                        gpuTimer.getMs(),
+                        t.getGpuResidentTiles(),
+                        t.getLoadedTiles(),
                         t.getLod(),
-                        this->autoLOD ? std::string(" (Automatic)").c_str() : std::string("").c_str()
+                        this->autoLOD ? std::string(" (Automatic)").c_str() : std::string("").c_str(),
+                        t.getHillshade() ? std::string("  -  Hillshade").c_str() : std::string("").c_str(),
+                        t.getOverviewLevel() >= 0 ? ("  -  Overview: " + std::to_string(1 << t.getOverviewLevel()) + " deg").c_str() : "",
+                        t.isStreaming() ? ("  -  Stalls: " + std::to_string(t.getLoadStalls()) + ", prefetched: " + std::to_string(t.getTilesPrefetched())).c_str() : ""
                 );
             frames = 0;
             lastSecondTime += 1.0;
@@ -718,6 +821,56 @@ void MyGame::MainLoop() {
         if ( glfwGetKey( win(), GLFW_KEY_I ) == GLFW_PRESS && !i_pressed ) {     // I -> ??
             i_pressed = true;
         } else if (glfwGetKey( win(), GLFW_KEY_I ) == GLFW_RELEASE && i_pressed) i_pressed = false;
+        if ( glfwGetKey( win(), GLFW_KEY_V ) == GLFW_PRESS && !v_pressed ) {     // V -> Analiza widoczności z bieżącej pozycji
+            v_pressed = true;
+
+            ViewshedResult vs = viewshed.compute( this->position.x, this->position.y );
+            t.setOverlay( vs.mask, vs.cols, vs.rows, vs.getOverlayBounds() );
+
+            printf("Widoczność: %d x %d komórek, %u widocznych  -  %8.2f ms (%u wątków)\n", 
+                        vs.cols, vs.rows, vs.countVisible(), vs.computeTimeMs, vs.threads);
+        } else if (glfwGetKey( win(), GLFW_KEY_V ) == GLFW_RELEASE && v_pressed) v_pressed = false;
+        if ( glfwGetKey( win(), GLFW_KEY_B ) == GLFW_PRESS ) {                   // B -> Ukryj nakładkę
+            t.clearOverlay();
+        }
+        if ( glfwGetKey( win(), GLFW_KEY_G ) == GLFW_PRESS && !g_pressed ) {     // G -> Nachylenie / ekspozycja / szorstkość wokół pozycji
+            g_pressed = true;
+
+            OverlayKind kind = t.getOverlayKind();
+            if (kind == OverlayKind::Ruggedness) {
+                t.clearOverlay();
+            } else {
+                TerrainMeasure measure = kind == OverlayKind::Slope  ? TerrainMeasure::Aspect
+                                       : kind == OverlayKind::Aspect ? TerrainMeasure::Ruggedness
+                                       :                               TerrainMeasure::Slope;
+
+                TerrainRaster tr = analysis.computeRegion( this->position.x - 1.0, this->position.y - 1.0, this->position.x + 1.0, this->position.y + 1.0, measure );
+                t.setOverlay( tr.toOverlay(), tr.cols, tr.rows, tr.getOverlayBounds(), tr.getOverlayKind() );
+
+                printf("Analiza rzeźby (%s): %d x %d wartości z %zu kafli  -  %8.2f ms (%u wątków%s)\n",
+                            TerrainRaster::getName(measure), tr.cols, tr.rows, tr.tiles, tr.computeTimeMs, tr.threads, analysis.isVectorized() ? ", SSE2" : "");
+            }
+        } else if (glfwGetKey( win(), GLFW_KEY_G ) == GLFW_RELEASE && g_pressed) g_pressed = false;
+        if ( glfwGetKey( win(), GLFW_KEY_H ) == GLFW_PRESS && !h_pressed ) {     // H -> Włącz/wyłącz cieniowanie rzeźby
+            h_pressed = true;
+            t.setHillshade( !t.getHillshade() );
+        } else if (glfwGetKey( win(), GLFW_KEY_H ) == GLFW_RELEASE && h_pressed) h_pressed = false;
+        if ( glfwGetKey( win(), GLFW_KEY_O ) == GLFW_PRESS && !o_pressed ) {     // O -> Włącz/wyłącz piramidę przeglądową (2D)
+            o_pressed = true;
+            t.setOverview( !t.getOverview() );
+        } else if (glfwGetKey( win(), GLFW_KEY_O ) == GLFW_RELEASE && o_pressed) o_pressed = false;
+        if ( glfwGetKey( win(), GLFW_KEY_M ) == GLFW_PRESS && !m_pressed ) {     // M -> Pokaż/ukryj wypełnione braki danych
+            m_pressed = true;
+            t.setFillMaskVisible( !t.getFillMaskVisible() );
+        } else if (glfwGetKey( win(), GLFW_KEY_M ) == GLFW_RELEASE && m_pressed) m_pressed = false;
+        if ( glfwGetKey( win(), GLFW_KEY_K ) == GLFW_PRESS && !k_pressed ) {     // K -> Pokaż/ukryj warstwice (2D)
+            k_pressed = true;
+            contours.setEnabled( !contours.isEnabled() );
+        } else if (glfwGetKey( win(), GLFW_KEY_K ) == GLFW_RELEASE && k_pressed) k_pressed = false;
+        if ( glfwGetKey( win(), GLFW_KEY_J ) == GLFW_PRESS && !j_pressed ) {     // J -> Następny odstęp warstwic
+            j_pressed = true;
+            contours.nextInterval();
+        } else if (glfwGetKey( win(), GLFW_KEY_J ) == GLFW_RELEASE && j_pressed) j_pressed = false;
         
         // USER LOD
         if ( glfwGetKey( win(), GLFW_KEY_1 ) == GLFW_PRESS ) {
@@ -815,9 +968,1560 @@ void MyGame::MainLoop() {
              glfwWindowShouldClose(win()) == 0 );
 }
 
+// ==========================================================================
+// Obrazy 2D obszarów z listy w pliku, bez pętli głównej (parametr -render <plik>);
+// false - błąd listy, rysowania lub zapisu któregoś obrazu
+// ==========================================================================
+bool MyGame::Render(std::string const& list) {
+    std::vector<RenderJob> jobs;
+    try {
+        jobs = readRenderJobs(list);
+    } catch (const std::exception& e) {
+        std::cerr << "Błąd listy obrazów: " << e.what() << "\n";
+        return false;
+    }
+    if (jobs.empty()) {
+        std::cerr << "Brak obrazów do narysowania w " << list << "\n";
+        return false;
+    }
+
+    TileManager t;
+
+    t.setLimits(min, max);
+    t.setPath( this->base_path );
+    t.setHoleFilling( this->fill_holes );
+    t.setHugePages( this->huge_pages );
+    t.setBrickLayout( this->brick_layout );
+    t.setMeshError( this->adaptive_mesh ? RtinBuilder::DEFAULT_ERROR : 0.0f );
+    t.loadAllTiles();
+
+    // Rysowanie na CPU (SoftRasterizer), zapis jak w MapRenderer
+    if (this->soft_render) {
+        SoftRasterizer rasterizer;
+        ImageWriter writer;
+        double pixels = 0.0;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (RenderJob const& job : jobs) {
+            glm::mat4 projection;
+            glm::vec3 center;
+            float drawDistance;
+            renderJobView(job, t.getXCondensation(), projection, center, drawDistance);
+
+            rasterizer.resize(job.width, job.height);
+            rasterizer.draw(t, glm::mat4(1.0f), projection, center, glm::dvec3(0.0), drawDistance);
+            writer.write(job.output, job.width, job.height, rasterizer.getImage());
+
+            pixels += (double)job.width * job.height;
+        }
+        writer.finish();
+        double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+        printf("Obrazy (CPU, wątki: %u): %u / %zu zapisanych, %.3f s, %.2f obrazów/s, %.2f Mpx/s\n",
+            rasterizer.getThreads(), (unsigned int)jobs.size() - writer.getFailed(), jobs.size(), seconds, jobs.size() / seconds, pixels / 1e6 / seconds);
+        return writer.getFailed() == 0;
+    }
+
+    MapRenderer renderer(t);
+    unsigned int written;
+
+    try {
+        written = renderer.render(jobs);
+    } catch (const std::exception& e) {
+        std::cerr << "Błąd rysowania obrazów: " << e.what() << "\n";
+        return false;
+    }
+
+    printf("Obrazy: %u / %zu zapisanych, %.3f s, %.2f obrazów/s, %.2f Mpx/s (oczekiwanie na odczyt %.1f ms)\n",
+        written, jobs.size(), renderer.getSeconds(), jobs.size() / renderer.getSeconds(),
+        renderer.getPixels() / 1e6 / renderer.getSeconds(), renderer.getReadbackWaitMs());
+    return written == jobs.size();
+}
+
+// ==========================================================================
+// Serwer kafli XYZ na 127.0.0.1 (parametr -serve <port>), działa do Ctrl+C
+// ==========================================================================
+static std::atomic<bool> serve_stopping{ false };
+
+void MyGame::Serve(int port) {
+#if defined(_WIN32)
+    std::cerr << "Serwer kafli nie jest dostępny na tej platformie.\n";
+#else
+    TileManager t;
+
+    // Bez trybu strumieniowego - wątki serwera czytają kafle bez synchronizacji z ładowaniem
+    t.setLimits(min, max);
+    t.setPath( this->base_path );
+    t.setHoleFilling( this->fill_holes );
+    t.setHugePages( this->huge_pages );
+    t.setBrickLayout( this->brick_layout );
+    t.setMeshError( this->adaptive_mesh ? RtinBuilder::DEFAULT_ERROR : 0.0f );
+    t.loadAllTiles();
+
+    MapRenderer renderer(t);
+    TileServer server(t, renderer);
+
+    try {
+        server.start(port);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return;
+    }
+
+    printf("Serwer kafli: http://127.0.0.1:%d/terrain/{z}/{x}/{y}.png, /map/{z}/{x}/{y}.png, /stats (Ctrl+C - koniec)\n", server.getPort());
+
+    std::signal(SIGINT,  [](int) { serve_stopping = true; });
+    std::signal(SIGTERM, [](int) { serve_stopping = true; });
+
+    // Rysowanie map w wątku kontekstu OpenGL
+    while (!serve_stopping) server.pump(std::chrono::milliseconds(50));
+    server.stop();
+
+    TileServerStats stats = server.getStats();
+    printf("Serwer kafli: %zu żądań kafli, %zu trafień w pamięci podręcznej, %zu połączonych, %zu policzonych, %zu błędów\n",
+        stats.requests, stats.hits, stats.coalesced, stats.computed, stats.errors);
+#endif
+}
+
+// ==========================================================================
+// Siatka terenu obszaru do pliku (parametr -export <plik> <błąd> [geo|2d|3d]), bez pętli głównej
+// ==========================================================================
+bool MyGame::Export(std::string const& path, float error, MeshProjection projection) {
+    TileManager t;
+
+    // Bez loadAllTiles - kafle wczytywane kolejno przez MeshExporter
+    t.setLimits(min, max);
+    t.setPath( this->base_path );
+    t.setHoleFilling( this->fill_holes );
+    t.setHugePages( this->huge_pages );
+
+    MeshExporter exporter(t);
+    exporter.setError(error);
+    exporter.setProjection(projection);
+
+    try {
+        MeshExportStats stats = exporter.write(path);
+
+        printf("Eksport siatki:   %zu kafli, %zu wierzchołków (%zu połączonych na krawędziach), %zu trójkątów, %.1f MB\n",
+            stats.tiles, stats.vertices, stats.welded, stats.triangles, stats.bytes / 1048576.0);
+        printf("                  %.2f s, %.1f kafli/s, %.2f mln trójkątów/s, %.1f MB/s\n",
+            stats.ms / 1000.0, stats.tiles * 1000.0 / stats.ms, stats.triangles / 1000.0 / stats.ms, stats.bytes / 1048576.0 * 1000.0 / stats.ms);
+#if defined(__linux__)
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        printf("                  szczytowa pamięć procesu (RSS) %.1f MB\n", usage.ru_maxrss / 1024.0);
+#endif
+    } catch (const std::exception& e) {
+        std::cerr << "Błąd eksportu siatki: " << e.what() << "\n";
+        return false;
+    }
+    return true;
+}
+
+// ==========================================================================
+// Benchmarks (uruchamiane zamiast pętli głównej, parametr -bench <nazwa>)
+// ==========================================================================
+void MyGame::Benchmark(std::string const& name) {
+    auto elapsedMs = [](std::chrono::high_resolution_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    };
+    // Błędy stron procesu bez odczytu z dysku (tylko Linux)
+    auto pageFaults = []() -> long {
+#if defined(__linux__)
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_minflt;
+#else
+        return 0;
+#endif
+    };
+
+    if (name == "prefetch") {
+        // Szybki przelot 3D po zapisanej trasie (z zakrętem) w czasie rzeczywistym, 60 klatek/s:
+        // ładowanie kafli na żądanie i z przewidywaniem na podstawie prędkości
+        const float fps = 60.0f, speed = 1.5f, drawDistance = 15000.0f;
+
+        glfwHideWindow(win());
+
+        for (int mode = 0; mode < 2; mode++) {
+            TileManager t;
+
+            t.setLimits(min, max);
+            t.setPath( this->base_path );
+            t.setStreaming(true);
+            t.setPrefetch(mode == 1);
+            t.loadAllTiles();
+            t.set3DProjection(true);
+
+            glm::vec2 center( t.getCenter().longitude.toFloat(), t.getCenter().latitude.toFloat() );
+
+            // Trasa: na wschód, a potem na północ
+            std::vector<glm::vec2> route = {
+                { center.x - 4.0f, center.y - 1.5f }, { center.x + 3.0f, center.y - 1.5f }, { center.x + 3.0f, center.y + 2.0f }
+            };
+
+            glm::vec3 position( route[0], 1000.0f ), lastPosition = position;
+            glm::vec2 velocity(0.0f);
+            size_t leg = 0;
+            double worstMs = 0.0, totalMs = 0.0;
+            unsigned int frames = 0;
+
+            auto frameStart = std::chrono::high_resolution_clock::now();
+            while (leg + 1 < route.size()) {
+                glm::vec2 to = route[leg + 1] - glm::vec2(position);
+                float step = frames < fps ? 0.0f : speed / fps;        // Sekunda zawisu na starcie
+
+                if (glm::length(to) <= step) leg++;
+                position += glm::vec3( glm::length(to) > 0.0f ? glm::normalize(to) * std::min(step, glm::length(to)) : glm::vec2(0.0f), 0.0f );
+
+                velocity = glm::mix( velocity, glm::vec2(position - lastPosition) * fps, 0.2f );
+                lastPosition = position;
+
+                auto start = std::chrono::high_resolution_clock::now();
+                t.update(position, velocity, drawDistance);
+                double ms = elapsedMs(start);
+
+                // Pierwsza klatka to wczytanie kafli wokół pozycji startowej
+                if (frames > 0) worstMs = std::max(worstMs, ms);
+                totalMs += ms;
+                frames++;
+
+                std::this_thread::sleep_until( frameStart + std::chrono::microseconds( (long)(frames * 1e6 / fps) ) );
+            }
+
+            printf("  %-22s %3u przestojów, %3u kafli w tle, %3u anulowanych  -  update: śr. %7.3f ms, maks. %8.3f ms\n",
+                mode == 1 ? "Z przewidywaniem:" : "Na żądanie:", t.getLoadStalls(), t.getTilesPrefetched(), t.getPrefetchCancelled(), totalMs / frames, worstMs);
+        }
+        return;
+    }
+
+    if (name == "index") {
+        // Wyszukiwanie dostępnych kafli: dawne dwukrotne przeglądanie katalogu z parsowaniem nazw
+        // przez wyjątki, budowa indeksu i jego wczytanie z pliku .tileindex
+        const int repeats = 20;
+        TileIndex index;
+        unsigned int count = 0;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int r = 0; r < repeats; r++) {
+            count = std::distance(std::filesystem::directory_iterator(this->base_path), std::filesystem::directory_iterator{});
+            count = 0;
+
+            for (auto const& entry : std::filesystem::directory_iterator(this->base_path)) {
+                try {
+                    Tile::decodeTileNameString( entry.path().stem().string() );
+                    count++;
+                } catch (const std::exception& e) {
+                    continue;
+                }
+            }
+        }
+        double scanMs = elapsedMs(start) / repeats;
+
+        start = std::chrono::high_resolution_clock::now();
+        for (int r = 0; r < repeats; r++) index.open(this->base_path, true);
+        double rebuildMs = elapsedMs(start) / repeats;
+
+        bool cached = true;
+        start = std::chrono::high_resolution_clock::now();
+        for (int r = 0; r < repeats; r++) cached = index.open(this->base_path) && cached;
+        double openMs = elapsedMs(start) / repeats;
+
+        // Zapytanie o obszar 2 x 2 stopnie
+        unsigned int hits = 0;
+        start = std::chrono::high_resolution_clock::now();
+        for (int r = 0; r < repeats * 1000; r++) {
+            for (short lat = 50; lat < 52; lat++)
+                for (short lon = 19; lon < 21; lon++)
+                    hits += index.find(lat, lon) != nullptr;
+        }
+        double queryUs = elapsedMs(start) * 1000.0 / (repeats * 1000);
+
+        printf("Indeks kafli: %zu kafli (%u nazw w katalogu pasuje do schematu)\n", index.size(), count);
+        printf("  Przeglądanie katalogu (dawne):  %9.3f ms\n", scanMs);
+        printf("  Budowa indeksu:                 %9.3f ms\n", rebuildMs);
+        printf("  Wczytanie indeksu:              %9.3f ms%s\n", openMs, cached ? "" : "  (plik nieaktualny lub niezapisany)");
+        printf("  Obszar 2 x 2:                   %9.3f us  (%u trafień)\n", queryUs, hits / (repeats * 1000));
+        return;
+    }
+
+    if (name == "holes") {
+        // Wypełnianie braków danych przy odczycie: koszt na kafel (sekwencyjnie), odczyt wszystkich
+        // kafli w puli TileLoader bez i z wypełnianiem oraz błąd wypełnienia sztucznych dziur
+        TileIndex index;
+        index.open(this->base_path);
+        Tile::path = this->base_path;
+
+        std::vector<Coordinates> origins;
+        for (auto const& [key, entry] : index.getEntries()) origins.push_back( Coordinates(entry.latitude, entry.longitude) );
+
+        Heights heights;
+        double decodeMs = 0.0, fillMs = 0.0, worstMs = 0.0;
+        unsigned int withHoles = 0, filled = 0;
+
+        for (Coordinates const& origin : origins) {
+            auto start = std::chrono::high_resolution_clock::now();
+            int samples = Tile::decode(origin, heights);
+            decodeMs += elapsedMs(start);
+
+            HoleFill fill;
+            Tile::fillHoles(origin, heights, samples, fill);
+            fillMs += fill.ms;
+
+            if (fill.filled > 0) {
+                withHoles++;
+                filled += fill.filled;
+                worstMs = std::max(worstMs, (double)fill.ms);
+            }
+        }
+
+        printf("Wypełnianie braków: %zu kafli, %u z brakami, %u próbek wypełnionych\n", origins.size(), withHoles, filled);
+        printf("  Odczyt kafla:                   %9.3f ms/kafel\n", decodeMs / origins.size());
+        printf("  Wyszukanie i wypełnienie:       %9.3f ms/kafel, maks. %.3f ms\n", fillMs / origins.size(), worstMs);
+
+        for (int mode = 0; mode < 2; mode++) {
+            TileLoader pool( std::max(1u, std::thread::hardware_concurrency()) );
+            std::vector<TileRequest> requests;
+            for (Coordinates const& origin : origins) requests.push_back( TileRequest{ origin.getTileString(), origin, (float)requests.size(), -1.0f, mode == 1 } );
+
+            auto start = std::chrono::high_resolution_clock::now();
+            pool.request(requests);
+
+            size_t received = 0;
+            while (received < requests.size()) received += pool.collect(true).size();
+
+            printf("  Pula %2u wątków, %-15s %9.3f ms (%zu kafli)\n", std::max(1u, std::thread::hardware_concurrency()),
+                mode == 1 ? "z wypełnianiem:" : "bez wypełniania:", elapsedMs(start), origins.size());
+        }
+
+        // Sztuczne kwadratowe dziury w środku kafla bez braków - błąd względem oryginału
+        for (Coordinates const& origin : origins) {
+            int samples = Tile::decode(origin, heights);
+
+            HoleFill fill;
+            Heights original = heights;
+            Tile::fillHoles(origin, heights, samples, fill);
+            if (fill.filled > 0) continue;
+
+            printf("  Sztuczne dziury w %s:\n", origin.getTileString().c_str());
+
+            for (int size : { 8, 32, 128 }) {
+                heights = original;
+                int first = samples / 2 - size / 2;
+
+                for (int i = first; i < first + size; i++)
+                    for (int j = first; j < first + size; j++)
+                        heights[ Tile::texelIndex(i, j, samples) ] = Tile::NO_DATA;
+
+                Tile::fillHoles(origin, heights, samples, fill);
+
+                double sum = 0.0, worst = 0.0;
+                for (int i = first; i < first + size; i++) {
+                    for (int j = first; j < first + size; j++) {
+                        size_t k = Tile::texelIndex(i, j, samples);
+                        double err = std::abs(heights[k] - original[k]);
+
+                        sum += err * err;
+                        worst = std::max(worst, err);
+                    }
+                }
+
+                printf("    %3d x %-3d  RMS %7.2f m, maks. %7.2f m, %8.3f ms\n", size, size, std::sqrt(sum / (size * size)), worst, fill.ms);
+            }
+            break;
+        }
+        return;
+    }
+
+    if (name == "pool") {
+        // Cykle wczytania i usunięcia kafli jak przy locie w trybie strumieniowym (w pamięci
+        // najwyżej `window` kafli): alokacje wysokości na stercie i w puli slabów
+        const size_t window = 8;
+        const int passes = 3;
+
+        TileIndex index;
+        index.open(this->base_path);
+        Tile::path = this->base_path;
+
+        std::vector<Coordinates> origins;
+        for (auto const& [key, entry] : index.getEntries()) origins.push_back( Coordinates(entry.latitude, entry.longitude) );
+
+        HeightPool& pool = HeightPool::instance();
+        bool wasEnabled = pool.isEnabled(), hadHugePages = pool.getHugePages();
+        printf("Pula wysokości: %zu kafli, %d przejść, w pamięci najwyżej %zu kafli\n", origins.size(), passes, window);
+
+        for (int mode = 0; mode < 3; mode++) {
+            pool.trim();
+            pool.setEnabled(mode > 0);
+            pool.setHugePages(mode == 2);
+            pool.resetPeak();
+
+            HeightPoolStats before = pool.getStats();
+            std::deque<Heights> resident;
+            double allocMs = 0.0;
+            long faults = pageFaults();
+            unsigned int loads = 0;
+
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int pass = 0; pass < passes; pass++) {
+                for (Coordinates const& origin : origins) {
+                    // Alokacja razem z pierwszym zapisem (błędy stron), decode nie zmienia już rozmiaru
+                    auto alloc = std::chrono::high_resolution_clock::now();
+                    Heights heights((size_t)Tile::BLOCK * Tile::BLOCK);
+                    allocMs += elapsedMs(alloc);
+
+                    Tile::decode(origin, heights);
+                    resident.push_back( std::move(heights) );
+                    loads++;
+
+                    if (resident.size() > window) resident.pop_front();
+                }
+            }
+            resident.clear();
+            double totalMs = elapsedMs(start);
+            faults = pageFaults() - faults;
+
+            HeightPoolStats stats = pool.getStats();
+            printf("  %-22s alokacja %7.3f ms/kafel, całość %8.1f ms, %8.1f błędów stron/kafel",
+                mode == 0 ? "Sterta:" : mode == 1 ? "Pula:" : "Pula, duże strony:", allocMs / loads, totalMs, (double)faults / loads);
+            if (mode > 0)
+                printf(", szczyt %.1f MB, %u slabów nowych, %u ponownie", stats.peak / 1048576.0, stats.mapped - before.mapped, stats.reused - before.reused);
+            printf("\n");
+        }
+
+        pool.setEnabled(wasEnabled);
+        pool.setHugePages(hadHugePages);
+        return;
+    }
+
+    if (name == "layout") {
+        // Wzorce dostępu do wysokości na CPU w układzie bloków (wierszami) i cegiełek 32 x 32:
+        // zapytania w losowych punktach, profil, normalne (wierszami i kolumnami), promienie
+        const int repeats = 3;
+        double results[2][6], checksums[2][6];
+
+        for (int mode = 0; mode < 2; mode++) {
+            Tile::brick_layout = mode == 1;
+
+            TileManager m;
+            m.setLimits(min, max);
+            m.setPath( this->base_path );
+            m.setHoleFilling( false );
+
+            auto start = std::chrono::high_resolution_clock::now();
+            m.loadAllTiles();
+            results[mode][0] = elapsedMs(start);
+            checksums[mode][0] = 0.0;
+
+            std::vector<Tile const*> loaded;
+            for (auto const& [key, entry] : m.getIndex().getEntries()) {
+                if (Tile const* tile = m.findTile(entry.latitude, entry.longitude)) loaded.push_back(tile);
+            }
+            std::sort(loaded.begin(), loaded.end(), [](Tile const* a, Tile const* b) { return a->origin.getTileString() < b->origin.getTileString(); });
+
+            Coordinates center = m.getCenter();
+            double lon = center.longitude.toFloat(), lat = center.latitude.toFloat();
+
+            for (int pattern = 1; pattern < 6; pattern++) {
+                double checksum = 0.0;
+                start = std::chrono::high_resolution_clock::now();
+
+                for (int r = 0; r < repeats; r++) {
+                    std::mt19937 random(7);
+                    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+                    if (pattern == 1) {
+                        // Zapytania o wysokość w losowych punktach
+                        for (int q = 0; q < 1000000; q++) {
+                            Tile const* tile = loaded[ random() % loaded.size() ];
+                            double y = unit(random), x = unit(random);
+                            checksum += tile->getHeightInterpolated(y, x);
+                        }
+                    } else if (pattern == 2) {
+                        // Profil przez kilka kafli, co ~3"
+                        std::vector<glm::dvec2> polyline = { { lon - 1.5, lat - 1.0 }, { lon - 0.5, lat + 0.8 }, { lon + 0.5, lat - 0.8 }, { lon + 1.5, lat + 1.0 } };
+                        std::vector<ProfileSample> buffer(4096);
+                        ProfileCursor cursor(polyline, 30.0);
+                        size_t n;
+
+                        while ((n = m.getProfile(cursor, buffer.data(), buffer.size())) > 0) {
+                            for (size_t k = 0; k < n; k++) checksum += buffer[k].height;
+                        }
+                    } else if (pattern == 3 || pattern == 4) {
+                        // Normalne (różnice centralne w oknie 3 x 3) dla wszystkich próbek kilku kafli,
+                        // przejście wierszami lub kolumnami
+                        float window[9];
+                        for (size_t k = 0; k < std::min<size_t>(8, loaded.size()); k++) {
+                            int last = loaded[k]->getSamples() - 1;
+
+                            for (int a = 0; a <= last; a++) {
+                                for (int b = 0; b <= last; b++) {
+                                    int i = pattern == 3 ? a : b, j = pattern == 3 ? b : a;
+                                    loaded[k]->getWindow(i, j, window);
+
+                                    glm::vec3 normal = glm::normalize( glm::vec3( (window[3] - window[5]) / 60.0f, (window[1] - window[7]) / 90.0f, 1.0f ) );
+                                    checksum += normal.z;
+                                }
+                            }
+                        }
+                    } else {
+                        // Promienie z losowych punktów w losowych kierunkach, krok jednej próbki,
+                        // do wyjścia z kafla lub przecięcia z terenem
+                        for (int q = 0; q < 20000; q++) {
+                            Tile const* tile = loaded[ random() % loaded.size() ];
+                            int last = tile->getSamples() - 1;
+
+                            double y = unit(random) * last, x = unit(random) * last, angle = unit(random) * 2.0 * M_PI;
+                            double dy = std::sin(angle), dx = std::cos(angle);
+                            float z = tile->getHeight( (int)y, (int)x ) + 50.0f;
+
+                            for (int step = 0; step < 2000; step++, y += dy, x += dx, z += 0.2f) {
+                                if (y < 0.0 || y > last || x < 0.0 || x > last) break;
+
+                                float h = tile->getHeight( (int)y, (int)x );
+                                if (h > z) { checksum += step; break; }
+                            }
+                        }
+                    }
+                }
+
+                results[mode][pattern] = elapsedMs(start) / repeats;
+                checksums[mode][pattern] = checksum / repeats;
+            }
+        }
+        Tile::brick_layout = this->brick_layout;
+
+        const char* names[6] = { "Wczytanie kafli:", "1M zapytań w punktach:", "Profil:", "Normalne wierszami:", "Normalne kolumnami:", "20k promieni:" };
+        printf("Układ wysokości na CPU: bloki (wierszami) / cegiełki %d x %d\n", Tile::BRICK, Tile::BRICK);
+        for (int pattern = 0; pattern < 6; pattern++) {
+            printf("  %-24s %9.3f ms / %9.3f ms  (%5.2fx)%s\n", names[pattern], results[0][pattern], results[1][pattern],
+                results[0][pattern] / results[1][pattern], std::abs(checksums[0][pattern] - checksums[1][pattern]) > 1e-6 * std::abs(checksums[0][pattern]) ? "  [różne wyniki]" : "");
+        }
+        return;
+    }
+
+    TileManager t;
+
+    t.setLimits(min, max);
+    
+    t.setPath( this->base_path );
+    t.loadAllTiles();
+
+    Coordinates center = t.getCenter();
+    double lon = center.longitude.toFloat(), lat = center.latitude.toFloat();
+
+    if (name == "profile") {
+        // Łamana przecinająca kilka kafli, próbkowana co ~3"
+        std::vector<glm::dvec2> polyline = {
+            { lon - 1.5, lat - 1.0 }, { lon - 0.5, lat + 0.8 }, { lon + 0.5, lat - 0.8 }, { lon + 1.5, lat + 1.0 }
+        };
+        const double step = 30.0;
+        const int repeats = 20;
+
+        std::vector<ProfileSample> buffer(4096), samples;
+        unsigned int lookups = 0;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int r = 0; r < repeats; r++) {
+            ProfileCursor cursor(polyline, step);
+            size_t n;
+
+            while ((n = t.getProfile(cursor, buffer.data(), buffer.size())) > 0) {
+                if (r == 0) samples.insert(samples.end(), buffer.begin(), buffer.begin() + n);
+            }
+            lookups = cursor.tile_lookups;
+        }
+        double profileMs = elapsedMs(start) / repeats;
+
+        start = std::chrono::high_resolution_clock::now();
+        double checksum = 0.0;
+        for (int r = 0; r < repeats; r++) {
+            for (auto const& s : samples) {
+                checksum += t.getHeight( Coordinates( (float)s.latitude, (float)s.longitude ) );
+            }
+        }
+        double perSampleMs = elapsedMs(start) / repeats;
+
+        printf("Profil: %zu próbek, %.1f km, %u wyszukań kafli\n", samples.size(), samples.back().distance / 1000.0, lookups);
+        printf("  getProfile:              %9.3f ms  (%7.1f ns/próbkę)\n", profileMs,   profileMs   * 1e6 / samples.size());
+        printf("  getHeight(Coordinates):  %9.3f ms  (%7.1f ns/próbkę)   [%.0f]\n", perSampleMs, perSampleMs * 1e6 / samples.size(), checksum);
+        printf("  Przyspieszenie:          %9.1fx\n", perSampleMs / profileMs);
+    }
+    else if (name == "precision") {
+        // Błąd położenia wierzchołków względem kamery (w metrach) dla kamery tuż nad terenem:
+        // dawna ścieżka (pozycja absolutna we float) i względna (narożnik kafla w double, reszta we float)
+        const double R = 637800.0;
+        const float  h = 150.0f;
+        short lat0 = (short)std::floor(lat), lon0 = (short)std::floor(lon);
+
+        auto unit = [](double lonDeg, double latDeg) {
+            double la = glm::radians(latDeg), lo = glm::radians(lonDeg);
+            return glm::dvec3( cos(la) * cos(lo), sin(la), cos(la) * sin(lo) );
+        };
+
+        double worst[2] = { 0.0, 0.0 }, sum[2] = { 0.0, 0.0 };
+        unsigned int count = 0;
+
+        for (int c = 0; c < 16; c++) {
+            double camLat = lat0 + (c % 4 + 0.5) / 4.0, camLon = lon0 + (c / 4 + 0.5) / 4.0;
+            glm::dvec3 eye = unit(camLon, camLat) * (R + 5.0);
+
+            glm::dvec3 origin = unit(lon0, lat0) * R - eye;
+            glm::vec3  tile_origin = glm::vec3(origin);
+            double la0 = glm::radians((double)lat0), lo0 = glm::radians((double)lon0);
+            float cos_lat0 = cos(la0), sin_lat0 = sin(la0), cos_lon0 = cos(lo0), sin_lon0 = sin(lo0);
+
+            int ci = (int)((camLat - lat0) * 1200.0), cj = (int)((camLon - lon0) * 1200.0);
+
+            for (int i = ci - 20; i <= ci + 20; i++) {
+                for (int j = cj - 20; j <= cj + 20; j++) {
+                    float x = j / 1200.0f, y = i / 1200.0f;
+                    glm::dvec3 ref = unit(lon0 + j / 1200.0, lat0 + i / 1200.0) * (R + h / 10.0) - eye;
+
+                    // Dawny tile3d.vs: pozycja absolutna, odejmowanie kamery w macierzy widoku (float)
+                    float lo = glm::radians(x + lon0), la = glm::radians(y + lat0);
+                    glm::vec3 absolute = glm::vec3( cosf(la) * cosf(lo), sinf(la), cosf(la) * sinf(lo) ) * (637800.0f + h / 10.0f);
+                    glm::vec3 before = absolute - glm::vec3(eye);
+
+                    // Obecny tile3d.vs
+                    float sy = sinf(glm::radians(y) * 0.5f), cy = cosf(glm::radians(y) * 0.5f),
+                          sx = sinf(glm::radians(x) * 0.5f), cx = cosf(glm::radians(x) * 0.5f);
+                    float d_sin_lat =  2.0f * (cos_lat0 * cy - sin_lat0 * sy) * sy;
+                    float d_cos_lat = -2.0f * (sin_lat0 * cy + cos_lat0 * sy) * sy;
+                    float d_sin_lon =  2.0f * (cos_lon0 * cx - sin_lon0 * sx) * sx;
+                    float d_cos_lon = -2.0f * (sin_lon0 * cx + cos_lon0 * sx) * sx;
+                    float cos_lat = cos_lat0 + d_cos_lat;
+                    glm::vec3 offset( cos_lat * d_cos_lon + d_cos_lat * cos_lon0, d_sin_lat, cos_lat * d_sin_lon + d_cos_lat * sin_lon0 );
+                    glm::vec3 up( cos_lat * (cos_lon0 + d_cos_lon), sin_lat0 + d_sin_lat, cos_lat * (sin_lon0 + d_sin_lon) );
+                    glm::vec3 after = tile_origin + offset * 637800.0f + up * (h / 10.0f);
+
+                    // Skala sceny 1:10 - błąd w metrach
+                    double err[2] = { glm::length(glm::dvec3(before) - ref) * 10.0, glm::length(glm::dvec3(after) - ref) * 10.0 };
+                    for (int k = 0; k < 2; k++) {
+                        worst[k] = std::max(worst[k], err[k]);
+                        sum[k] += err[k];
+                    }
+                    count++;
+                }
+            }
+        }
+
+        printf("Precyzja pozycji wierzchołków (%u próbek do ~2 km od kamery):\n", count);
+        printf("  Pozycja absolutna (float):   średnio %8.4f m, maks. %8.4f m\n", sum[0] / count, worst[0]);
+        printf("  Względem kamery:             średnio %8.4f m, maks. %8.4f m\n", sum[1] / count, worst[1]);
+    }
+    else if (name == "vertex") {
+        // Przepustowość vertex shadera tile3d.vs (rasteryzacja wyłączona):
+        // sin/cos liczone w shaderze i odczytywane z tablic
+        const int frames = 200;
+
+        glfwHideWindow(win());
+
+        t.set3DProjection(true);
+        t.setLod(1);
+
+        EarthCamera cam((float)lon, (float)lat, 90.0f, 0.0f, t.getHeight( Coordinates((float)lat, (float)lon) ) + 150.0f);
+        cam.setDrawDistance(15000.0f);
+
+        glm::vec3 position((float)lon, (float)lat, cam.elevation);
+        glm::mat4 view = cam.getRelativeViewMatrix(), projection = cam.getProjectionMatrix(1.0f);
+
+        glEnable(GL_RASTERIZER_DISCARD);
+
+        for (int mode = 0; mode < 2; mode++) {
+            t.setTrigTablesEnabled(mode == 1);
+
+            for (int f = 0; f < 10; f++) t.draw(view, projection, position, cam.getWorldPosition(), 15000.0f);
+            glFinish();
+
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int f = 0; f < frames; f++) t.draw(view, projection, position, cam.getWorldPosition(), 15000.0f);
+            glFinish();
+            double frameMs = elapsedMs(start) / frames;
+
+            printf("  %-24s %8.3f ms/klatkę, %u kafli, %.1f M trójkątów/s\n", mode == 1 ? "Tablice sin/cos:" : "sin/cos w shaderze:",
+                frameMs, t.getTilesRendered(), t.getTriangleCount() / (frameMs * 1000.0));
+        }
+
+        glDisable(GL_RASTERIZER_DISCARD);
+    }
+    else if (name == "startup") {
+        // Koszt uruchomienia poza wczytywaniem kafli: konstruktor TileManager (shadery, indeksy siatek
+        // wszystkich LOD zapisywane wprost do bufora EBO) i samo generowanie indeksów na 1 wątku i wszystkich
+        const int repeats = 5;
+
+        double initMs = 0.0, indexMs = 0.0;
+        for (int r = 0; r < repeats; r++) {
+            TileManager fresh;
+            initMs  += fresh.getInitTimeMs();
+            indexMs += fresh.getIndexTimeMs();
+        }
+
+        size_t total = GridIndices::getCount(OverviewPyramid::SAMPLES, 1);
+        for (int lod = 1; lod <= 9; lod++) total += GridIndices::getCount(Tile::BLOCK, lod);
+
+        unsigned int threads = t.getIndexThreads();
+        printf("Uruchomienie: indeksy LOD 1-9 i piramidy przeglądowej %.1f mln (%.1f MB w EBO, bez kopii na CPU), wątki: %u\n",
+            total / 1e6, total * sizeof(unsigned int) / 1048576.0, threads);
+        printf("  Konstruktor TileManager:   %8.2f ms (w tym indeksy %.2f ms), średnio z %d\n", initMs / repeats, indexMs / repeats, repeats);
+
+        std::vector<unsigned int> counts = { 1u };
+        if (threads > 1) counts.push_back(threads);
+
+        for (unsigned int n : counts) {
+            t.setIndexThreads(n);
+
+            double ms = 0.0;
+            for (int r = 0; r < repeats; r++) ms += t.uploadGridIndices();
+            printf("  Indeksy, %2u wątków:        %8.2f ms\n", n, ms / repeats);
+        }
+        t.setIndexThreads(threads);
+    }
+    else if (name == "vcache") {
+        // Kolejność trójkątów siatek regularnych (GridIndices): ACMR symulowanej pamięci podręcznej
+        // wierzchołków (FIFO 16 i 32) dla LOD 1-9 i węzła piramidy przeglądowej wierszami i pasami, zgodność
+        // zbioru trójkątów i czas generowania. Następnie vertex shader tile3d.vs w obu kolejnościach
+        // (rasteryzacja wyłączona): czas klatki i - z GL_ARB_pipeline_statistics_query - wywołania na klatkę.
+        const int caches[] = { 16, 32 };
+        const int frames = 100;
+
+        // Trójkąty zaczynające się od najmniejszego indeksu (obieg zachowany), posortowane
+        auto canonical = [](std::vector<unsigned int> const& indices) {
+            std::vector<std::array<unsigned int, 3>> triangles;
+            triangles.reserve(indices.size() / 3);
+
+            for (size_t k = 0; k + 2 < indices.size(); k += 3) {
+                std::array<unsigned int, 3> tr = { indices[k], indices[k + 1], indices[k + 2] };
+                std::rotate(tr.begin(), std::min_element(tr.begin(), tr.end()), tr.end());
+                triangles.push_back(tr);
+            }
+            std::sort(triangles.begin(), triangles.end());
+            return triangles;
+        };
+
+        printf("Kolejność indeksów siatek regularnych: pasy po %d czworokątów (pamięć podręczna %d)\n",
+            GridIndices::getBandWidth(GridIndices::CACHE_SIZE), GridIndices::CACHE_SIZE);
+        printf("  LOD      trójkątów   ACMR FIFO 16: wierszami  pasami   FIFO 32: wierszami  pasami   generowanie (ms): wierszami  pasami   zgodność\n");
+
+        for (int lod = 1; lod <= 10; lod++) {
+            // 10 - węzeł piramidy przeglądowej
+            int side = lod == 10 ? OverviewPyramid::SAMPLES : Tile::BLOCK, step = lod == 10 ? 1 : lod;
+
+            auto start = std::chrono::high_resolution_clock::now();
+            std::vector<unsigned int> rows = GridIndices::build(side, step, GridOrder::RowMajor);
+            double rowsMs = elapsedMs(start);
+
+            start = std::chrono::high_resolution_clock::now();
+            std::vector<unsigned int> strips = GridIndices::build(side, step, GridOrder::Strips);
+            double stripsMs = elapsedMs(start);
+
+            double acmr[2][2];
+            for (int c = 0; c < 2; c++) {
+                acmr[c][0] = VertexCacheSimulator::run(rows,   caches[c]).getACMR();
+                acmr[c][1] = VertexCacheSimulator::run(strips, caches[c]).getACMR();
+            }
+
+            printf("  %-8s %9zu   %22.3f %7.3f   %18.3f %7.3f   %27.2f %7.2f   %s\n",
+                lod == 10 ? "przegląd" : std::to_string(lod).c_str(), rows.size() / 3, acmr[0][0], acmr[0][1], acmr[1][0], acmr[1][1],
+                rowsMs, stripsMs, canonical(rows) == canonical(strips) ? "tak" : "NIE");
+        }
+
+        glfwHideWindow(win());
+
+        t.set3DProjection(true);
+
+        EarthCamera cam((float)lon, (float)lat, 90.0f, 0.0f, t.getHeight( Coordinates((float)lat, (float)lon) ) + 150.0f);
+        cam.setDrawDistance(15000.0f);
+
+        glm::vec3 position((float)lon, (float)lat, cam.elevation);
+        glm::mat4 view = cam.getRelativeViewMatrix(), projection = cam.getProjectionMatrix(1.0f);
+
+        bool statistics = epoxy_gl_version() >= 46 || epoxy_has_gl_extension("GL_ARB_pipeline_statistics_query");
+        GLuint query = 0;
+        if (statistics) glGenQueries(1, &query);
+        else printf("  Brak GL_ARB_pipeline_statistics_query - bez liczby wywołań vertex shadera\n");
+
+        glEnable(GL_RASTERIZER_DISCARD);
+
+        for (int lod : { 1, 4 }) {
+            t.setLod(lod);
+
+            for (GridOrder order : { GridOrder::RowMajor, GridOrder::Strips }) {
+                t.setGridOrder(order);
+
+                for (int f = 0; f < 10; f++) t.draw(view, projection, position, cam.getWorldPosition(), 15000.0f);
+                glFinish();
+
+                GLuint64 invocations = 0;
+                if (statistics) {
+                    glBeginQuery(GL_VERTEX_SHADER_INVOCATIONS_ARB, query);
+                    t.draw(view, projection, position, cam.getWorldPosition(), 15000.0f);
+                    glEndQuery(GL_VERTEX_SHADER_INVOCATIONS_ARB);
+                    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &invocations);
+                }
+
+                auto start = std::chrono::high_resolution_clock::now();
+                for (int f = 0; f < frames; f++) t.draw(view, projection, position, cam.getWorldPosition(), 15000.0f);
+                glFinish();
+                double frameMs = elapsedMs(start) / frames;
+
+                printf("  LOD %d, %-10s %8.3f ms/klatkę, %u kafli, %.1f M trójkątów/s", lod, order == GridOrder::Strips ? "pasami:" : "wierszami:",
+                    frameMs, t.getTilesRendered(), t.getTriangleCount() / (frameMs * 1000.0));
+                if (statistics) printf(", %.2f M wywołań vertex shadera (%.3f na trójkąt)", invocations / 1e6, (double)invocations / std::max<uint64_t>(t.getTriangleCount(), 1));
+                printf("\n");
+            }
+        }
+
+        glDisable(GL_RASTERIZER_DISCARD);
+        if (statistics) glDeleteQueries(1, &query);
+    }
+    else if (name == "upload") {
+        // Pierwsze klatki w 3D nad środkiem obszaru: wysyłanie wysokości na GPU bez limitu
+        // i z limitem bajtów na klatkę (czas klatki po stronie CPU, do glFinish), przez
+        // glBufferSubData oraz przez trwale zmapowany bufor pośredni
+        glfwHideWindow(win());
+
+        t.set3DProjection(true);
+
+        EarthCamera cam((float)lon, (float)lat, 90.0f, 0.0f, t.getHeight( Coordinates((float)lat, (float)lon) ) + 150.0f);
+        glm::mat4 view = cam.getRelativeViewMatrix(), projection = cam.getProjectionMatrix(1.0f);
+        glm::vec3 position((float)lon, (float)lat, cam.elevation);
+
+        const char* modes[3] = { "Bez limitu, SubData:", "Bez limitu, ring:", "Limit 2 kafle, ring:" };
+
+        if (!t.isUploadRingAvailable()) printf("  Brak GL_ARB_buffer_storage - ring korzysta z glBufferSubData\n");
+
+        for (int mode = 0; mode < 3; mode++) {
+            size_t budget = mode < 2 ? SIZE_MAX : 2 * Tile::BLOCK_BYTES;
+            t.setUploadRing(mode > 0);
+
+            // Klatka bez kafli w zasięgu zwalnia wszystkie bufory
+            t.setUploadBudget(budget, 0);
+            t.draw(view, projection, position, cam.getWorldPosition(), -1.0f);
+            t.setUploadBudget(budget);
+            t.resetUploadStats();
+
+            auto total = std::chrono::high_resolution_clock::now();
+            double worstMs = 0.0;
+            unsigned int frames = 0, deferred;
+
+            do {
+                deferred = t.getUploadsDeferred();
+
+                auto start = std::chrono::high_resolution_clock::now();
+                t.draw(view, projection, position, cam.getWorldPosition(), 15000.0f);
+                glFinish();
+
+                worstMs = std::max(worstMs, elapsedMs(start));
+                frames++;
+            } while (t.getUploadsDeferred() != deferred);
+
+            double totalMs = elapsedMs(total), megabytes = t.getGpuResidentBytes() / 1048576.0;
+
+            printf("  %-22s %3u klatek do wysłania %u/%u kafli (%.0f MB), najdłuższa klatka %8.3f ms, %8.1f MB/s (wywołania: %8.1f MB/s)\n",
+                modes[mode], frames, t.getGpuResidentTiles(), t.getLoadedTiles(), megabytes, worstMs, megabytes / (totalMs / 1000.0), t.getUploadThroughput());
+        }
+    }
+    else if (name == "overview") {
+        // Widok 2D przy coraz większym oddaleniu (do limitu przybliżenia z pętli głównej): liczba
+        // wywołań rysowania, dane wysłane na GPU i czas klatki po stronie CPU - kafle i piramida
+        const int frames = 50;
+        const float zooms[3] = { 55.0f, 200.0f, 750.0f };
+
+        glfwHideWindow(win());
+        glViewport(0, 0, 800, 800);
+
+        OverviewPyramid const& pyramid = t.getOverviewPyramid();
+        printf("Piramida przeglądowa: %d poziomów, %.1f MB\n", pyramid.getLevels(), pyramid.getBytes() / 1048576.0);
+
+        glm::vec3 position((float)lon, (float)lat, 1.0f);
+
+        for (float zoom : zooms) {
+            Camera cam(glm::vec3(position.x * t.getXCondensation(), position.y, 1.0f), 180.0f);
+            cam.ortho = true;
+            cam.setZoomLimits(1.5f, 750.0f);
+            cam.setZoom(zoom);
+
+            glm::mat4 view = cam.getViewMatrix(), projection = cam.getProjectionMatrix(1.0f);
+            float drawDistance = cam.getDrawDistance(1.0f);
+
+            for (int mode = 0; mode < 2; mode++) {
+                t.setOverview(mode == 1);
+
+                // Klatka bez kafli w zasięgu zwalnia wszystkie bufory
+                t.setUploadBudget(SIZE_MAX, 0);
+                t.draw(view, projection, position, glm::dvec3(0.0), -1.0f);
+                t.setUploadBudget(SIZE_MAX);
+
+                t.draw(view, projection, position, glm::dvec3(0.0), drawDistance);
+                glFinish();
+
+                auto start = std::chrono::high_resolution_clock::now();
+                for (int f = 0; f < frames; f++) t.draw(view, projection, position, glm::dvec3(0.0), drawDistance);
+                glFinish();
+                double frameMs = elapsedMs(start) / frames;
+
+                printf("  Widok %5.1f st., %-9s %4u wywołań, %8.1f MB na GPU, %8.3f ms/klatkę%s\n",
+                    zoom / cam.getInitialFov() * 10.0f, mode == 1 ? "piramida:" : "kafle:", t.getTilesRendered(), t.getGpuResidentBytes() / 1048576.0, frameMs,
+                    t.getOverviewLevel() >= 0 ? (" (węzły " + std::to_string(1 << t.getOverviewLevel()) + " st.)").c_str() : "");
+            }
+        }
+    }
+    else if (name == "neighbours") {
+        // Okna 3 x 3 wokół wszystkich próbek na krawędziach kafli: po połączeniach z sąsiadami
+        // i przez wyszukiwanie kafla w mapie dla każdej próbki (jak przed wprowadzeniem połączeń)
+        const int repeats = 5;
+
+        std::vector<Tile const*> loaded;
+        for (auto const& [key, entry] : t.getIndex().getEntries()) {
+            if (Tile const* tile = t.findTile(entry.latitude, entry.longitude)) loaded.push_back(tile);
+        }
+
+        auto lookupHeight = [&t](Tile const* tile, int i, int j) -> float {
+            int last = tile->getSamples() - 1;
+            int di = (i > last) - (i < 0), dj = (j > last) - (j < 0);
+
+            Tile const* other = t.findTile(tile->origin.latitude.getDegreesSigned() + di, tile->origin.longitude.getDegreesSigned() + dj);
+            return other != nullptr ? other->getHeight(i - di * last, j - dj * last) : Tile::NO_DATA;
+        };
+
+        float window[9];
+        double checksum[2] = { 0.0, 0.0 }, ms[2];
+        size_t samples = 0;
+
+        for (int mode = 0; mode < 2; mode++) {
+            auto start = std::chrono::high_resolution_clock::now();
+
+            for (int r = 0; r < repeats; r++) {
+                for (Tile const* tile : loaded) {
+                    int last = tile->getSamples() - 1;
+
+                    for (int k = 0; k < 4 * last; k++) {
+                        int i = k < 2 * last ? (k < last ? 0 : last) : k % last,
+                            j = k < 2 * last ? k % last : (k < 3 * last ? 0 : last);
+
+                        if (mode == 0) {
+                            tile->getWindow(i, j, window);
+                        } else {
+                            for (int w = 0; w < 9; w++) window[w] = lookupHeight(tile, i + w / 3 - 1, j + w % 3 - 1);
+                        }
+
+                        for (float h : window) checksum[mode] += h;
+                        if (mode == 0 && r == 0) samples++;
+                    }
+                }
+            }
+            ms[mode] = elapsedMs(start) / repeats;
+        }
+
+        printf("Sąsiedzi: %zu kafli, %zu próbek na krawędziach\n", loaded.size(), samples);
+        printf("  Okno 3 x 3, połączenia:        %9.3f ms  (%6.1f ns/próbkę)   [%.0f]\n", ms[0], ms[0] * 1e6 / samples, checksum[0]);
+        printf("  Okno 3 x 3, wyszukiwanie:      %9.3f ms  (%6.1f ns/próbkę)   [%.0f]\n", ms[1], ms[1] * 1e6 / samples, checksum[1]);
+        printf("  Przyspieszenie:                %9.1fx\n", ms[1] / ms[0]);
+
+        // Usunięcie kafla z największą liczbą sąsiadów i ponowne wczytanie - połączenia mają zniknąć i wrócić
+        Tile const* centre = nullptr;
+        int most = -1;
+        for (Tile const* tile : loaded) {
+            int count = 0;
+            for (int k = 0; k < 9; k++) count += k != 4 && tile->getNeighbour(k / 3 - 1, k % 3 - 1) != nullptr;
+            if (count > most) { most = count; centre = tile; }
+        }
+        if (centre == nullptr) return;
+
+        Coordinates origin = centre->origin;
+        short lat = origin.latitude.getDegreesSigned(), lon = origin.longitude.getDegreesSigned();
+        auto linked = [&t, lat, lon]() {
+            int count = 0;
+            for (int k = 0; k < 9; k++) {
+                Tile const* other = t.findTile(lat + k / 3 - 1, (lon + k % 3 - 1 + 540) % 360 - 180);
+                if (k != 4 && other != nullptr) count += other->getNeighbour(1 - k / 3, 1 - k % 3) != nullptr;
+            }
+            return count;
+        };
+
+        t.evictTile(origin.getTileString());
+        int afterEvict = linked();
+        t.loadTile(origin);
+        int afterLoad = linked();
+
+        double reloaded = 0.0;
+        for (int r = 0; r < repeats; r++) {
+            for (auto const& [key, entry] : t.getIndex().getEntries()) {
+                Tile const* tile = t.findTile(entry.latitude, entry.longitude);
+                if (tile == nullptr) continue;
+
+                int last = tile->getSamples() - 1;
+                for (int k = 0; k < 4 * last; k++) {
+                    int i = k < 2 * last ? (k < last ? 0 : last) : k % last,
+                        j = k < 2 * last ? k % last : (k < 3 * last ? 0 : last);
+
+                    tile->getWindow(i, j, window);
+                    for (float h : window) reloaded += h;
+                }
+            }
+        }
+
+        printf("  Usunięcie %s (%d sąsiadów): %d połączeń po usunięciu, %d po wczytaniu, okna %s\n",
+            origin.getTileString().c_str(), most, afterEvict, afterLoad, reloaded == checksum[0] ? "zgodne" : "RÓŻNE");
+    }
+    else if (name == "mesh") {
+        // Siatki adaptacyjne (RTIN) załadowanych kafli przy kilku progach błędu pionowego: trójkąty
+        // w porównaniu z pełną siatką i z najrzadszą siatką regularną (LOD) mieszczącą się w tym samym
+        // progu, zmierzony błąd siatki i czas budowy; dla progu domyślnego wyniki każdego kafla
+        const float bounds[] = { 1.0f, 2.0f, RtinBuilder::DEFAULT_ERROR, 10.0f };
+
+        std::vector<Tile const*> loaded;
+        for (auto const& [key, entry] : t.getIndex().getEntries()) {
+            if (Tile const* tile = t.findTile(entry.latitude, entry.longitude)) loaded.push_back(tile);
+        }
+
+        // Błąd siatek regularnych LOD 2-9 (LOD 1 - wszystkie próbki, błąd 0), każdy blok osobno
+        std::vector<unsigned int> grids[10];
+        for (int lod = 1; lod <= 9; lod++) grids[lod] = t.getGridIndices(lod);
+
+        std::vector<std::array<float, 10>> grid_error(loaded.size());
+        std::vector<float> relief(loaded.size());
+
+        for (size_t k = 0; k < loaded.size(); k++) {
+            Tile const* tile = loaded[k];
+            auto get = [tile](int i, int j) { return tile->getSample(i, j); };
+            int blocks = (tile->getSamples() - 1) / (Tile::BLOCK - 1);
+
+            grid_error[k].fill(0.0f);
+            for (int lod = 2; lod <= 9; lod++) {
+                std::vector<unsigned int> const& grid = grids[lod];
+
+                for (int b = 0; b < blocks * blocks; b++)
+                    grid_error[k][lod] = std::max(grid_error[k][lod], RtinBuilder::measureError(get, tile->getSamples(), grid.data(), grid.size(), (size_t)b * Tile::BLOCK * Tile::BLOCK));
+            }
+
+            float lo = FLT_MAX, hi = -FLT_MAX;
+            for (int i = 0; i < tile->getSamples(); i++) {
+                for (int j = 0; j < tile->getSamples(); j++) {
+                    lo = std::min(lo, tile->getSample(i, j));
+                    hi = std::max(hi, tile->getSample(i, j));
+                }
+            }
+            relief[k] = hi - lo;
+        }
+
+        printf("Siatki adaptacyjne: %zu kafli, łatki %d x %d\n", loaded.size(), RtinBuilder::PATCH, RtinBuilder::PATCH);
+
+        for (float bound : bounds) {
+            uint64_t total_mesh = 0, total_full = 0, total_grid = 0;
+            double ms = 0.0;
+            float worst = 0.0f;
+            std::vector<double> reductions;
+
+            if (bound == RtinBuilder::DEFAULT_ERROR)
+                printf("  Kafle przy %.1f m:      deniwelacja   trójkąty     pełna siatka   LOD   siatka LOD   błąd\n", bound);
+
+            for (size_t k = 0; k < loaded.size(); k++) {
+                Tile const* tile = loaded[k];
+                auto get = [tile](int i, int j) { return tile->getSample(i, j); };
+                int blocks = (tile->getSamples() - 1) / (Tile::BLOCK - 1);
+
+                AdaptiveMesh mesh = tile->buildMesh(bound);
+                float error = RtinBuilder::measureError(get, tile->getSamples(), mesh.indices.data(), mesh.indices.size());
+
+                int lod = 1;
+                while (lod < 9 && grid_error[k][lod + 1] <= bound) lod++;
+
+                uint64_t full = (uint64_t)2 * (tile->getSamples() - 1) * (tile->getSamples() - 1),
+                         grid = (uint64_t)grids[lod].size() / 3 * blocks * blocks;
+
+                total_mesh += mesh.getTriangles();
+                total_full += full;
+                total_grid += grid;
+                ms += mesh.ms;
+                worst = std::max(worst, error);
+                reductions.push_back( (double)grid / std::max<size_t>(mesh.getTriangles(), 1) );
+
+                if (bound == RtinBuilder::DEFAULT_ERROR)
+                    printf("    %s              %7.0f m %10zu %7.1fx mniej %5d %7.1fx mniej %6.2f m\n", tile->origin.getTileString().c_str(), relief[k], mesh.getTriangles(), (double)full / std::max<size_t>(mesh.getTriangles(), 1), lod, reductions.back(), error);
+            }
+            if (reductions.empty()) continue;
+
+            std::sort(reductions.begin(), reductions.end());
+            printf("  Błąd %4.1f m: %10llu trójkątów, %6.1fx mniej niż pełna siatka, %6.1fx mniej niż LOD (na kafel: min %.1fx, mediana %.1fx, max %.1fx), zmierzony błąd %.2f m, %.1f ms/kafel\n",
+                bound, (unsigned long long)total_mesh, (double)total_full / std::max<uint64_t>(total_mesh, 1), (double)total_grid / std::max<uint64_t>(total_mesh, 1),
+                reductions.front(), reductions[reductions.size() / 2], reductions.back(), worst, ms / loaded.size());
+        }
+    }
+    else if (name == "serve") {
+#if !defined(_WIN32)
+        // Klienci HTTP (po jednym połączeniu keep-alive) pobierają kafle z 127.0.0.1, kafel losowany ze
+        // skośnym rozkładem ze zbioru pokrywającego załadowane kafle, co dziesiąty to mapa. Główny wątek
+        // rysuje mapy. Przebiegi: bez pamięci podręcznej (tylko łączenie równoczesnych żądań),
+        // z pamięcią podręczną od zimnego startu i rozgrzaną.
+        const int zoom = 11, clients = 8, requests = 250;
+
+        std::vector<TileKey> keys;
+        std::unordered_set<uint64_t> seen;
+        for (auto const& [key, entry] : t.getIndex().getEntries()) {
+            if (t.findTile(entry.latitude, entry.longitude) == nullptr) continue;
+
+            auto column = [zoom](double lon) { return (int)std::floor( (lon + 180.0) / 360.0 * (1 << zoom) ); };
+            auto row    = [zoom](double lat) {
+                return (int)std::floor( (1.0 - std::asinh( std::tan(glm::radians(lat)) ) / M_PI) / 2.0 * (1 << zoom) );
+            };
+
+            for (int y = row(entry.latitude + 1.0); y <= row(entry.latitude); y++) {
+                for (int x = column(entry.longitude); x <= column(entry.longitude + 1.0); x++) {
+                    if (seen.insert( ((uint64_t)x << 32) | (uint32_t)y ).second) keys.push_back( TileKey{ TileKey::Terrain, zoom, x, y } );
+                }
+            }
+        }
+        std::mt19937 rng(7);
+        std::shuffle(keys.begin(), keys.end(), rng);
+
+        MapRenderer renderer(t);
+        TileServer server(t, renderer, 256 << 20, clients);
+        server.start(0);
+
+        auto run = [&](char const* label) {
+            server.getCache().resetStats();
+
+            std::vector<std::vector<double>> latencies(clients);
+            std::atomic<int> finished{ 0 }, failed{ 0 };
+            std::vector<std::thread> threads;
+
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int c = 0; c < clients; c++) {
+                threads.emplace_back([&, c]() {
+                    std::mt19937 local(100 + c);
+                    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+                    HttpClient client(server.getPort());
+                    std::string body;
+
+                    for (int r = 0; r < requests; r++) {
+                        TileKey key = keys[ (size_t)(std::pow(uniform(local), 3.0) * keys.size()) ];
+                        bool map = r % 10 == 9;
+
+                        std::string path = std::string(map ? "/map/" : "/terrain/") + std::to_string(key.z) + "/" + std::to_string(key.x) + "/" + std::to_string(key.y) + ".png";
+
+                        auto sent = std::chrono::high_resolution_clock::now();
+                        if (client.get(path, body) != 200) failed++;
+                        latencies[c].push_back( elapsedMs(sent) );
+                    }
+                    finished++;
+                });
+            }
+            while (finished < clients) server.pump(std::chrono::milliseconds(1));
+            for (std::thread& thread : threads) thread.join();
+            double ms = elapsedMs(start);
+
+            std::vector<double> all;
+            for (auto const& l : latencies) all.insert(all.end(), l.begin(), l.end());
+            std::sort(all.begin(), all.end());
+            auto percentile = [&all](double p) { return all[ std::min(all.size() - 1, (size_t)(p * all.size())) ]; };
+
+            TileServerStats stats = server.getStats();
+            printf("  %-24s %8.0f żądań/s, p50 %7.2f ms, p95 %7.2f ms, p99 %7.2f ms, trafienia %5.1f%%, połączone %4zu, policzone %4zu, błędy %d\n",
+                label, all.size() / ms * 1000.0, percentile(0.50), percentile(0.95), percentile(0.99),
+                100.0 * stats.hits / stats.requests, stats.coalesced, stats.computed, failed.load());
+        };
+
+        printf("Serwer kafli: %zu kafli z = %d, %d klientów po %d żądań (10%% map)\n", keys.size(), zoom, clients, requests);
+
+        // Mapy: wiersz kafla Web Mercator z obrazu równoodległościowego - obraz testowy z numerem wiersza
+        // w kanale R (256 wierszy), szerokość wiersza źródła odczytanego w każdym wierszu kafla porównana
+        // z szerokością środka wiersza Web Mercator (dopuszczalny błąd - wiersz źródła)
+        {
+            const int size = TileKey::SIZE;
+            double worst = 0.0, limit = 0.0;
+
+            for (TileKey key : { keys.front(), TileKey{ TileKey::Map, 4, 8, 2 } }) {
+                std::vector<uint8_t> rows((size_t)size * size * 3, 0);
+                for (int r = 0; r < size; r++) for (int x = 0; x < size; x++) rows[((size_t)r * size + x) * 3] = (uint8_t)r;
+
+                std::vector<uint8_t> mercator = TileServer::reproject(key, rows, size);
+
+                double lat_max = TileKey::latitude(key.y, key.z), lat_min = TileKey::latitude(key.y + 1, key.z);
+                double row_deg = (lat_max - lat_min) / size;
+                limit = std::max(limit, row_deg);
+
+                for (int py = 0; py < size; py++) {
+                    double expected = TileKey::latitude(key.y + (py + 0.5) / size, key.z);
+                    double found    = lat_max - (mercator[(size_t)py * size * 3] + 0.5) * row_deg;
+
+                    worst = std::max(worst, std::abs(found - expected) / row_deg);
+                    if (std::abs(TileKey::row(expected, key.z) - (key.y + (py + 0.5) / size)) > 1e-9) worst = INFINITY;
+                }
+            }
+            printf("  Mapy w Web Mercator:      największy błąd szerokości wiersza %.2f wiersza źródła  %s\n", worst, worst <= 1.0 ? "zgodne" : "NIEZGODNE");
+        }
+
+        server.getCache().setCapacity(0);
+        run("Bez pamięci podręcznej:");
+
+        server.getCache().setCapacity(256 << 20);
+        server.getCache().clear();
+        run("Zimna pamięć podręczna:");
+        run("Rozgrzana:");
+
+        server.stop();
+#endif
+    }
+    else if (name == "soft") {
+        // Klatka 1600 x 900 przez OpenGL (z odczytem pikseli) i na CPU (SoftRasterizer, 1 wątek i wszystkie):
+        // widok 2D całego obszaru i widok 3D nad środkiem obszaru. Różnica obrazów - średnia na kanał
+        // i udział pikseli różniących się o więcej niż 8 na którymś kanale. Porównanie z Mesa llvmpipe:
+        // LIBGL_ALWAYS_SOFTWARE=1 ./AGL3-terrain ... -bench soft
+        const int width = 1600, height = 900, frames = 10;
+
+        glfwHideWindow(win());
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+        RenderJob job{ 180.0, 90.0, -180.0, -90.0, width, height, "" };
+        for (auto const& [key, entry] : t.getIndex().getEntries()) {
+            if (t.findTile(entry.latitude, entry.longitude) == nullptr) continue;
+
+            job.lon_min = std::min(job.lon_min, (double)entry.longitude);  job.lon_max = std::max(job.lon_max, entry.longitude + 1.0);
+            job.lat_min = std::min(job.lat_min, (double)entry.latitude);   job.lat_max = std::max(job.lat_max, entry.latitude  + 1.0);
+        }
+
+        MapRenderer renderer(t);
+        SoftRasterizer rasterizer;
+        rasterizer.resize(width, height);
+        unsigned int threads = rasterizer.getThreads();
+
+        auto difference = [](std::vector<uint8_t> const& a, std::vector<uint8_t> const& b, double& differing) {
+            double sum = 0.0;
+            size_t count = 0;
+
+            for (size_t p = 0; p < a.size(); p += 4) {
+                int worst = 0;
+                for (int c = 0; c < 3; c++) {
+                    int d = std::abs(a[p + c] - b[p + c]);
+                    sum += d;
+                    worst = std::max(worst, d);
+                }
+                count += worst > 8;
+            }
+            differing = 100.0 * count / (a.size() / 4);
+            return sum / (a.size() / 4 * 3);
+        };
+
+        for (int mode = 0; mode < 2; mode++) {
+            glm::mat4 view(1.0f), projection;
+            glm::vec3 position;
+            glm::dvec3 eye(0.0);
+            float drawDistance = 15000.0f;
+
+            EarthCamera cam((float)lon, (float)lat, 90.0f, -10.0f, t.getHeight( Coordinates((float)lat, (float)lon) ) + 150.0f);
+            cam.setDrawDistance(drawDistance);
+
+            if (mode == 0) {
+                renderJobView(job, t.getXCondensation(), projection, position, drawDistance);
+            } else {
+                t.set3DProjection(true);
+                view = cam.getRelativeViewMatrix();
+                projection = cam.getProjectionMatrix((float)width / height);
+                position = glm::vec3((float)lon, (float)lat, cam.elevation);
+                eye = cam.getWorldPosition();
+            }
+
+            // OpenGL: klatka do odczytu pikseli włącznie (jak przy zapisie obrazu)
+            std::vector<uint8_t> gl_image((size_t)width * height * 4);
+            auto drawGL = [&]() {
+                if (mode == 0) {
+                    gl_image = renderer.renderImage(job);
+                    return;
+                }
+                glBindFramebuffer(GL_FRAMEBUFFER, 0);
+                glViewport(0, 0, width, height);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                t.draw(view, projection, position, eye, drawDistance);
+
+                glPixelStorei(GL_PACK_ALIGNMENT, 1);
+                glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, gl_image.data());
+            };
+
+            t.setUploadBudget(SIZE_MAX);
+            for (int f = 0; f < 2; f++) drawGL();
+
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int f = 0; f < frames; f++) drawGL();
+            double glMs = elapsedMs(start) / frames;
+
+            printf("%s: %d x %d\n", mode == 0 ? "Widok 2D całego obszaru" : "Widok 3D nad środkiem obszaru", width, height);
+            printf("  %-22s %9.3f ms/klatkę\n", "OpenGL:", glMs);
+
+            for (unsigned int n : { 1u, threads }) {
+                rasterizer.setThreads(n);
+                rasterizer.draw(t, view, projection, position, eye, drawDistance);
+
+                double vertexMs = 0.0, rasterMs = 0.0;
+                start = std::chrono::high_resolution_clock::now();
+                for (int f = 0; f < frames; f++) {
+                    rasterizer.draw(t, view, projection, position, eye, drawDistance);
+                    vertexMs += rasterizer.getVertexMs();
+                    rasterMs += rasterizer.getRasterMs();
+                }
+                double softMs = elapsedMs(start) / frames;
+
+                double differing, mean = difference(gl_image, rasterizer.getImage(), differing);
+                printf("  CPU, wątki: %2u:        %9.3f ms/klatkę (wierzchołki %8.3f, rasteryzacja %8.3f), %6.2f M trójkątów, różnica %5.2f / 255, %5.2f%% pikseli\n",
+                    n, softMs, vertexMs / frames, rasterMs / frames, rasterizer.getTriangleCount() / 1e6, mean, differing);
+
+                if (n == threads) break;
+            }
+        }
+        t.set3DProjection(false);
+    }
+    else if (name == "contours") {
+        // Warstwice kafli widocznych w 2D wokół pozycji startowej przy kilku zasięgach i odstępach:
+        // pierwsze wyznaczenie (1 wątek i wszystkie), zestaw z pamięci podręcznej (samo łączenie)
+        // i przesunięcie widoku o 1° na wschód (śledzone tylko nowe kafle). Na koniec jak w pętli głównej:
+        // zlecenie w tle i odbiór co klatkę (60 Hz) - najdłuższe wywołanie w wątku głównym.
+        const float distances[] = { 0.5f, 1.0f, 2.0f };
+        const float intervals[] = { 10.0f, 20.0f, 50.0f, 100.0f };
+
+        ContourCache cache;
+        unsigned int threads = cache.getThreads();
+        glm::vec3 position((float)lon, (float)lat, 1.0f);
+
+        printf("Warstwice wokół %.3f / %.3f, wątki: %u\n", lon, lat, threads);
+        printf("  zasięg  odstęp  kafli  1 wątek (ms)  %2u wątków (ms)  ms/kafel  z pamięci (ms)  przesunięcie (ms)  w tle: klatek  klatka (ms)      linii    punktów  połączeń\n", threads);
+
+        for (float distance : distances) {
+            std::vector<Tile*> tiles = t.getTilesInRange(position, distance * 1.2f),
+                               moved = t.getTilesInRange(position + glm::vec3(1.0f, 0.0f, 0.0f), distance * 1.2f);
+            if (tiles.empty()) continue;
+
+            for (float interval : intervals) {
+                double cold[2];
+                for (int pass = 0; pass < 2; pass++) {
+                    cache.setThreads(pass == 0 ? 1 : threads);
+                    cache.clear();
+
+                    auto start = std::chrono::high_resolution_clock::now();
+                    cache.update(tiles, interval);
+                    cold[pass] = elapsedMs(start);
+                }
+                ContourStats stats = cache.getStats();
+
+                // Przesunięcie (śledzone tylko nowe kafle), powrót - wszystkie kafle w pamięci, samo łączenie
+                auto start = std::chrono::high_resolution_clock::now();
+                cache.update(moved, interval);
+                double pan = elapsedMs(start);
+
+                start = std::chrono::high_resolution_clock::now();
+                cache.update(tiles, interval);
+                double warm = elapsedMs(start);
+
+                cache.clear();
+                int polls = 0;
+                double worst = 0.0;
+                for (bool ready = false; !ready; polls++) {
+                    start = std::chrono::high_resolution_clock::now();
+                    cache.request(tiles, interval);
+                    ready = cache.collect();
+                    worst = std::max(worst, elapsedMs(start));
+
+                    if (!ready) std::this_thread::sleep_for(std::chrono::microseconds(16667));
+                }
+
+                printf("  %5.1f°  %4.0f m  %5zu  %12.2f  %14.2f  %8.2f  %14.2f  %17.2f  %13d  %11.3f  %9zu  %9zu  %8zu\n",
+                    distance, interval, tiles.size(), cold[0], cold[1], stats.tile_ms / tiles.size(), warm, pan,
+                    polls, worst, stats.lines, stats.points, stats.joined);
+            }
+        }
+    }
+    else if (name == "viewshed") {
+        // Widoczność z pozycji startowej (10 m nad terenem) przy kilku promieniach, na 1 wątku i kolejno
+        // podwajanej liczbie do wszystkich: czas całkowity i kopiowania wysokości, zgodność maski z 1 wątkiem
+        const double radii[] = { 10000.0, 25000.0, 50000.0 };
+        const int repeats = 3;
+
+        Viewshed viewshed(t);
+        unsigned int threads = viewshed.getThreadCount();
+
+        std::vector<unsigned int> counts;
+        for (unsigned int n = 1; n < threads; n *= 2) counts.push_back(n);
+        counts.push_back(threads);
+
+        printf("Widoczność z %.3f / %.3f, wątki: %u\n", lon, lat, threads);
+        printf("  promień  wątki  komórek (mln)        ms  wysokości (ms)  widocznych  zgodność\n");
+
+        for (double radius : radii) {
+            ViewshedResult reference;
+
+            for (unsigned int n : counts) {
+                viewshed.setThreadCount(n);
+
+                double ms = 0.0, gatherMs = 0.0;
+                ViewshedResult result;
+                for (int r = 0; r < repeats; r++) {
+                    result = viewshed.compute(lon, lat, radius);
+                    ms += result.computeTimeMs;
+                    gatherMs += result.gatherTimeMs;
+                }
+                if (n == 1) reference = result;
+
+                printf("  %4.0f km  %5u  %13.2f  %8.2f  %14.2f  %10u  %s\n",
+                    radius / 1000.0, n, result.mask.size() / 1e6, ms / repeats, gatherMs / repeats, result.countVisible(),
+                    n == 1 ? "-" : (result.mask == reference.mask ? "tak" : "NIE"));
+            }
+        }
+        viewshed.setThreadCount(threads);
+    }
+    else if (name == "terrain") {
+        // Nachylenie, ekspozycja i szorstkość wszystkich załadowanych kafli: skalarnie (<cmath>) i wektorowo
+        // na 1 wątku oraz wektorowo na wszystkich (kafle po kolei, pasy wierszy w wątkach); różnica wyników
+        // wektorowych i skalarnych. Na końcu obszar 2° x 2° wokół pozycji startowej (kafle w wątkach).
+        const TerrainMeasure measures[] = { TerrainMeasure::Slope, TerrainMeasure::Aspect, TerrainMeasure::Ruggedness };
+
+        std::vector<Tile const*> loaded;
+        for (auto const& [key, entry] : t.getIndex().getEntries()) {
+            if (Tile const* tile = t.findTile(entry.latitude, entry.longitude)) loaded.push_back(tile);
+        }
+
+        TerrainAnalysis analysis(t);
+        unsigned int threads = analysis.getThreadCount();
+
+        printf("Analiza rzeźby: %zu kafli, wątki: %u%s\n", loaded.size(), threads, analysis.isVectorized() ? ", SSE2" : " (bez SSE2)");
+        printf("  %-18s   skalarnie (ms/kafel)  wektorowo (ms/kafel)  %2u wątków (ms/kafel)  Mpróbek/s  największa różnica  średnia\n", "", threads);
+
+        for (TerrainMeasure measure : measures) {
+            double ms[3] = { 0.0, 0.0, 0.0 }, worst = 0.0, mean = 0.0;
+            size_t samples = 0, compared = 0;
+
+            for (Tile const* tile : loaded) {
+                TerrainRaster results[3];
+
+                for (int mode = 0; mode < 3; mode++) {
+                    analysis.setVectorized(mode > 0);
+                    analysis.setThreadCount(mode == 2 ? threads : 1);
+
+                    results[mode] = analysis.computeTile(*tile, measure);
+                    ms[mode] += results[mode].computeTimeMs;
+                }
+                samples += results[0].values.size();
+
+                for (size_t k = 0; k < results[0].values.size(); k++) {
+                    float a = results[0].values[k], b = results[1].values[k];
+                    if (a < 0.0f || b < 0.0f) continue;
+
+                    // Ekspozycja: różnica kątów na okręgu
+                    double d = std::abs(a - b);
+                    if (measure == TerrainMeasure::Aspect) d = std::min(d, 360.0 - d);
+
+                    worst = std::max(worst, d);
+                    mean += d;
+                    compared++;
+                }
+            }
+
+            printf("  %-18s   %20.2f  %20.2f  %20.2f  %9.1f  %18.5f  %7.5f\n",
+                TerrainRaster::getName(measure), ms[0] / loaded.size(), ms[1] / loaded.size(), ms[2] / loaded.size(),
+                samples / (ms[2] * 1000.0), worst, compared > 0 ? mean / compared : 0.0);
+        }
+
+        analysis.setVectorized(true);
+        analysis.setThreadCount(threads);
+
+        for (TerrainMeasure measure : measures) {
+            TerrainRaster region = analysis.computeRegion(lon - 1.0, lat - 1.0, lon + 1.0, lat + 1.0, measure);
+
+            size_t valid = std::count_if(region.values.begin(), region.values.end(), [](float v) { return v >= 0.0f; });
+            printf("  Obszar 2° x 2°, %-18s %d x %d, %zu kafli, %8.2f ms, %5.1f%% wartości\n",
+                TerrainRaster::getName(measure), region.cols, region.rows, region.tiles, region.computeTimeMs, 100.0 * valid / region.values.size());
+        }
+    }
+    else if (name == "polygon") {
+        // Statystyki wysokości w wielokącie wielkości województwa wokół pozycji startowej (nieregularny
+        // brzeg, 2400 wierzchołków, z enklawą): odniesienie TileManager::getHeight, odcinki wierszy
+        // i piramida min/max (pierwsze wywołanie buduje piramidy kafli) na 1 wątku i wszystkich;
+        // na końcu piramida przy różnych szerokościach przedziału histogramu i bez histogramu.
+        GeoPolygon polygon;
+        std::vector<glm::dvec2> outer, enclave;
+        const int vertices = 2400;
+
+        for (int k = 0; k < vertices; k++) {
+            double a = 2.0 * M_PI * k / vertices;
+            double r = 0.95 * (1.0 + 0.18 * std::sin(3.0 * a + 0.5) + 0.08 * std::sin(7.0 * a + 1.3) + 0.03 * std::sin(23.0 * a + 2.1));
+
+            outer.push_back(glm::dvec2(lon + r * std::cos(a) / std::cos(glm::radians(lat)), lat + r * std::sin(a)));
+        }
+        for (int k = 0; k < 64; k++) {
+            double a = -2.0 * M_PI * k / 64;
+            enclave.push_back(glm::dvec2(lon + 0.3 + 0.08 * std::cos(a) / std::cos(glm::radians(lat)), lat - 0.2 + 0.08 * std::sin(a)));
+        }
+        polygon.addRing(outer);
+        polygon.addRing(enclave);
+
+        PolygonAggregator aggregator(t);
+        unsigned int threads = aggregator.getThreadCount();
+
+        struct Run { const char* label; PolygonMethod method; unsigned int threads; };
+        const Run runs[] = {
+            { "getHeight",              PolygonMethod::Lookup,  1 },
+            { "odcinki, 1 wątek",       PolygonMethod::Scan,    1 },
+            { "odcinki, wszystkie",     PolygonMethod::Scan,    threads },
+            { "piramida, budowa",       PolygonMethod::Pyramid, 1 },
+            { "piramida, 1 wątek",      PolygonMethod::Pyramid, 1 },
+            { "piramida, wszystkie",    PolygonMethod::Pyramid, threads },
+        };
+
+        printf("Statystyki w wielokącie wokół %.3f / %.3f: %zu wierzchołków, wątki: %u\n", lon, lat, polygon.getVertices(), threads);
+        printf("  %-22s %10s  %6s  %10s  %10s  %9s  %7s  %7s  %8s  %11s  %10s  %s\n",
+            "", "ms", "kafli", "próbek", "przeczyt.", "bloków", "min", "max", "średnia", "mediana", "km²", "zgodność");
+
+        // Suma wysokości (double) zależy od kolejności dodawania (wątki, bloki piramidy), a wypełnione braki
+        // danych mają wysokości ułamkowe - suma porównywana z tolerancją względem count * największej |h|
+        auto sameStats = [](PolygonStats const& a, PolygonStats const& b) {
+            double tolerance = 1e-9 * (double)b.count * std::max(std::abs(b.min), std::abs(b.max));
+            return a.count == b.count && std::abs(a.sum - b.sum) <= tolerance && a.min == b.min && a.max == b.max && a.histogram == b.histogram;
+        };
+
+        // Odniesienie - wynik getHeight (PolygonMethod::Lookup)
+        PolygonStats reference;
+        for (Run const& run : runs) {
+            aggregator.setMethod(run.method);
+            aggregator.setThreadCount(run.threads);
+
+            PolygonStats stats = aggregator.compute(polygon);
+            if (run.method == PolygonMethod::Lookup) reference = stats;
+
+            const char* match = "-";
+            if (reference.count > 0 && run.method != PolygonMethod::Lookup) match = sameStats(stats, reference) ? "tak" : "NIE";
+
+            printf("  %-22s %10.2f  %6zu  %10llu  %10llu  %9llu  %7.1f  %7.1f  %8.2f  %11.1f  %10.1f  %s\n",
+                run.label, stats.ms, stats.tiles, (unsigned long long)stats.count, (unsigned long long)stats.scanned,
+                (unsigned long long)stats.blocks, stats.min, stats.max, stats.getMean(), stats.getQuantile(0.5), stats.area, match);
+        }
+
+        const float widths[] = { 1.0f, 10.0f, 50.0f, 100.0f, 0.0f };
+        printf("  Piramida, %u wątków, szerokość przedziału histogramu:\n", threads);
+
+        for (float width : widths) {
+            aggregator.setBinWidth(width);
+            aggregator.setMethod(PolygonMethod::Scan);
+            PolygonStats scan = aggregator.compute(polygon);
+
+            aggregator.setMethod(PolygonMethod::Pyramid);
+            PolygonStats stats = aggregator.compute(polygon);
+
+            bool same = sameStats(stats, scan);
+            printf("    %-7s  %8.2f ms (odcinki %8.2f ms)  przeczytano %5.1f%% próbek, %9llu bloków  %s\n",
+                width > 0.0f ? (std::to_string((int)width) + " m").c_str() : "bez", stats.ms, scan.ms, 100.0 * stats.scanned / std::max<uint64_t>(scan.scanned, 1),
+                (unsigned long long)stats.blocks, same ? "zgodne" : "NIEZGODNE");
+        }
+    }
+    else {
+        std::cerr << "Unknown benchmark: " << name << "\n";
+    }
+}
+
 int main(int argc, char *argv[]) {
+    auto usage = [argv]() {
+        std::cerr << "Usage: " << argv[0] << " <directory> [-lon <min> <max>] [-lat <min> <max>] [-start <longitude> <latitude> <elevation>] [-bench <name>] [-render <list>] [-serve <port>]\n";
+    };
     if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <directory> [-lon <min> <max>] [-lat <min> <max>] [-start <longitude> <latitude> <elevation>]\n";
+        usage();
         return 0;
     }
 
@@ -827,6 +2531,10 @@ int main(int argc, char *argv[]) {
     short latMin = 0, latMax = 0, lonMin = 0, lonMax = 0;
     bool startParameters = false;
     float latStart = 0.0f, lonStart = 0.0f, elevStart = 0.0f;
+    std::string benchmark = "", render = "", mesh_path = "";
+    float mesh_error = RtinBuilder::DEFAULT_ERROR;
+    MeshProjection mesh_projection = MeshProjection::Geographic;
+    int serve = -1;
 
     // Przetwarzanie pozostałych argumentów
     for (int i = 2; i < argc; ++i) {
@@ -863,16 +2571,61 @@ int main(int argc, char *argv[]) {
             }
 
             startParameters = true;
+        } else if (arg == "-bench" && i + 1 < argc) {
+            benchmark = argv[++i];
+        } else if (arg == "-render" && i + 1 < argc) {
+            render = argv[++i];
+        } else if (arg == "-serve" && i + 1 < argc) {
+            char const* value = argv[++i];
+            char* end = nullptr;
+            long number = std::strtol(value, &end, 10);
+
+            if (end == value || *end != '\0' || number < 0 || number > 65535) {
+                std::cerr << arg << ": Port must be a number in range [0, 65535], got \"" << value << "\".\n";
+                usage();
+                return 1;
+            }
+            serve = (int)number;
+        } else if (arg == "-export" && i + 2 < argc) {
+            MeshFormat format;
+            mesh_path  = argv[++i];
+            mesh_error = std::stof(argv[++i]);
+
+            if (!MeshExporter::parseFormat(mesh_path, format)) {
+                std::cerr << arg << ": File extension must be .obj, .stl or .gltf.\n";
+                return 1;
+            }
+            if (mesh_error < 0.0f) {
+                std::cerr << arg << ": Error bound must not be negative.\n";
+                return 1;
+            }
+            if (i + 1 < argc && MeshExporter::parseProjection(argv[i + 1], mesh_projection)) i++;
         } else {
             std::cerr << "Unknown or incomplete argument: " << arg << "\n";
             return 0;
         }
     }
 
+    // Obrazy rysowane poza oknem, serwer kafli i eksport siatki - okno (kontekst OpenGL) ukryte
+    if (!render.empty() || serve >= 0 || !mesh_path.empty()) {
+        glfwInit();
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    }
+
     MyGame win;
     win.Init(1600, 900,"AGL3 Terrain",0,33);
     win.InitSettings(latMin, latMax, lonMin, lonMax, directory);
     if (startParameters) win.SetStartPosition(latStart, lonStart, elevStart);
-    win.MainLoop();
+
+    if (!render.empty())
+        return win.Render(render) ? 0 : 1;
+    else if (serve >= 0)
+        win.Serve(serve);
+    else if (!mesh_path.empty())
+        return win.Export(mesh_path, mesh_error, mesh_projection) ? 0 : 1;
+    else if (!benchmark.empty())
+        win.Benchmark(benchmark);
+    else
+        win.MainLoop();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,275 @@
+// ==========================================================================
+// AdaptiveMesh: class definitions
+//
+// Michał Chawar
+// ==========================================================================
+// AdaptiveMesh
+// RtinBuilder
+//===========================================================================
+
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <cfloat>
+#include <chrono>
+#include <algorithm>
+
+
+// ----------------------------------------
+//
+//      ADAPTIVE MESH class
+//
+// ----------------------------------------
+
+// Indeksy siatki adaptacyjnej kafla (zob. RtinBuilder). Wierzchołki numerowane jak próbki w buforze
+// wysokości na GPU (bloki 1201 x 1201, zob. Tile::texelIndex) - cały kafel rysowany jednym wywołaniem.
+struct AdaptiveMesh {
+    std::vector<unsigned int> indices;
+    float error = 0.0f;             // Dopuszczalny błąd pionowy (m), dla którego zbudowano siatkę; 0 - brak siatki
+    float ms = 0.0f;                // Czas budowy
+
+    size_t getTriangles() const {
+        return this->indices.size() / 3;
+    }
+};
+
+
+// ----------------------------------------
+//
+//      RTIN BUILDER class
+//
+// ----------------------------------------
+
+// Siatka RTIN (right-triangulated irregular network, jak w bibliotece Martini): trójkąt prostokątny
+// dzielony jest na pół wzdłuż przeciwprostokątnej, dopóki błąd wysokości w jej środku (razem z błędami
+// trójkątów potomnych) przekracza zadany próg. Podział wymaga boku 2^k + 1 próbek - blok 1201 x 1201
+// dzielony jest na łatki PATCH x PATCH komórek, błędy wszystkich łatek liczone są we wspólnej tablicy
+// bloku (poziomami, od najmniejszych trójkątów), więc wierzchołki na krawędziach łatek są zgodne po obu
+// stronach. Krawędzie bloku mają zawsze pełną rozdzielczość - brak szczelin między blokami kafla 1"
+// i między kaflami o różnych siatkach.
+// Bez użycia OpenGL - może być wywoływany z dowolnego wątku.
+class RtinBuilder {
+public:
+    constexpr static int PATCH = 16;                    // Komórek na bok łatki (1200 = 75 * 16)
+    constexpr static float DEFAULT_ERROR = 5.0f;        // Domyślny błąd pionowy (m), zob. adaptive_mesh
+
+    // heights - wysokości w układzie bloków (zob. Tile::texelIndex), samples - próbek na bok kafla.
+    // Bok bloku niepodzielny na łatki - siatka pusta (rysowana siatka regularna).
+    static AdaptiveMesh build(float const* heights, int samples, float max_error) {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        AdaptiveMesh mesh;
+        mesh.error = max_error;
+
+        int side   = std::min(samples, 1201),
+            blocks = (samples - 1) / (side - 1);
+        if ((side - 1) % PATCH != 0) return mesh;
+
+        std::vector<float> errors((size_t)side * side);
+
+        for (int b = 0; b < blocks * blocks; b++) {
+            size_t base = (size_t)b * side * side;
+
+            computeErrors(heights + base, side, errors);
+
+            for (int pi = 0; pi < side - 1; pi += PATCH) {
+                for (int pj = 0; pj < side - 1; pj += PATCH) {
+                    size_t patch = (size_t)pi * side + pj;
+                    Extract extract{ errors.data() + patch, mesh.indices, side, (unsigned int)(base + patch), max_error };
+
+                    extract.triangle(0, 0, PATCH, PATCH, PATCH, 0);
+                    extract.triangle(PATCH, PATCH, 0, 0, 0, PATCH);
+                }
+            }
+        }
+
+        mesh.ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        return mesh;
+    }
+    // Największy błąd pionowy siatki względem wszystkich próbek pokrytych trójkątami (interpolacja
+    // liniowa w trójkącie). get(i, j) - wysokość próbki kafla; base - przesunięcie indeksów (numer
+    // pierwszej próbki bloku dla indeksów siatki regularnej jednego bloku).
+    template <class Get>
+    static float measureError(Get get, int samples, unsigned int const* indices, size_t count, size_t base = 0) {
+        int side   = std::min(samples, 1201),
+            blocks = (samples - 1) / (side - 1);
+        float worst = 0.0f;
+
+        auto position = [side, blocks](size_t v, int& i, int& j) {
+            size_t block = v / ((size_t)side * side), local = v % ((size_t)side * side);
+
+            i = (int)(block / blocks) * (side - 1) + (int)(local / side);
+            j = (int)(block % blocks) * (side - 1) + (int)(local % side);
+        };
+
+        for (size_t t = 0; t + 2 < count; t += 3) {
+            int i[3], j[3];
+            float h[3];
+            for (int k = 0; k < 3; k++) {
+                position(base + indices[t + k], i[k], j[k]);
+                h[k] = get(i[k], j[k]);
+            }
+
+            // Współrzędne barycentryczne na siatce całkowitej (trójkąty zdegenerowane pomijane)
+            int area = (j[1] - j[0]) * (i[2] - i[0]) - (j[2] - j[0]) * (i[1] - i[0]);
+            if (area == 0) continue;
+
+            int i0 = std::min({ i[0], i[1], i[2] }), i1 = std::max({ i[0], i[1], i[2] }),
+                j0 = std::min({ j[0], j[1], j[2] }), j1 = std::max({ j[0], j[1], j[2] });
+
+            for (int y = i0; y <= i1; y++) {
+                for (int x = j0; x <= j1; x++) {
+                    int w0 = (j[1] - x) * (i[2] - y) - (j[2] - x) * (i[1] - y),
+                        w1 = (j[2] - x) * (i[0] - y) - (j[0] - x) * (i[2] - y),
+                        w2 = area - w0 - w1;
+
+                    if (area > 0 ? (w0 < 0 || w1 < 0 || w2 < 0) : (w0 > 0 || w1 > 0 || w2 > 0)) continue;
+
+                    float interpolated = (w0 * h[0] + w1 * h[1] + w2 * h[2]) / area;
+                    worst = std::max(worst, std::abs(interpolated - get(y, x)));
+                }
+            }
+        }
+
+        return worst;
+    }
+private:
+    // Próbka pokryta trójkątem łatki (poza wierzchołkami) z wagami interpolacji wierzchołków a, b, c
+    struct Covered {
+        int x, y;
+        float wa, wb, wc;
+    };
+    // Trójkąt łatki: wierzchołki przeciwprostokątnej a, b i kąta prostego c (x - kolumna, y - wiersz),
+    // pokryte próbki: covered[first .. first + count)
+    struct Triangle {
+        int ax, ay, bx, by, cx, cy;
+        int first, count;
+    };
+    struct Table {
+        std::vector<Triangle> triangles;
+        std::vector<Covered>  covered;
+    };
+
+    // Trójkąty łatki w numeracji Martini (id = t + 2, kolejne bity - wybór połówki), od największych;
+    // wspólne dla wszystkich łatek
+    static Table const& table() {
+        static Table table = []() {
+            Table result;
+            result.triangles.resize(PATCH * PATCH * 2 - 2);
+
+            for (size_t t = 0; t < result.triangles.size(); t++) {
+                int id = (int)t + 2;
+                int ax = 0, ay = 0, bx = 0, by = 0, cx = 0, cy = 0;
+
+                if (id & 1) { bx = by = cx = PATCH; }
+                else        { ax = ay = cy = PATCH; }
+
+                while ((id >>= 1) > 1) {
+                    int mx = (ax + bx) >> 1, my = (ay + by) >> 1;
+
+                    if (id & 1) { bx = ax; by = ay; ax = cx; ay = cy; }
+                    else        { ax = bx; ay = by; bx = cx; by = cy; }
+                    cx = mx; cy = my;
+                }
+
+                int first = (int)result.covered.size();
+                int area  = (bx - ax) * (cy - ay) - (cx - ax) * (by - ay);
+
+                for (int y = std::min({ ay, by, cy }); y <= std::max({ ay, by, cy }); y++) {
+                    for (int x = std::min({ ax, bx, cx }); x <= std::max({ ax, bx, cx }); x++) {
+                        int wa = (bx - x) * (cy - y) - (cx - x) * (by - y),
+                            wb = (cx - x) * (ay - y) - (ax - x) * (cy - y),
+                            wc = area - wa - wb;
+
+                        bool inside = area > 0 ? (wa >= 0 && wb >= 0 && wc >= 0) : (wa <= 0 && wb <= 0 && wc <= 0);
+                        if (!inside || wa == area || wb == area || wc == area) continue;
+
+                        result.covered.push_back(Covered{ x, y, (float)wa / area, (float)wb / area, (float)wc / area });
+                    }
+                }
+                result.triangles[t] = Triangle{ ax, ay, bx, by, cx, cy, first, (int)result.covered.size() - first };
+            }
+            return result;
+        }();
+        return table;
+    }
+    // Błąd trójkąta - największa różnica między interpolacją w trójkącie a próbkami, które pokrywa -
+    // zapisywany w środku przeciwprostokątnej, razem z błędami potomków (środków przyprostokątnych).
+    // Trójkąt o błędzie ponad próg ma więc zawsze podzielony środek i siatka nie przekracza progu
+    // w żadnej próbce (sam błąd w środku przeciwprostokątnej, jak w Martini, tego nie gwarantuje).
+    // Trójkąty przetwarzane poziomami we wszystkich łatkach naraz - środek krawędzi łatki dostaje
+    // błędy z obu stron, zanim odczyta go rodzic. Krawędzie bloku - błąd nieskończony (zawsze dzielone).
+    static void computeErrors(float const* heights, int side, std::vector<float>& errors) {
+        std::fill(errors.begin(), errors.end(), 0.0f);
+
+        int last = side - 1;
+        for (int k = 0; k < side; k++) {
+            errors[k] = errors[(size_t)last * side + k] = FLT_MAX;
+            errors[(size_t)k * side] = errors[(size_t)k * side + last] = FLT_MAX;
+        }
+
+        Table const& table = RtinBuilder::table();
+        int parents = (int)table.triangles.size() - PATCH * PATCH;
+
+        std::vector<int> offsets(table.covered.size());
+        for (size_t k = 0; k < offsets.size(); k++) offsets[k] = table.covered[k].y * side + table.covered[k].x;
+
+        for (int t = (int)table.triangles.size() - 1; t >= 0; t--) {
+            Triangle const& tr = table.triangles[t];
+            int mx = (tr.ax + tr.bx) >> 1, my = (tr.ay + tr.by) >> 1;
+
+            int a = tr.ay * side + tr.ax,
+                b = tr.by * side + tr.bx,
+                c = tr.cy * side + tr.cx,
+                m = my * side + mx,
+                l = ((tr.ay + tr.cy) >> 1) * side + ((tr.ax + tr.cx) >> 1),
+                r = ((tr.by + tr.cy) >> 1) * side + ((tr.bx + tr.cx) >> 1);
+
+            Covered const* covered = table.covered.data() + tr.first;
+            int const*     offset  = offsets.data() + tr.first;
+
+            for (int pi = 0; pi < last; pi += PATCH) {
+                for (int pj = 0; pj < last; pj += PATCH) {
+                    size_t base = (size_t)pi * side + pj;
+                    float const* h = heights + base;
+                    float* e = errors.data() + base;
+
+                    float ha = h[a], hb = h[b], hc = h[c];
+                    float error = e[m];
+
+                    for (int k = 0; k < tr.count; k++) {
+                        float interpolated = covered[k].wa * ha + covered[k].wb * hb + covered[k].wc * hc;
+                        error = std::max(error, std::abs(interpolated - h[offset[k]]));
+                    }
+                    if (t < parents) error = std::max({ error, e[l], e[r] });
+                    e[m] = error;
+                }
+            }
+        }
+    }
+
+    struct Extract {
+        float const* errors;                // Błędy od narożnika łatki
+        std::vector<unsigned int>& indices;
+        int side;
+        unsigned int base;                  // Numer narożnika łatki w buforze wysokości
+        float max_error;
+
+        // Wierzchołki zapisywane jako a, c, b - przeciwnie do ruchu wskazówek zegara (wschód, północ),
+        // jak w siatce regularnej
+        void triangle(int ax, int ay, int bx, int by, int cx, int cy) {
+            int mx = (ax + bx) >> 1, my = (ay + by) >> 1;
+
+            if (std::abs(ax - cx) + std::abs(ay - cy) > 1 && this->errors[my * this->side + mx] > this->max_error) {
+                this->triangle(cx, cy, ax, ay, mx, my);
+                this->triangle(bx, by, cx, cy, mx, my);
+                return;
+            }
+
+            this->indices.push_back(this->base + ay * this->side + ax);
+            this->indices.push_back(this->base + cy * this->side + cx);
+            this->indices.push_back(this->base + by * this->side + bx);
+        }
+    };
+};
@@ -0,0 +1,787 @@
+// ==========================================================================
+// Contours: class definitions
+//
+// Michał Chawar
+// ==========================================================================
+// ContourLine
+// ContourSet
+// ContourTracer
+// ContourGeometry
+// ContourStats
+// ContourCache
+// ContourLayer
+//===========================================================================
+
+#pragma once
+
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <set>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+#include <climits>
+
+#include <glm/glm.hpp>
+
+#include <TileManager.hpp>
+
+
+// ----------------------------------------
+//
+//      CONTOUR SET class
+//
+// ----------------------------------------
+
+// Polilinia warstwicy w obrębie jednego kafla: punkty ContourSet::points[first .. first + count)
+struct ContourLine {
+    uint32_t first = 0, count = 0;
+    float level = 0.0f;             // Wysokość warstwicy (m)
+    uint64_t head = 0, tail = 0;    // Klucze końców na krawędzi kafla (zob. ContourTracer::borderKey), 0 - brak (linia zamknięta)
+};
+
+// Warstwice jednego kafla dla jednego odstępu
+struct ContourSet {
+    std::vector<glm::vec2> points;  // (lon, lat) w stopniach
+    std::vector<ContourLine> lines;
+    float interval = 0.0f;
+    size_t segments = 0;            // Odcinki z komórek przed połączeniem
+    float ms = 0.0f;                // Czas śledzenia
+};
+
+
+// ----------------------------------------
+//
+//      CONTOUR TRACER class
+//
+// ----------------------------------------
+
+// Warstwice kafla metodą marching squares. Próbka jest nad warstwicą, gdy h >= poziom; punkt
+// przecięcia interpolowany liniowo wzdłuż krawędzi komórki (zawsze od próbki o mniejszym indeksie,
+// więc obie komórki - i oba kafle na wspólnej krawędzi - dają ten sam punkt). Odcinki skierowane
+// tak, by wyższy teren był po lewej - każdy punkt wewnątrz kafla ma dokładnie jeden odcinek
+// wchodzący i jeden wychodzący, co pozwala łączyć je w polilinie bez szukania w obu kierunkach.
+// Komórki siodłowe rozstrzygane średnią czterech narożników. Komórki z brakiem danych pomijane.
+// Bez użycia OpenGL - może być wywoływany z dowolnego wątku.
+class ContourTracer {
+public:
+    static ContourSet trace(Tile const& tile, float interval) {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        ContourSet result;
+        result.interval = interval;
+
+        int n = tile.getSamples(), last = n - 1;
+        if (interval <= 0.0f || 3600 % last != 0) return result;
+
+        // Odcinek w komórce (i, j) między krawędziami from i to (0 - dolna, 1 - prawa, 2 - górna, 3 - lewa).
+        // Odcinki powstają wierszami i kolumnami komórek - odcinki komórki leżą obok siebie.
+        struct Segment {
+            int i, j, level;
+            uint8_t from, to;
+            glm::vec2 end;                  // Punkt na krawędzi to (zob. crossing)
+        };
+        std::vector<Segment> segments;
+        segments.reserve((size_t)last * 64);
+        std::vector<size_t> rows(n, 0);     // Pierwszy odcinek wiersza komórek (rows[last] - koniec)
+        bool missing = false;               // Komórki z brakiem danych
+
+        // Wysokości dwóch wierszy próbek i ich przedziały (floor(h / interval), INT_MIN - brak danych):
+        // komórka przecina warstwice tylko przy różnych przedziałach narożników
+        std::vector<float> below(n), above(n);
+        std::vector<int> below_band(n), above_band(n);
+
+        auto readRow = [&tile, interval, n](int i, std::vector<float>& heights, std::vector<int>& bands) {
+            for (int j = 0; j < n; j++) {
+                heights[j] = tile.getSample(i, j);
+                bands[j] = heights[j] <= Tile::NO_DATA ? INT_MIN : (int)std::floor(heights[j] / interval);
+            }
+        };
+        readRow(0, above, above_band);
+
+        for (int i = 0; i < last; i++) {
+            rows[i] = segments.size();
+
+            std::swap(below, above);
+            std::swap(below_band, above_band);
+            readRow(i + 1, above, above_band);
+
+            for (int j = 0; j < last; j++) {
+                int b[4] = { below_band[j], below_band[j + 1], above_band[j + 1], above_band[j] };
+                int k0 = std::min({ b[0], b[1], b[2], b[3] }),
+                    k1 = std::max({ b[0], b[1], b[2], b[3] });
+
+                if (k0 == INT_MIN) missing = true;
+                if (k0 == k1 || k0 == INT_MIN) continue;
+
+                // Narożniki przeciwnie do ruchu wskazówek zegara od południowo-zachodniego;
+                // poziomy w (min, max] - co najmniej jeden narożnik pod i jeden nad warstwicą
+                float h[4] = { below[j], below[j + 1], above[j + 1], above[j] };
+
+                for (int k = k0 + 1; k <= k1; k++) {
+                    float level = k * interval;
+                    bool up[4] = { h[0] >= level, h[1] >= level, h[2] >= level, h[3] >= level };
+
+                    // Wzdłuż obwodu: krawędzie ze spadkiem poniżej warstwicy i z powrotem nad nią
+                    int falls[2], rises[2], nf = 0, nr = 0;
+                    for (int e = 0; e < 4; e++) {
+                        if ( up[e] && !up[(e + 1) & 3]) falls[nf++] = e;
+                        if (!up[e] &&  up[(e + 1) & 3]) rises[nr++] = e;
+                    }
+
+                    if (nf == 0) continue;      // Zaokrąglenie h / interval na granicy przedziału
+                    if (nf == 1) {
+                        segments.push_back(Segment{ i, j, k, (uint8_t)falls[0], (uint8_t)rises[0], crossing(h, rises[0], level, i, j) });
+                        continue;
+                    }
+
+                    // Siodło: środek nad warstwicą łączy wyższe narożniki - odcinki odcinają niższe
+                    bool center = (h[0] + h[1] + h[2] + h[3]) * 0.25f >= level;
+                    for (int c = 0; c < 2; c++) {
+                        int to = (falls[c] + (center ? 1 : 3)) & 3;
+                        segments.push_back(Segment{ i, j, k, (uint8_t)falls[c], (uint8_t)to, crossing(h, to, level, i, j) });
+                    }
+                }
+            }
+        }
+        rows[last] = segments.size();
+        result.segments = segments.size();
+
+        // Odcinek sąsiedniej komórki (przez krawędź side komórki (i, j)) na tym samym poziomie, zaczynający się
+        // (outgoing) lub kończący na tej krawędzi; -1 - brak (krawędź kafla, brak danych) lub już użyty
+        std::vector<uint8_t> used(segments.size(), 0);
+        auto across = [&](size_t index, int side, bool outgoing) -> ptrdiff_t {
+            const int di[4] = { -1, 0, 1, 0 }, dj[4] = { 0, 1, 0, -1 };
+            Segment const& s = segments[index];
+            int i = s.i + di[side], j = s.j + dj[side], match = (side + 2) & 3;
+            if (i < 0 || i >= last || j < 0 || j >= last) return -1;
+
+            auto matches = [&](size_t t) {
+                return segments[t].j == j && segments[t].level == s.level && (outgoing ? segments[t].from : segments[t].to) == match;
+            };
+            auto result = [&used](size_t t) -> ptrdiff_t {
+                return used[t] ? -1 : (ptrdiff_t)t;
+            };
+
+            // Sąsiad w tym samym wierszu - odcinki tuż obok, w innym - wyszukiwanie w wierszu
+            if (side == 1) {
+                for (size_t t = index + 1; t < rows[i + 1] && segments[t].j <= j; t++)
+                    if (matches(t)) return result(t);
+                return -1;
+            }
+            if (side == 3) {
+                for (size_t t = index; t-- > rows[i] && segments[t].j >= j; )
+                    if (matches(t)) return result(t);
+                return -1;
+            }
+
+            auto begin = segments.begin() + rows[i], end = segments.begin() + rows[i + 1];
+            auto it = std::lower_bound(begin, end, j, [](Segment const& a, int j) { return a.j < j; });
+
+            for (size_t t = it - segments.begin(); t < rows[i + 1] && segments[t].j == j; t++)
+                if (matches(t)) return result(t);
+            return -1;
+        };
+
+        float lon0 = tile.origin.longitude.getDegreesSigned(),
+              lat0 = tile.origin.latitude .getDegreesSigned();
+        auto point = [lon0, lat0, last](glm::vec2 p) {
+            return glm::vec2(lon0 + p.x / last, lat0 + p.y / last);
+        };
+
+        auto emit = [&](size_t s) {
+            Segment const& first = segments[s];
+
+            ContourLine line;
+            line.first = (uint32_t)result.points.size();
+            line.level = first.level * interval;
+
+            float h[4] = { tile.getSample(first.i, first.j),     tile.getSample(first.i, first.j + 1),
+                           tile.getSample(first.i + 1, first.j + 1), tile.getSample(first.i + 1, first.j) };
+            result.points.push_back(point(crossing(h, first.from, line.level, first.i, first.j)));
+
+            ptrdiff_t c = (ptrdiff_t)s, end = c;
+            for (; c >= 0; c = across(c, segments[c].to, true)) {
+                used[c] = 1;
+                end = c;
+                result.points.push_back(point(segments[c].end));
+            }
+
+            uint64_t from = pointKey(first.level, edgeIndex(first.i, first.j, first.from, n)),
+                     to   = pointKey(first.level, edgeIndex(segments[end].i, segments[end].j, segments[end].to, n));
+
+            line.count = (uint32_t)result.points.size() - line.first;
+            if (to != from) {
+                line.head = borderKey(tile, from);
+                line.tail = borderKey(tile, to);
+            }
+            result.lines.push_back(line);
+        };
+
+        // Najpierw linie otwarte - początek bez odcinka wchodzącego, możliwy tylko na krawędzi kafla lub
+        // komórki z brakiem danych; pozostałe odcinki tworzą pętle
+        auto open = [&](size_t index) {
+            Segment const& s = segments[index];
+            if (s.i == 0 || s.i == last - 1 || s.j == 0 || s.j == last - 1 || missing)
+                return across(index, s.from, false) < 0;
+            return false;
+        };
+        for (size_t s = 0; s < segments.size(); s++) {
+            if (!used[s] && open(s)) emit(s);
+        }
+        for (size_t s = 0; s < segments.size(); s++) {
+            if (!used[s]) emit(s);
+        }
+
+        result.ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        return result;
+    }
+private:
+    constexpr static int LEVEL_OFFSET = 1 << 20;
+
+    // Krawędź komórki (i, j): 2 * numer próbki początkowej, +1 - krawędź pionowa (w stronę północy)
+    static uint32_t edgeIndex(int i, int j, int side, int n) {
+        switch (side) {
+            case 0:  return ((uint32_t)i * n + j) * 2;
+            case 1:  return ((uint32_t)i * n + j + 1) * 2 + 1;
+            case 2:  return ((uint32_t)(i + 1) * n + j) * 2;
+            default: return ((uint32_t)i * n + j) * 2 + 1;
+        }
+    }
+    // Punkt przecięcia w kaflu: numer poziomu (wysokość / odstęp) i krawędź komórki (zob. edgeIndex)
+    static uint64_t pointKey(int level, uint32_t edge) {
+        return ((uint64_t)(level + LEVEL_OFFSET) << 32) | edge;
+    }
+    static int levelOf(uint64_t key) {
+        return (int)(key >> 32) - LEVEL_OFFSET;
+    }
+    // Punkt przecięcia warstwicy z krawędzią side komórki (i, j) o narożnikach h (jak w trace), w próbkach
+    // od narożnika kafla. Interpolacja zawsze od próbki południowej / zachodniej - wynik zależy tylko od
+    // krawędzi, nie od komórki, z której jest liczony.
+    static glm::vec2 crossing(float const h[4], int side, float level, int i, int j) {
+        switch (side) {
+            case 0:  return glm::vec2(j + (level - h[0]) / (h[1] - h[0]), i);
+            case 1:  return glm::vec2(j + 1, i + (level - h[1]) / (h[2] - h[1]));
+            case 2:  return glm::vec2(j + (level - h[3]) / (h[2] - h[3]), i + 1);
+            default: return glm::vec2(j, i + (level - h[0]) / (h[3] - h[0]));
+        }
+    }
+    // Klucz punktu na krawędzi kafla niezależny od kafla: poziom, kierunek krawędzi komórki i położenie
+    // jej początku w sekundach łuku (zgodny po obu stronach przy tej samej rozdzielczości kafli).
+    // 0 - punkt wewnątrz kafla.
+    static uint64_t borderKey(Tile const& tile, uint64_t key) {
+        int n = tile.getSamples(), last = n - 1;
+        uint32_t edge = (uint32_t)key, cell = edge >> 1;
+        bool vertical = edge & 1;
+        int i = cell / n, j = cell % n;
+
+        if (vertical ? (j != 0 && j != last) : (i != 0 && i != last)) return 0;
+
+        int step = 3600 / last;
+        int64_t lat = tile.origin.latitude .getDegreesSigned() * 3600 + i * step + (1 << 19),
+                lon = tile.origin.longitude.getDegreesSigned() * 3600 + j * step + (1 << 20);
+
+        return (uint64_t)1 << 63
+             | (uint64_t)(levelOf(key) + LEVEL_OFFSET) << 42
+             | (uint64_t)vertical << 41
+             | (uint64_t)lat << 21
+             | (uint64_t)lon;
+    }
+};
+
+
+// ----------------------------------------
+//
+//      CONTOUR CACHE class
+//
+// ----------------------------------------
+
+// Warstwice widocznych kafli połączone przez krawędzie kafli, gotowe do glMultiDrawArrays(GL_LINE_STRIP)
+struct ContourGeometry {
+    std::vector<glm::vec3> points;  // (lon, lat, poziom)
+    std::vector<GLint>   firsts;
+    std::vector<GLsizei> counts;
+};
+
+struct ContourStats {
+    size_t tiles = 0;               // Kafli w zestawie
+    size_t traced = 0;              // Kafli śledzonych w tej aktualizacji (brak w pamięci podręcznej)
+    size_t segments = 0;            // Odcinki śledzonych kafli
+    size_t lines = 0, points = 0;   // Wynikowe polilinie i punkty
+    size_t joined = 0;              // Połączenia linii na krawędziach kafli
+    unsigned int threads = 0;
+    double trace_ms = 0.0;          // Śledzenie brakujących kafli (czas rzeczywisty)
+    double tile_ms = 0.0;           // Suma czasów śledzenia kafli
+    double stitch_ms = 0.0;         // Łączenie i zestawienie geometrii
+};
+
+// Warstwice kafli w pamięci podręcznej (kafel i odstęp, najdawniej użyte usuwane po przekroczeniu
+// pojemności). Brakujące kafle śledzone w stałej puli wątków roboczych, po jednym kaflu na wątek naraz;
+// po wyśledzeniu wszystkich kafli zestawu końce linii na krawędziach kafli łączone (po kluczach
+// ContourTracer) także w wątku roboczym - wywołujący (pętla główna) nie czeka: request zleca zestaw,
+// collect odbiera gotowe kafle i geometrię, do tego czasu getGeometry zwraca poprzednią geometrię.
+// Kafle o różnej rozdzielczości nie mają wspólnych kluczy - linie kończą się wtedy na krawędzi.
+// Kafle (Tile const*) muszą istnieć do zakończenia ich śledzenia (zob. destruktor).
+// Bez użycia OpenGL.
+class ContourCache {
+public:
+    constexpr static size_t DEFAULT_CAPACITY = 256;     // Zestawów (kafel, odstęp)
+
+    ContourCache(unsigned int threads = 0) {
+        this->setThreads(threads);
+    }
+    ~ContourCache() {
+        this->stopPool();
+    }
+    ContourCache(ContourCache const&) = delete;
+    ContourCache& operator=(ContourCache const&) = delete;
+
+    // 0 - liczba wątków sprzętowych; zmiana zatrzymuje pulę (po zakończeniu bieżących zadań)
+    void setThreads(unsigned int threads) {
+        threads = threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+        if (threads == this->threads) return;
+
+        this->stopPool();
+        this->threads = threads;
+    }
+    unsigned int getThreads() const {
+        return this->threads;
+    }
+    void setCapacity(size_t capacity) {
+        this->capacity = capacity;
+    }
+    // Usuwa zestawy, zlecenia i geometrię; kafle śledzone w tej chwili trafią do pamięci po zakończeniu
+    void clear() {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->queue.clear();
+            this->traced.clear();
+            this->stitch_job.reset();
+            this->stitched.reset();
+            this->generation++;
+        }
+        this->entries.clear();
+        this->visible.clear();
+        this->wanted.clear();
+        this->visible_interval = this->wanted_interval = 0.0f;
+        this->stitch_requested = false;
+        this->geometry = ContourGeometry();
+    }
+    size_t size() const {
+        return this->entries.size();
+    }
+
+    // Zlecenie warstwic kafli tiles co interval metrów (bez czekania); ten sam zestaw co ostatnio - bez zmian
+    void request(std::vector<Tile*> const& tiles, float interval) {
+        std::vector<std::string> keys;
+        for (Tile const* tile : tiles) keys.push_back(tile->origin.getTileString());
+        std::sort(keys.begin(), keys.end());
+
+        if (keys == this->wanted && interval == this->wanted_interval) return;
+
+        this->wanted = keys;
+        this->wanted_interval = interval;
+        this->wanted_tiles = tiles;
+        this->stitch_requested = false;
+        this->frame++;
+        this->request_start = std::chrono::high_resolution_clock::now();
+
+        this->pending = ContourStats();
+        this->pending.tiles   = tiles.size();
+        this->pending.threads = this->threads;
+
+        // Kolejka tylko z brakujących kafli bieżącego zestawu - zlecenia poprzednich zestawów porzucane
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->queue.clear();
+        this->stitch_job.reset();
+        this->generation++;
+
+        for (Tile const* tile : tiles) {
+            Key key{ tile->origin.getTileString(), interval };
+
+            auto it = this->entries.find(key);
+            if (it != this->entries.end()) it->second.used = this->frame;
+            else if (this->in_flight.count(key) == 0 && !this->isTraced(key)) this->queue.push_back( Job{ key, tile } );
+        }
+
+        if (this->pool.empty() && !this->queue.empty()) this->startPool();
+        this->condition.notify_all();
+    }
+    // Odbiór wyśledzonych kafli i geometrii; wait - czekaj na geometrię zleconego zestawu.
+    // true - nowa geometria (getGeometry) od poprzedniego wywołania
+    bool collect(bool wait = false) {
+        bool changed = false;
+
+        while (true) {
+            // Wszystkie kafle zestawu już w pamięci (np. powrót widoku) - łączenie od razu
+            if (!this->stitch_requested && !this->isCurrent()) this->requestStitch();
+
+            std::vector<std::pair<Key, ContourSet>> results;
+            std::unique_ptr<Stitched> result;
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                if (wait && !this->isCurrent() && this->pool.empty()) this->startPool();
+                if (wait && !this->isCurrent()) this->done.wait(lock, [this]() { return !this->traced.empty() || this->stitched != nullptr; });
+
+                results.swap(this->traced);
+                result.swap(this->stitched);
+            }
+
+            for (auto& [key, set] : results) {
+                if (key.interval == this->wanted_interval) {
+                    this->pending.traced++;
+                    this->pending.segments += set.segments;
+                    this->pending.tile_ms  += set.ms;
+                }
+                this->entries[key] = Entry{ std::make_shared<ContourSet const>(std::move(set)), this->frame };
+            }
+
+            // Geometria zestawu zleconego później niż ten, który ją zlecił, jest odrzucana
+            if (result != nullptr && result->generation == this->generation) {
+                this->geometry = std::move(result->geometry);
+                this->visible  = this->wanted;
+                this->visible_interval = this->wanted_interval;
+
+                this->stats = this->pending;
+                this->stats.stitch_ms = result->stats.stitch_ms;
+                this->stats.lines     = result->stats.lines;
+                this->stats.points    = result->stats.points;
+                this->stats.joined    = result->stats.joined;
+                changed = true;
+            }
+
+            if (!this->stitch_requested && !this->isCurrent()) this->requestStitch();
+            if (!wait || this->isCurrent()) return changed;
+        }
+    }
+    // Zlecenie i czekanie na geometrię (pomiary); false - zestaw kafli i odstęp bez zmian
+    bool update(std::vector<Tile*> const& tiles, float interval) {
+        this->request(tiles, interval);
+        return this->collect(true);
+    }
+    ContourGeometry const& getGeometry() const {
+        return this->geometry;
+    }
+    // Odstęp warstwic bieżącej geometrii (do czasu odebrania nowej - poprzedni)
+    float getGeometryInterval() const {
+        return this->visible_interval;
+    }
+    ContourStats const& getStats() const {
+        return this->stats;
+    }
+private:
+    struct Key {
+        std::string tile;
+        float interval;
+
+        bool operator<(Key const& other) const {
+            return this->tile != other.tile ? this->tile < other.tile : this->interval < other.interval;
+        }
+    };
+    struct Entry {
+        std::shared_ptr<ContourSet const> set;      // Współdzielony z łączeniem w wątku roboczym
+        uint64_t used = 0;          // Numer ostatniego zlecenia, w którym kafel był w zestawie
+    };
+    struct Job {
+        Key key;
+        Tile const* tile;
+    };
+    struct StitchJob {
+        std::vector<std::shared_ptr<ContourSet const>> sets;
+        uint64_t generation;
+    };
+    struct Stitched {
+        ContourGeometry geometry;
+        ContourStats stats;
+        uint64_t generation;
+    };
+
+    unsigned int threads = 0;
+    size_t capacity = DEFAULT_CAPACITY;
+    uint64_t frame = 0;
+    uint64_t generation = 0;        // Numer zlecenia (zmieniany pod mutex) - łączenie starszego zestawu odrzucane
+
+    // Stan wątku wywołującego
+    std::map<Key, Entry> entries;
+    std::vector<std::string> visible, wanted;
+    std::vector<Tile*> wanted_tiles;
+    float visible_interval = 0.0f, wanted_interval = 0.0f;
+    bool stitch_requested = false;
+    std::chrono::high_resolution_clock::time_point request_start;
+
+    ContourGeometry geometry;
+    ContourStats stats, pending;
+
+    // Pula wątków roboczych (chronione przez mutex)
+    std::vector<std::thread> pool;
+    std::mutex mutex;
+    std::condition_variable condition, done;
+    std::deque<Job> queue;
+    std::set<Key> in_flight;
+    std::vector<std::pair<Key, ContourSet>> traced;
+    std::unique_ptr<StitchJob> stitch_job;
+    std::unique_ptr<Stitched> stitched;
+    bool stopping = false;
+
+    // Kafel wyśledzony, jeszcze nieodebrany (wywoływane pod mutex)
+    bool isTraced(Key const& key) const {
+        return std::any_of(this->traced.begin(), this->traced.end(), [&key](auto const& t) { return t.first.tile == key.tile && t.first.interval == key.interval; });
+    }
+    bool isCurrent() const {
+        return this->visible == this->wanted && this->visible_interval == this->wanted_interval;
+    }
+    // Łączenie zlecane, gdy wszystkie kafle zestawu są w pamięci podręcznej
+    void requestStitch() {
+        auto job = std::make_unique<StitchJob>();
+        job->generation = this->generation;
+
+        for (Tile const* tile : this->wanted_tiles) {
+            auto it = this->entries.find( Key{ tile->origin.getTileString(), this->wanted_interval } );
+            if (it == this->entries.end()) return;
+
+            it->second.used = this->frame;
+            job->sets.push_back(it->second.set);
+        }
+        this->pending.trace_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - this->request_start).count();
+        this->stitch_requested = true;
+        this->evict();
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stitch_job = std::move(job);
+        if (this->pool.empty()) this->startPool();
+        this->condition.notify_one();
+    }
+
+    void startPool() {
+        for (unsigned int k = 0; k < this->threads; k++) {
+            this->pool.emplace_back([this]() {
+                std::unique_lock<std::mutex> lock(this->mutex);
+
+                while (true) {
+                    this->condition.wait(lock, [this]() { return this->stopping || !this->queue.empty() || this->stitch_job != nullptr; });
+                    if (this->stopping) return;
+
+                    if (!this->queue.empty()) {
+                        Job job = std::move(this->queue.front());
+                        this->queue.pop_front();
+                        this->in_flight.insert(job.key);
+
+                        lock.unlock();
+                        ContourSet set = ContourTracer::trace(*job.tile, job.key.interval);
+                        lock.lock();
+
+                        this->in_flight.erase(job.key);
+                        this->traced.emplace_back(std::move(job.key), std::move(set));
+                    }
+                    else {
+                        std::unique_ptr<StitchJob> job = std::move(this->stitch_job);
+
+                        lock.unlock();
+                        auto result = std::make_unique<Stitched>();
+                        result->generation = job->generation;
+                        stitch(job->sets, result->geometry, result->stats);
+                        job.reset();
+                        lock.lock();
+
+                        if (result->generation == this->generation) this->stitched = std::move(result);
+                    }
+                    this->done.notify_all();
+                }
+            });
+        }
+    }
+    // Czeka na zakończenie bieżących zadań; niewykonane zostają w kolejce (pula uruchamiana przy następnym zleceniu)
+    void stopPool() {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->stopping = true;
+        }
+        this->condition.notify_all();
+
+        for (std::thread& thread : this->pool) thread.join();
+        this->pool.clear();
+        this->stopping = false;
+    }
+
+    // Linie otwarte łączone w łańcuchy: koniec linii = początek następnej (inny kafel, ten sam poziom).
+    // Punkt wspólny pomijany w kolejnej linii. Łańcuchy zamknięte (przez kilka kafli) na końcu.
+    static void stitch(std::vector<std::shared_ptr<ContourSet const>> const& sets, ContourGeometry& g, ContourStats& stats) {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        struct Ref {
+            uint32_t set, line;
+        };
+        std::unordered_map<uint64_t, Ref> heads;
+        std::unordered_set<uint64_t> tails;
+        std::vector<std::vector<uint8_t>> visited(sets.size());
+
+        for (uint32_t s = 0; s < sets.size(); s++) {
+            visited[s].assign(sets[s]->lines.size(), 0);
+
+            for (uint32_t l = 0; l < sets[s]->lines.size(); l++) {
+                ContourLine const& line = sets[s]->lines[l];
+
+                if (line.head != 0) heads[line.head] = Ref{ s, l };
+                if (line.tail != 0) tails.insert(line.tail);
+            }
+        }
+
+        g = ContourGeometry();
+
+        size_t points = 0, lines = 0;
+        for (auto const& set : sets) {
+            points += set->points.size();
+            lines  += set->lines.size();
+        }
+        g.points.reserve(points);
+        g.firsts.reserve(lines);
+        g.counts.reserve(lines);
+
+        auto chain = [&](Ref ref) {
+            GLint first = (GLint)g.points.size();
+            bool continuation = false;
+
+            while (true) {
+                ContourSet  const& set  = *sets[ref.set];
+                ContourLine const& line = set.lines[ref.line];
+                visited[ref.set][ref.line] = 1;
+
+                for (uint32_t p = continuation ? 1 : 0; p < line.count; p++)
+                    g.points.push_back(glm::vec3(set.points[line.first + p], line.level));
+
+                if (line.tail == 0) break;
+
+                auto it = heads.find(line.tail);
+                if (it == heads.end() || visited[it->second.set][it->second.line]) break;
+
+                ref = it->second;
+                continuation = true;
+                stats.joined++;
+            }
+
+            g.firsts.push_back(first);
+            g.counts.push_back((GLsizei)g.points.size() - first);
+        };
+
+        for (uint32_t s = 0; s < sets.size(); s++) {
+            for (uint32_t l = 0; l < sets[s]->lines.size(); l++) {
+                ContourLine const& line = sets[s]->lines[l];
+                if (!visited[s][l] && (line.head == 0 || tails.count(line.head) == 0)) chain(Ref{ s, l });
+            }
+        }
+        for (uint32_t s = 0; s < sets.size(); s++) {
+            for (uint32_t l = 0; l < sets[s]->lines.size(); l++) {
+                if (!visited[s][l]) chain(Ref{ s, l });
+            }
+        }
+
+        stats.lines  = g.firsts.size();
+        stats.points = g.points.size();
+        stats.stitch_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+    // Usuwa najdawniej użyte zestawy spoza bieżącego zestawu kafli ponad pojemność
+    void evict() {
+        if (this->entries.size() <= this->capacity) return;
+
+        std::vector<std::pair<uint64_t, Key>> order;
+        for (auto const& [key, entry] : this->entries) {
+            if (entry.used != this->frame) order.push_back({ entry.used, key });
+        }
+        std::sort(order.begin(), order.end(), [](auto const& a, auto const& b) { return a.first < b.first; });
+
+        for (size_t k = 0; k < order.size() && this->entries.size() > this->capacity; k++)
+            this->entries.erase(order[k].second);
+    }
+};
+
+
+// ----------------------------------------
+//
+//      CONTOUR LAYER class
+//
+// ----------------------------------------
+
+// Warstwice na widoku 2D rysowane liniami nad kaflami (co piąta - warstwica zasadnicza - ciemniejsza)
+class ContourLayer : public AGLDrawable {
+public:
+    constexpr static float INTERVALS[] = { 10.0f, 20.0f, 50.0f, 100.0f, 200.0f, 500.0f };
+
+    ContourLayer() : AGLDrawable(0) {
+        compileShadersFromFile("shaders/contour.vs", "shaders/contour.fs");
+    }
+
+    void setEnabled(bool enabled) {
+        this->enabled = enabled;
+    }
+    bool isEnabled() const {
+        return this->enabled;
+    }
+    void setInterval(float interval) {
+        this->interval = interval;
+    }
+    float getInterval() const {
+        return this->interval;
+    }
+    // Następny odstęp z INTERVALS (po ostatnim - pierwszy)
+    void nextInterval() {
+        size_t count = sizeof(INTERVALS) / sizeof(INTERVALS[0]);
+        size_t k = std::find(INTERVALS, INTERVALS + count, this->interval) - INTERVALS;
+
+        this->interval = INTERVALS[ (k + 1) % count ];
+    }
+    ContourCache& getCache() {
+        return this->cache;
+    }
+    ContourStats const& getStats() const {
+        return this->cache.getStats();
+    }
+
+    // Warstwice kafli tiles (zwykle TileManager::getTilesInRange) śledzone w tle, co klatkę bez czekania -
+    // do czasu nowej geometrii rysowana poprzednia; true - geometria zbudowana na nowo
+    bool update(std::vector<Tile*> const& tiles) {
+        this->cache.request(tiles, this->interval);
+        if (!this->cache.collect()) return false;
+
+        ContourGeometry const& g = this->cache.getGeometry();
+
+        bindBuffers();
+        glBufferData(GL_ARRAY_BUFFER, g.points.size() * sizeof(glm::vec3), g.points.data(), GL_DYNAMIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+
+        return true;
+    }
+    void draw(glm::mat4 const& view, glm::mat4 const& projection, float x_condensation) {
+        ContourGeometry const& g = this->cache.getGeometry();
+        if (g.firsts.empty()) return;
+
+        bindProgram();
+        bindBuffers();
+
+        glUniform1f(4, x_condensation);
+        glUniform1f(5, this->cache.getGeometryInterval());
+        glUniformMatrix4fv(14, 1, GL_FALSE, glm::value_ptr(view));
+        glUniformMatrix4fv(15, 1, GL_FALSE, glm::value_ptr(projection));
+
+        // Linie w płaszczyźnie kafli - bez testu głębokości
+        GLboolean depth = glIsEnabled(GL_DEPTH_TEST);
+        glDisable(GL_DEPTH_TEST);
+
+        glMultiDrawArrays(GL_LINE_STRIP, g.firsts.data(), g.counts.data(), (GLsizei)g.firsts.size());
+
+        if (depth) glEnable(GL_DEPTH_TEST);
+    }
+private:
+    ContourCache cache;
+    bool enabled = false;
+    float interval = 20.0f;
+};
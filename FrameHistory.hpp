@@ -1,15 +1,18 @@
 // ==========================================================================
-// FrameHistory: class definition
+// FrameHistory: class definitions
 //
 // Michał Chawar
 // ==========================================================================
 // FrameHistory
+// GpuFrameTimer
 //===========================================================================
 
 #pragma once
 
 #include <iostream>
 
+#include <epoxy/gl.h>
+
 class FrameHistory {
 private:
     unsigned int capacity;       // Maksymalna liczba przechowywanych klatek
@@ -70,3 +73,47 @@ public:
         currentIndex = (currentIndex + 1) % capacity;
     }
 };
+
+// Czas klatki na GPU (GL_TIME_ELAPSED): begin/end wokół całej klatki w pętli głównej. Dwa zapytania
+// naprzemiennie - wynik poprzedniej klatki odczytywany z opóźnieniem, bez blokowania. Zapytania
+// GL_TIME_ELAPSED nie mogą się zagnieżdżać, więc rysowanie poza klatką (obrazy, serwer) nie mierzy czasu.
+class GpuFrameTimer {
+private:
+    GLuint queries[2] = { 0, 0 };
+    unsigned int frame = 0;
+    double ms = 0.0;
+
+public:
+    GpuFrameTimer() {}
+    GpuFrameTimer(GpuFrameTimer const&) = delete;
+    GpuFrameTimer& operator=(GpuFrameTimer const&) = delete;
+
+    ~GpuFrameTimer() {
+        if (queries[0] != 0) glDeleteQueries(2, queries);
+    }
+
+    void begin() {
+        if (queries[0] == 0) glGenQueries(2, queries);
+
+        GLuint query = queries[frame % 2];
+        if (frame >= 2) {
+            GLint available = 0;
+            glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+
+            if (available) {
+                GLuint64 elapsed = 0;
+                glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+                ms = elapsed / 1000000.0;
+            }
+        }
+        glBeginQuery(GL_TIME_ELAPSED, query);
+    }
+    void end() {
+        glEndQuery(GL_TIME_ELAPSED);
+        frame++;
+    }
+    // Czas z ostatniej dostępnej klatki
+    double getMs() const {
+        return ms;
+    }
+};
@@ -0,0 +1,234 @@
+// ==========================================================================
+// HeightPool: class definitions
+//
+// Michał Chawar
+// ==========================================================================
+// HeightPoolStats
+// HeightPool
+// HeightAllocator
+//===========================================================================
+
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+
+// ----------------------------------------
+//
+//      HEIGHT POOL class
+//
+// ----------------------------------------
+
+struct HeightPoolStats {
+    size_t in_use = 0, peak = 0;            // Bajty w slabach wydanych (obecnie i najwięcej naraz)
+    size_t reserved = 0;                    // Bajty wszystkich slabów (wydanych i wolnych)
+    unsigned int acquired = 0;              // Wydane slaby
+    unsigned int reused = 0;                // ... w tym z listy wolnych (bez nowej pamięci)
+    unsigned int mapped = 0;                // Slaby zaalokowane w systemie
+};
+
+// Pula slabów na wysokości kafli: alokacje od MIN_SLAB bajtów mają listę wolnych slabów
+// dokładnie swojego rozmiaru (kafel 3", kafel 1"), pobranie i zwrot to O(1) bez udziału sterty.
+// Zwolnione slaby zostają w puli (do max_free na rozmiar) - ponowne załadowanie kafla nie
+// wywołuje nowych błędów stron. Na Linuksie slaby mapowane są z wyrównaniem do dużych stron
+// i madvise(MADV_HUGEPAGE). Mniejsze alokacje trafiają na stertę.
+class HeightPool {
+public:
+    constexpr static size_t MIN_SLAB  = 1 << 20;
+    constexpr static size_t HUGE_PAGE = 2 << 20;
+
+    static HeightPool& instance() {
+        static HeightPool pool;
+        return pool;
+    }
+    ~HeightPool() {
+        for (auto& [bytes, size_class] : this->classes) {
+            for (void* slab : size_class.free) this->unmap(slab, bytes);
+        }
+    }
+public:
+    void* acquire(size_t bytes) {
+        if (!this->enabled || bytes < MIN_SLAB) return ::operator new(bytes);
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        SizeClass& size_class = this->classes[bytes];
+        void* slab;
+
+        if (!size_class.free.empty()) {
+            slab = size_class.free.back();
+            size_class.free.pop_back();
+            this->stats.reused++;
+        } else {
+            slab = this->map(bytes);
+            this->stats.mapped++;
+            this->stats.reserved += bytes;
+        }
+
+        size_class.in_use++;
+        this->stats.acquired++;
+        this->stats.in_use += bytes;
+        this->stats.peak = std::max(this->stats.peak, this->stats.in_use);
+
+        return slab;
+    }
+    void release(void* slab, size_t bytes) {
+        if (bytes < MIN_SLAB) {
+            ::operator delete(slab);
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        auto it = this->classes.find(bytes);
+
+        // Wydany przy wyłączonej puli
+        if (it == this->classes.end() || !this->owned(slab, bytes)) {
+            ::operator delete(slab);
+            return;
+        }
+
+        SizeClass& size_class = it->second;
+        size_class.in_use--;
+        this->stats.in_use -= bytes;
+
+        if (size_class.free.size() < this->max_free) {
+            size_class.free.push_back(slab);
+        } else {
+            this->unmap(slab, bytes);
+            this->stats.reserved -= bytes;
+        }
+    }
+public:
+    // Wyłączona pula - wszystkie alokacje na stercie (do porównań)
+    void setEnabled(bool enabled) {
+        this->enabled = enabled;
+    }
+    bool isEnabled() const {
+        return this->enabled;
+    }
+    // Duże strony dla nowych slabów (tylko Linux z transparent huge pages)
+    void setHugePages(bool enabled) {
+        this->huge_pages = enabled;
+    }
+    bool getHugePages() const {
+        return this->huge_pages;
+    }
+    // Liczba wolnych slabów zatrzymywanych na każdy rozmiar
+    void setMaxFree(unsigned int slabs) {
+        this->max_free = slabs;
+    }
+    // Zwraca pamięć wolnych slabów do systemu
+    void trim() {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        for (auto& [bytes, size_class] : this->classes) {
+            for (void* slab : size_class.free) {
+                this->unmap(slab, bytes);
+                this->stats.reserved -= bytes;
+            }
+            size_class.free.clear();
+        }
+    }
+    HeightPoolStats getStats() {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return this->stats;
+    }
+    void resetPeak() {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stats.peak = this->stats.in_use;
+    }
+private:
+    HeightPool() {}
+
+    struct SizeClass {
+        std::vector<void*> free;
+        unsigned int in_use = 0;
+    };
+
+    std::mutex mutex;
+    std::unordered_map<size_t, SizeClass> classes;
+    std::unordered_map<void*, size_t> slabs;            // Slab -> rozmiar, do rozpoznania przy zwrocie
+    HeightPoolStats stats;
+
+    bool enabled = true, huge_pages = true;
+    unsigned int max_free = 8;
+
+    bool owned(void* slab, size_t bytes) const {
+        auto it = this->slabs.find(slab);
+        return it != this->slabs.end() && it->second == bytes;
+    }
+    void* map(size_t bytes) {
+        void* slab = nullptr;
+
+#if defined(__linux__)
+        // Rezerwacja z zapasem i przycięcie do granicy dużej strony
+        size_t length = (bytes + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+        void* area = mmap(nullptr, length + HUGE_PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (area == MAP_FAILED) throw std::bad_alloc();
+
+        uintptr_t begin   = reinterpret_cast<uintptr_t>(area),
+                  aligned = (begin + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+
+        if (aligned > begin) munmap(area, aligned - begin);
+        munmap(reinterpret_cast<void*>(aligned + length), begin + HUGE_PAGE - aligned);
+
+        slab = reinterpret_cast<void*>(aligned);
+        if (this->huge_pages) madvise(slab, length, MADV_HUGEPAGE);
+#else
+        slab = ::operator new(bytes, std::align_val_t(HUGE_PAGE));
+#endif
+
+        this->slabs[slab] = bytes;
+        return slab;
+    }
+    void unmap(void* slab, size_t bytes) {
+        this->slabs.erase(slab);
+
+#if defined(__linux__)
+        munmap(slab, (bytes + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE);
+#else
+        ::operator delete(slab, std::align_val_t(HUGE_PAGE));
+#endif
+    }
+};
+
+
+// ----------------------------------------
+//
+//      HEIGHT ALLOCATOR class
+//
+// ----------------------------------------
+
+// Alokator tablic wysokości kafli korzystający ze wspólnej puli (bezstanowy - tablice
+// można przenosić między wątkami i kaflami bez kopiowania)
+template <class T>
+struct HeightAllocator {
+    using value_type = T;
+
+    HeightAllocator() = default;
+    template <class U>
+    HeightAllocator(HeightAllocator<U> const&) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>( HeightPool::instance().acquire(n * sizeof(T)) );
+    }
+    void deallocate(T* p, size_t n) {
+        HeightPool::instance().release(p, n * sizeof(T));
+    }
+
+    template <class U>
+    bool operator==(HeightAllocator<U> const&) const { return true; }
+    template <class U>
+    bool operator!=(HeightAllocator<U> const&) const { return false; }
+};
+
+using Heights = std::vector<float, HeightAllocator<float>>;
@@ -0,0 +1,469 @@
+// ==========================================================================
+// MapRenderer: class definitions
+//
+// Michał Chawar
+// ==========================================================================
+// RenderJob
+// ImageWriter
+// MapRenderer
+//===========================================================================
+
+#pragma once
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <TileManager.hpp>
+
+
+// ----------------------------------------
+//
+//      RENDER JOB utilities
+//
+// ----------------------------------------
+
+// Obraz 2D obszaru (lon/lat w stopniach), height = 0 - wysokość z proporcji obszaru
+struct RenderJob {
+    double lon_min, lat_min, lon_max, lat_max;
+    int width, height;
+    std::string output;             // .png lub .ppm (rozpoznawane po rozszerzeniu)
+};
+
+// Lista zadań z pliku: wiersz "lon_min lat_min lon_max lat_max szerokość wysokość plik", # - komentarz
+inline std::vector<RenderJob> readRenderJobs(std::string const& file_name) {
+    std::ifstream file(file_name);
+    if (!file) throw std::runtime_error("Nie można otworzyć listy obrazów: " + file_name);
+
+    std::vector<RenderJob> jobs;
+    std::string line;
+
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream iss(line);
+        RenderJob job;
+
+        if (!(iss >> job.lon_min >> job.lat_min >> job.lon_max >> job.lat_max >> job.width >> job.height >> job.output)
+            || job.lon_min >= job.lon_max || job.lat_min >= job.lat_max || job.width <= 0 || job.height < 0) {
+            std::cerr << "Niepoprawny wiersz listy obrazów: " << line << ", pominięto.\n";
+            continue;
+        }
+
+        // Proporcje jak w widoku 2D (długość skrócona o cos szerokości środka obszaru)
+        if (job.height == 0) {
+            double condensation = std::cos( glm::radians( (job.lat_min + job.lat_max) / 2.0 ) );
+            job.height = std::max(1, (int)std::lround( job.width * (job.lat_max - job.lat_min) / ((job.lon_max - job.lon_min) * condensation) ));
+        }
+
+        jobs.push_back(job);
+    }
+
+    return jobs;
+}
+
+// Widok 2D obszaru jak w TileManager::draw: rzut prostokątny, środek (lon, lat) i zasięg w stopniach
+inline void renderJobView(RenderJob const& job, float condensation, glm::mat4& projection, glm::vec3& center, float& drawDistance) {
+    projection = glm::ortho(
+        (float)job.lon_min * condensation, (float)job.lon_max * condensation,
+        (float)job.lat_min, (float)job.lat_max, -1.0f, 1.0f
+    );
+    center = glm::vec3( (job.lon_min + job.lon_max) / 2.0, (job.lat_min + job.lat_max) / 2.0, 0.0f );
+    drawDistance = glm::length( glm::vec2(job.lon_max - job.lon_min, job.lat_max - job.lat_min) ) / 2.0f;
+}
+
+
+// ----------------------------------------
+//
+//      IMAGE WRITER class
+//
+// ----------------------------------------
+
+// Zapis obrazów (RGBA wierszami od dołu, jak z glReadPixels) w osobnym wątku. Kolejka ma najwyżej
+// capacity obrazów - write() czeka na zwolnienie miejsca, gdy zapis nie nadąża za rysowaniem.
+class ImageWriter {
+public:
+    ImageWriter(size_t capacity = 4) : capacity(std::max<size_t>(capacity, 1)) {
+        this->worker = std::thread([this]() { this->work(); });
+    }
+    ~ImageWriter() {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->stopping = true;
+        }
+        this->condition.notify_all();
+        this->worker.join();
+    }
+public:
+    void write(std::string const& path, int width, int height, std::vector<uint8_t>&& rgba) {
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->condition.wait(lock, [this]() { return this->queue.size() < this->capacity; });
+            this->queue.push_back( Image{ path, width, height, std::move(rgba) } );
+        }
+        this->condition.notify_all();
+    }
+    // Czeka na zapisanie wszystkich obrazów z kolejki
+    void finish() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->condition.wait(lock, [this]() { return this->queue.empty() && !this->busy; });
+    }
+    unsigned int getFailed() {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return this->failed;
+    }
+    void resetFailed() {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->failed = 0;
+    }
+    // RGB wierszami od góry (z RGBA wierszami od dołu)
+    static std::vector<uint8_t> flipToRgb(int width, int height, std::vector<uint8_t> const& rgba) {
+        std::vector<uint8_t> rgb((size_t)width * height * 3);
+        for (int y = 0; y < height; y++) {
+            uint8_t const* src = &rgba[(size_t)(height - 1 - y) * width * 4];
+            uint8_t* dst = &rgb[(size_t)y * width * 3];
+
+            for (int x = 0; x < width; x++) {
+                dst[3 * x] = src[4 * x]; dst[3 * x + 1] = src[4 * x + 1]; dst[3 * x + 2] = src[4 * x + 2];
+            }
+        }
+        return rgb;
+    }
+    // PNG bez kompresji (bloki deflate typu "stored") - bez zależności od zlib
+    static std::string encodePng(int width, int height, std::vector<uint8_t> const& rgb) {
+        static uint32_t const* table = []() {
+            static uint32_t t[256];
+            for (uint32_t n = 0; n < 256; n++) {
+                uint32_t c = n;
+                for (int k = 0; k < 8; k++) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                t[n] = c;
+            }
+            return t;
+        }();
+
+        auto be32 = [](std::string& out, uint32_t v) {
+            out += (char)(v >> 24); out += (char)(v >> 16); out += (char)(v >> 8); out += (char)v;
+        };
+
+        std::string png("\x89PNG\r\n\x1a\n", 8);
+        auto chunk = [&png, &be32](char const* type, std::string const& data) {
+            be32(png, (uint32_t)data.size());
+
+            size_t begin = png.size();
+            png.append(type, 4);
+            png += data;
+
+            uint32_t crc = 0xFFFFFFFFu;
+            for (size_t k = begin; k < png.size(); k++) crc = table[(crc ^ (unsigned char)png[k]) & 0xFF] ^ (crc >> 8);
+            be32(png, crc ^ 0xFFFFFFFFu);
+        };
+
+        std::string header;
+        be32(header, width);
+        be32(header, height);
+        header += std::string("\x08\x02\x00\x00\x00", 5);       // 8 bitów, RGB, bez przeplotu
+
+        // Wiersze z bajtem filtra 0
+        std::string raw;
+        raw.reserve((size_t)height * (width * 3 + 1));
+        for (int y = 0; y < height; y++) {
+            raw += '\0';
+            raw.append( reinterpret_cast<char const*>(&rgb[(size_t)y * width * 3]), (size_t)width * 3 );
+        }
+
+        std::string data = "\x78\x01";
+        uint32_t a = 1, b = 0;
+        for (size_t offset = 0; ; offset += 65535) {
+            size_t n = std::min<size_t>(65535, raw.size() - offset);
+            bool last = offset + n >= raw.size();
+
+            data += (char)(last ? 1 : 0);
+            data += (char)(n & 0xFF); data += (char)(n >> 8);
+            data += (char)(~n & 0xFF); data += (char)((~n >> 8) & 0xFF);
+            data.append(raw, offset, n);
+
+            for (size_t k = offset; k < offset + n; k++) {
+                a = (a + (unsigned char)raw[k]) % 65521;
+                b = (b + a) % 65521;
+            }
+            if (last) break;
+        }
+        be32(data, (b << 16) | a);
+
+        chunk("IHDR", header);
+        chunk("IDAT", data);
+        chunk("IEND", "");
+
+        return png;
+    }
+private:
+    struct Image {
+        std::string path;
+        int width, height;
+        std::vector<uint8_t> rgba;
+    };
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<Image> queue;
+    size_t capacity;
+    bool stopping = false, busy = false;
+    unsigned int failed = 0;
+
+    void work() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+
+        while (true) {
+            this->condition.wait(lock, [this]() { return this->stopping || !this->queue.empty(); });
+            if (this->queue.empty()) return;
+
+            Image image = std::move(this->queue.front());
+            this->queue.pop_front();
+            this->busy = true;
+
+            lock.unlock();
+            this->condition.notify_all();
+
+            bool ok = save(image);
+            lock.lock();
+
+            if (!ok) {
+                std::cerr << "Błąd zapisu obrazu: " << image.path << "\n";
+                this->failed++;
+            }
+            this->busy = false;
+            this->condition.notify_all();
+        }
+    }
+
+    static bool save(Image const& image) {
+        std::vector<uint8_t> rgb = flipToRgb(image.width, image.height, image.rgba);
+
+        std::ofstream file(image.path, std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+
+        std::string extension = image.path.size() > 4 ? image.path.substr(image.path.size() - 4) : "";
+        if (extension == ".png" || extension == ".PNG") {
+            std::string png = encodePng(image.width, image.height, rgb);
+            file.write(png.data(), png.size());
+        } else {
+            file << "P6\n" << image.width << " " << image.height << "\n255\n" << std::string(rgb.begin(), rgb.end());
+        }
+
+        return (bool)file;
+    }
+};
+
+
+// ----------------------------------------
+//
+//      MAP RENDERER class
+//
+// ----------------------------------------
+
+// Obrazy 2D obszarów rysowane przez TileManager (tile.vs / tile.fs) do bufora ramki poza oknem.
+// Piksele kopiowane są do buforów PBO (kolejno PBO_COUNT), odczyt obrazu następuje dopiero
+// przy ponownym użyciu bufora - GPU rysuje kolejny obraz zamiast czekać na glReadPixels.
+class MapRenderer {
+public:
+    constexpr static int PBO_COUNT = 3;
+
+    MapRenderer(TileManager& tileManager) : tileManager(tileManager) {
+        glGenFramebuffers(1, &this->fbo);
+        glGenRenderbuffers(2, this->renderbuffers);
+        glGenBuffers(PBO_COUNT, this->pbos);
+    }
+    ~MapRenderer() {
+        for (Pending& p : this->pending) {
+            if (p.fence) glDeleteSync(p.fence);
+        }
+        glDeleteBuffers(PBO_COUNT, this->pbos);
+        glDeleteRenderbuffers(2, this->renderbuffers);
+        glDeleteFramebuffers(1, &this->fbo);
+    }
+public:
+    // Zwraca liczbę zapisanych obrazów (z tego wywołania)
+    unsigned int render(std::vector<RenderJob> const& jobs) {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        // Wszystkie kafle obszaru wysyłane na GPU w pierwszej klatce obrazu
+        UnlimitedUploads unlimited(this->tileManager);
+
+        this->failed = 0;
+        this->writer.resetFailed();
+
+        glBindFramebuffer(GL_FRAMEBUFFER, this->fbo);
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+        for (size_t k = 0; k < jobs.size(); k++) {
+            Pending& slot = this->pending[k % PBO_COUNT];
+            if (slot.active) this->collect(slot);
+
+            RenderJob const& job = jobs[k];
+            this->drawJob(job);
+
+            // Asynchroniczne kopiowanie pikseli do PBO
+            size_t bytes = (size_t)job.width * job.height * 4;
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, this->pbos[k % PBO_COUNT]);
+            if (slot.capacity < bytes) {
+                glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+                slot.capacity = bytes;
+            }
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+            glReadPixels(0, 0, job.width, job.height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+            slot.fence  = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            slot.job    = job;
+            slot.pbo    = this->pbos[k % PBO_COUNT];
+            slot.active = true;
+
+            this->pixels += (double)job.width * job.height;
+        }
+
+        for (size_t k = jobs.size(); k < jobs.size() + PBO_COUNT; k++) {
+            Pending& slot = this->pending[k % PBO_COUNT];
+            if (slot.active) this->collect(slot);
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        this->writer.finish();
+
+        this->seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        size_t failed = (size_t)this->writer.getFailed() + this->failed;
+        return (unsigned int)(jobs.size() - std::min(failed, jobs.size()));
+    }
+    // Pojedynczy obraz od razu do pamięci (RGBA wierszami od dołu) - bez PBO, np. dla TileServer
+    std::vector<uint8_t> renderImage(RenderJob const& job) {
+        UnlimitedUploads unlimited(this->tileManager);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, this->fbo);
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        this->drawJob(job);
+
+        std::vector<uint8_t> rgba((size_t)job.width * job.height * 4);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, job.width, job.height, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        return rgba;
+    }
+    double getSeconds() const {
+        return this->seconds;
+    }
+    double getPixels() const {
+        return this->pixels;
+    }
+    // Czas oczekiwania na odczyt pikseli (płot PBO nie był jeszcze zasygnalizowany)
+    double getReadbackWaitMs() const {
+        return this->wait_ms;
+    }
+private:
+    struct Pending {
+        bool active = false;
+        GLuint pbo = 0;
+        GLsync fence = nullptr;
+        size_t capacity = 0;
+        RenderJob job;
+    };
+
+    // Limit wysyłania na GPU zniesiony na czas rysowania obrazów, poprzedni przywracany przy każdym
+    // wyjściu (także przez wyjątek) - kolejne klatki okna mają znów swój limit
+    struct UnlimitedUploads {
+        TileManager& tileManager;
+        size_t budget;
+        unsigned int frames;
+
+        UnlimitedUploads(TileManager& tileManager) : tileManager(tileManager), budget(tileManager.getUploadBudget()), frames(tileManager.getReleaseFrames()) {
+            tileManager.setUploadBudget(SIZE_MAX, frames);
+        }
+        ~UnlimitedUploads() {
+            this->tileManager.setUploadBudget(this->budget, this->frames);
+        }
+    };
+
+    TileManager& tileManager;
+
+    GLuint fbo = 0, renderbuffers[2] = { 0, 0 }, pbos[PBO_COUNT];
+    int width = 0, height = 0;
+    Pending pending[PBO_COUNT];
+
+    ImageWriter writer;
+
+    double seconds = 0.0, pixels = 0.0, wait_ms = 0.0;
+    unsigned int failed = 0;        // Obrazy bez odczytanych pikseli (nieudane mapowanie PBO)
+
+    void drawJob(RenderJob const& job) {
+        this->resize(job.width, job.height);
+
+        glViewport(0, 0, job.width, job.height);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        glm::mat4 projection;
+        glm::vec3 center;
+        float drawDistance;
+        renderJobView(job, this->tileManager.getXCondensation(), projection, center, drawDistance);
+
+        this->tileManager.draw(glm::mat4(1.0f), projection, center, glm::dvec3(0.0), drawDistance);
+    }
+    void resize(int width, int height) {
+        if (width == this->width && height == this->height) return;
+
+        glBindRenderbuffer(GL_RENDERBUFFER, this->renderbuffers[0]);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, this->renderbuffers[1]);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, this->renderbuffers[0]);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,  GL_RENDERBUFFER, this->renderbuffers[1]);
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            throw std::runtime_error("Niekompletny bufor ramki " + std::to_string(width) + " x " + std::to_string(height));
+
+        this->width  = width;
+        this->height = height;
+    }
+    // Odczyt pikseli z PBO (po sygnale płotu) i przekazanie obrazu do zapisu; bez zmapowanego PBO
+    // obraz nie jest zapisywany (liczony jako nieudany)
+    void collect(Pending& slot) {
+        auto start = std::chrono::high_resolution_clock::now();
+        while (glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+        this->wait_ms += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+
+        size_t bytes = (size_t)slot.job.width * slot.job.height * 4;
+        std::vector<uint8_t> rgba(bytes);
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        void const* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+        if (mapped != nullptr) {
+            std::memcpy(rgba.data(), mapped, bytes);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        slot.active = false;
+
+        if (mapped == nullptr) {
+            std::cerr << "Błąd odczytu pikseli obrazu (glMapBufferRange): " << slot.job.output << "\n";
+            this->failed++;
+            return;
+        }
+
+        this->writer.write(slot.job.output, slot.job.width, slot.job.height, std::move(rgba));
+    }
+};
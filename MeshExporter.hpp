@@ -0,0 +1,537 @@
+// ==========================================================================
+// MeshExporter: class definitions
+//
+// Michał Chawar
+// ==========================================================================
+// BufferedWriter
+// MeshFormat
+// MeshProjection
+// MeshExportStats
+// MeshExporter
+//===========================================================================
+
+#pragma once
+
+#include <cstdio>
+#include <cstdarg>
+#include <cstdint>
+#include <climits>
+#include <cfloat>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <algorithm>
+#include <stdexcept>
+#include <chrono>
+#include <thread>
+
+#include <glm/glm.hpp>
+
+#include <TileManager.hpp>
+#include <AdaptiveMesh.hpp>
+
+
+// ----------------------------------------
+//
+//      BUFFERED WRITER class
+//
+// ----------------------------------------
+
+// Zapis do pliku przez bufor o stałym rozmiarze - pamięć zapisu nie zależy od rozmiaru pliku
+class BufferedWriter {
+public:
+    BufferedWriter(std::string const& path, size_t capacity = 1 << 20) : path(path) {
+        this->file = std::fopen(path.c_str(), "wb");
+        if (this->file == nullptr) throw std::runtime_error("Nie można otworzyć pliku do zapisu: " + path);
+
+        this->buffer.resize(capacity);
+    }
+    // Bez close() (np. przy wyjątku w trakcie eksportu) - zapis reszty bufora bez zgłaszania błędów
+    ~BufferedWriter() noexcept {
+        if (this->file == nullptr) return;
+
+        if (this->used > 0) std::fwrite(this->buffer.data(), 1, this->used, this->file);
+        std::fclose(this->file);
+    }
+    BufferedWriter(BufferedWriter const&) = delete;
+    BufferedWriter& operator=(BufferedWriter const&) = delete;
+public:
+    void write(void const* data, size_t size) {
+        if (this->used + size > this->buffer.size()) {
+            this->flush();
+
+            if (size > this->buffer.size()) {
+                this->put(data, size);
+                return;
+            }
+        }
+        std::copy((char const*)data, (char const*)data + size, this->buffer.data() + this->used);
+        this->used += size;
+    }
+    template <class T>
+    void write(T const& value) {
+        this->write(&value, sizeof(T));
+    }
+    // Tekst formatowany jak printf (jeden wiersz pliku OBJ, nagłówek JSON)
+    void print(char const* format, ...) {
+        char line[512];
+
+        va_list args;
+        va_start(args, format);
+        int n = std::vsnprintf(line, sizeof(line), format, args);
+        va_end(args);
+
+        if (n > 0) this->write(line, std::min((size_t)n, sizeof(line) - 1));
+    }
+    // Nadpisanie już zapisanych bajtów (np. liczby trójkątów w nagłówku STL)
+    void patch(size_t offset, void const* data, size_t size) {
+        this->flush();
+
+        std::fseek(this->file, (long)offset, SEEK_SET);
+        this->put(data, size);
+        this->written -= size;
+        std::fseek(this->file, 0, SEEK_END);
+    }
+    // Zamknięcie pliku z kontrolą błędów zapisu (wyjątek std::runtime_error); plik zamykany także po błędzie
+    void close() {
+        if (this->file == nullptr) return;
+
+        bool failed = false;
+        try { this->flush(); }
+        catch (std::runtime_error const&) { failed = true; }
+
+        int result = std::fclose(this->file);
+        this->file = nullptr;
+        if (failed || result != 0) throw std::runtime_error("Błąd zapisu pliku: " + this->path);
+    }
+    size_t getWritten() const {
+        return this->written + this->used;
+    }
+private:
+    std::string path;
+    std::FILE* file = nullptr;
+    std::vector<char> buffer;
+    size_t used = 0, written = 0;
+
+    void flush() {
+        if (this->used == 0) return;
+
+        this->put(this->buffer.data(), this->used);
+        this->used = 0;
+    }
+    void put(void const* data, size_t size) {
+        if (std::fwrite(data, 1, size, this->file) != size) throw std::runtime_error("Błąd zapisu pliku: " + this->path);
+        this->written += size;
+    }
+};
+
+
+// ----------------------------------------
+//
+//      MESH EXPORTER class
+//
+// ----------------------------------------
+
+enum class MeshFormat {
+    Obj,                            // Tekst: wierzchołki i trójkąty kafla po kolei
+    Stl,                            // Binarny, trójkąty bez wspólnych wierzchołków (liczba trójkątów uzupełniana na końcu)
+    Gltf                            // Nagłówek JSON + bufory wierzchołków i indeksów w osobnych plikach .bin
+};
+
+enum class MeshProjection {
+    Geographic,                     // x - długość, y - szerokość (stopnie), z - wysokość (m)
+    Flat,                           // Jak tile.vs: x - długość * x_condensation, y - szerokość, z - wysokość w stopniach szerokości
+    Sphere                          // Jak tile3d.vs: glob w jednostkach sceny (10 m), względem środka obszaru na poziomie morza
+};
+
+struct MeshExportStats {
+    size_t tiles = 0;
+    size_t vertices = 0, triangles = 0;
+    size_t welded = 0;              // Wierzchołki krawędzi kafli wspólne z kaflem zapisanym wcześniej
+    size_t bytes = 0;               // Razem we wszystkich plikach
+    double ms = 0.0;
+};
+
+// Eksport siatek adaptacyjnych (zob. RtinBuilder) kafli z granic TileManager do OBJ, STL lub glTF.
+// Kafle czytane są i triangulowane w puli TileLoader w kolejności wierszy (od południa), w oknie kilku
+// kafli naprzód, zapis strumieniowy - w pamięci jest tylko okno kafli i wierzchołki krawędzi
+// bieżącego i poprzedniego wiersza kafli, po których łączone są wierzchołki sąsiednich kafli.
+// Krawędź kafla 1" przy kaflu 3" (rozdzielczość z rozmiaru pliku w TileIndex) dopasowywana jest do
+// krawędzi sąsiada; obszary bez danych (wypełnianie braków wyłączone) zostają w siatce dziurami.
+class MeshExporter {
+public:
+    MeshExporter(TileManager& tileManager) : tileManager(tileManager) {}
+public:
+    void  setError(float error) {
+        this->error = std::max(error, 0.0f);
+    }
+    void  setProjection(MeshProjection projection) {
+        this->projection = projection;
+    }
+    // Format z rozszerzenia pliku (.obj, .stl, .gltf)
+    static bool parseFormat(std::string const& path, MeshFormat& format) {
+        std::string extension = path.substr( std::min(path.size(), path.rfind('.')) );
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+
+        if (extension == ".obj")  { format = MeshFormat::Obj;  return true; }
+        if (extension == ".stl")  { format = MeshFormat::Stl;  return true; }
+        if (extension == ".gltf") { format = MeshFormat::Gltf; return true; }
+        return false;
+    }
+    static bool parseProjection(std::string const& name, MeshProjection& projection) {
+        if (name == "geo") { projection = MeshProjection::Geographic; return true; }
+        if (name == "2d")  { projection = MeshProjection::Flat;       return true; }
+        if (name == "3d")  { projection = MeshProjection::Sphere;     return true; }
+        return false;
+    }
+
+    MeshExportStats write(std::string const& path) {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        MeshFormat format;
+        if (!parseFormat(path, format)) throw std::invalid_argument("Nieznany format siatki (.obj, .stl, .gltf): " + path);
+
+        std::vector<Coordinates> found = this->tileManager.findTiles();
+        if (found.empty()) throw std::runtime_error("Brak kafli w granicach eksportu.");
+
+        std::sort(found.begin(), found.end(), [](Coordinates const& a, Coordinates const& b) {
+            return std::make_pair(a.latitude.getDegreesSigned(), a.longitude.getDegreesSigned()) < std::make_pair(b.latitude.getDegreesSigned(), b.longitude.getDegreesSigned());
+        });
+
+        this->stats = MeshExportStats();
+        this->weld.clear();
+        this->x_condensation = this->tileManager.getXCondensation();
+
+        // Środek obszaru kafli (początek układu w rzucie na glob)
+        double lat_min = found.front().latitude.getDegreesSigned(), lat_max = found.back().latitude.getDegreesSigned() + 1,
+               lon_min = 180.0, lon_max = -180.0;
+        for (Coordinates const& orig : found) {
+            lon_min = std::min(lon_min, (double)orig.longitude.getDegreesSigned());
+            lon_max = std::max(lon_max, orig.longitude.getDegreesSigned() + 1.0);
+        }
+        this->origin = this->projection == MeshProjection::Sphere ?
+            toUnitVector((lat_min + lat_max) / 2.0, (lon_min + lon_max) / 2.0) * EARTH_RADIUS :
+            glm::dvec3(0.0);
+
+        this->open(path, format);
+
+        // Okno kafli w puli: zlecone i odebrane, ale jeszcze niezapisane (kolejność zapisu - wiersze)
+        unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+        size_t window = 2 * threads;
+
+        TileLoader pool(threads);
+        std::unordered_map<std::string, DecodedTile> pending;
+
+        for (size_t next = 0; next < found.size(); ) {
+            std::vector<TileRequest> requests;
+            for (size_t k = next; k < std::min(found.size(), next + window); k++) {
+                std::string key = found[k].getTileString();
+                if (pending.find(key) == pending.end())
+                    requests.push_back( TileRequest{ key, found[k], (float)k, this->error, this->tileManager.getHoleFilling() } );
+            }
+            pool.request(requests);
+
+            // Następny kafel jest zlecony - czekanie na wynik dowolnego kafla okna (bez odpytywania)
+            auto it = pending.find( found[next].getTileString() );
+            if (it == pending.end()) {
+                for (auto& decoded : pool.collect(true)) pending.emplace(decoded.key, std::move(decoded));
+                continue;
+            }
+
+            if (it->second.samples > 0) this->writeTile(it->second);
+            pending.erase(it);
+            next++;
+        }
+
+        this->close(path, format);
+
+        this->stats.ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        return this->stats;
+    }
+private:
+    TileManager& tileManager;
+    float error = RtinBuilder::DEFAULT_ERROR;
+    MeshProjection projection = MeshProjection::Geographic;
+
+    MeshFormat format = MeshFormat::Obj;
+    std::unique_ptr<BufferedWriter> main, positions, indices;
+    size_t stl_count_offset = 0;
+
+    MeshExportStats stats;
+    float x_condensation = 1.0f;
+    glm::dvec3 origin = glm::dvec3(0.0);
+    glm::vec3 min = glm::vec3(FLT_MAX), max = glm::vec3(-FLT_MAX);
+
+    // Wierzchołki krawędzi zapisanych kafli: klucz - położenie próbki w sekundach łuku
+    // (szerokość << 32 | długość), wartość - numer wierzchołka w pliku i jego wysokość
+    struct Weld {
+        uint32_t global;
+        float height;               // Wysokość zapisanego wierzchołka (dopasowanie krawędzi 1" do 3")
+    };
+    std::unordered_map<uint64_t, Weld> weld;
+    int weld_row = INT_MIN;
+
+    // Bieżący kafel: numer wierzchołka lokalnego dla próbki (i * samples + j), pozycje i numery w pliku
+    std::vector<uint32_t> remap;
+    std::vector<size_t> touched;
+    std::vector<glm::vec3> tile_positions;
+    std::vector<uint32_t> tile_global;
+
+    constexpr static double EARTH_RADIUS = 637800.0;                             // Jednostki sceny 3D (zob. tile3d.vs)
+    constexpr static double METERS_PER_DEGREE = 6378000.0 * M_PI / 180.0;        // Jak w cieniowaniu (tile.vs)
+    constexpr static uint32_t NONE = UINT32_MAX;
+
+    static glm::dvec3 toUnitVector(double lat, double lon) {
+        lat = glm::radians(lat);
+        lon = glm::radians(lon);
+        return glm::dvec3( std::cos(lat) * std::cos(lon), std::sin(lat), std::cos(lat) * std::sin(lon) );
+    }
+    glm::vec3 position(double lat, double lon, float height) const {
+        switch (this->projection) {
+            case MeshProjection::Flat:
+                return glm::vec3( lon * this->x_condensation, lat, height / METERS_PER_DEGREE );
+            case MeshProjection::Sphere:
+                return glm::vec3( toUnitVector(lat, lon) * (EARTH_RADIUS + height / 10.0) - this->origin );
+            default:
+                return glm::vec3( lon, lat, height );
+        }
+    }
+
+    void open(std::string const& path, MeshFormat format) {
+        this->format = format;
+        this->min = glm::vec3(FLT_MAX);
+        this->max = glm::vec3(-FLT_MAX);
+
+        if (format == MeshFormat::Gltf) {
+            this->positions = std::make_unique<BufferedWriter>(binPath(path, "positions"));
+            this->indices   = std::make_unique<BufferedWriter>(binPath(path, "indices"));
+            return;
+        }
+
+        this->main = std::make_unique<BufferedWriter>(path);
+
+        if (format == MeshFormat::Obj) {
+            this->main->print("# AGL3-terrain: siatka terenu, błąd pionowy %.2f m\n", this->error);
+            if (this->projection == MeshProjection::Sphere)
+                this->main->print("# Pozycje względem punktu %.3f %.3f %.3f (jednostki sceny 3D)\n", this->origin.x, this->origin.y, this->origin.z);
+        }
+        else {
+            char header[80] = {};
+            std::snprintf(header, sizeof(header), "AGL3-terrain mesh, error %.2f m, origin %.3f %.3f %.3f", this->error, this->origin.x, this->origin.y, this->origin.z);
+
+            this->main->write(header, sizeof(header));
+            this->stl_count_offset = this->main->getWritten();
+            this->main->write<uint32_t>(0);
+        }
+    }
+    void close(std::string const& path, MeshFormat format) {
+        if (format == MeshFormat::Obj) {
+            this->stats.bytes = this->main->getWritten();
+            this->main->close();
+        }
+        else if (format == MeshFormat::Stl) {
+            uint32_t count = (uint32_t)this->stats.triangles;
+            this->main->patch(this->stl_count_offset, &count, sizeof(count));
+
+            this->stats.bytes = this->main->getWritten();
+            this->main->close();
+        }
+        else {
+            size_t position_bytes = this->positions->getWritten(), index_bytes = this->indices->getWritten();
+            this->positions->close();
+            this->indices->close();
+
+            // glTF: oś Y w górę - dla rzutów płaskich wysokość (z) zamieniana w zapisie wierzchołków na y
+            BufferedWriter json(path);
+            json.print("{\n  \"asset\": { \"version\": \"2.0\", \"generator\": \"AGL3-terrain\" },\n  \"scene\": 0,\n  \"scenes\": [ { \"nodes\": [ 0 ] } ],\n");
+            json.print("  \"nodes\": [ { \"mesh\": 0, \"translation\": [ %.6f, %.6f, %.6f ] } ],\n", this->origin.x, this->origin.y, this->origin.z);
+            json.print("  \"meshes\": [ { \"primitives\": [ { \"attributes\": { \"POSITION\": 0 }, \"indices\": 1, \"mode\": 4 } ] } ],\n");
+            json.print("  \"buffers\": [ { \"uri\": \"%s\", \"byteLength\": %zu }, { \"uri\": \"%s\", \"byteLength\": %zu } ],\n",
+                fileName(binPath(path, "positions")).c_str(), position_bytes, fileName(binPath(path, "indices")).c_str(), index_bytes);
+            json.print("  \"bufferViews\": [ { \"buffer\": 0, \"byteLength\": %zu, \"target\": 34962 }, { \"buffer\": 1, \"byteLength\": %zu, \"target\": 34963 } ],\n", position_bytes, index_bytes);
+            json.print("  \"accessors\": [\n    { \"bufferView\": 0, \"componentType\": 5126, \"count\": %zu, \"type\": \"VEC3\", \"min\": [ %.9g, %.9g, %.9g ], \"max\": [ %.9g, %.9g, %.9g ] },\n",
+                this->stats.vertices, this->min.x, this->min.y, this->min.z, this->max.x, this->max.y, this->max.z);
+            json.print("    { \"bufferView\": 1, \"componentType\": 5125, \"count\": %zu, \"type\": \"SCALAR\" }\n  ]\n}\n", this->stats.triangles * 3);
+
+            this->stats.bytes = position_bytes + index_bytes + json.getWritten();
+            json.close();
+        }
+
+        this->main.reset();
+        this->positions.reset();
+        this->indices.reset();
+    }
+    static std::string binPath(std::string const& path, std::string const& name) {
+        return path.substr(0, path.rfind('.')) + "." + name + ".bin";
+    }
+    static std::string fileName(std::string const& path) {
+        size_t slash = path.find_last_of("/\\");
+        return slash == std::string::npos ? path : path.substr(slash + 1);
+    }
+
+    void writeTile(DecodedTile const& decoded) {
+        int samples = decoded.samples, last = samples - 1;
+        int side    = std::min(samples, (int)Tile::BLOCK),
+            blocks  = last / (side - 1);
+        int step    = 3600 / last;                                  // Sekundy łuku między próbkami
+
+        short lat0 = decoded.origin.latitude .getDegreesSigned(),
+              lon0 = decoded.origin.longitude.getDegreesSigned();
+
+        // Nowy wiersz kafli - krawędzie wierszy niższych niż poprzedni nie będą już potrzebne
+        if (lat0 != this->weld_row) {
+            for (auto it = this->weld.begin(); it != this->weld.end(); ) {
+                if ((int32_t)(it->first >> 32) < lat0 * 3600) it = this->weld.erase(it);
+                else ++it;
+            }
+            this->weld_row = lat0;
+        }
+
+        // Krawędzie graniczące z kaflem 3" (kafel 1"): co trzecia próbka krawędzi wspólna z sąsiadem,
+        // pozostałe przesuwane na odcinek między nimi - bez szczelin przy wierzchołkach w kształcie T
+        // (S, N, W, E; 0 - bez dopasowania)
+        int coarse[4] = {
+            this->coarseRatio(samples, lat0 - 1, lon0), this->coarseRatio(samples, lat0 + 1, lon0),
+            this->coarseRatio(samples, lat0, lon0 - 1), this->coarseRatio(samples, lat0, lon0 + 1)
+        };
+
+        auto keyOf = [&](int i, int j) {
+            return ((uint64_t)(uint32_t)(lat0 * 3600 + i * step) << 32) | (uint32_t)(lon0 * 3600 + j * step + 180 * 3600);
+        };
+        // Wysokość próbki: wierzchołek połączony wcześniej z sąsiadem albo dane kafla
+        auto heightOf = [&](int i, int j) {
+            auto it = this->weld.find( keyOf(i, j) );
+            if (it != this->weld.end()) return it->second.height;
+
+            int bi = std::min(i / (side - 1), blocks - 1), bj = std::min(j / (side - 1), blocks - 1);
+            return decoded.heights[((size_t)bi * blocks + bj) * side * side + (size_t)(i - bi * (side - 1)) * side + (j - bj * (side - 1))];
+        };
+        auto stitch = [&](int i, int j, float height) {
+            int ratio = 0, t = 0;
+            if      (i == 0    && coarse[0] != 0) { ratio = coarse[0]; t = j; }
+            else if (i == last && coarse[1] != 0) { ratio = coarse[1]; t = j; }
+            else if (j == 0    && coarse[2] != 0) { ratio = coarse[2]; t = i; }
+            else if (j == last && coarse[3] != 0) { ratio = coarse[3]; t = i; }
+            if (ratio == 0 || t % ratio == 0) return height;
+
+            int t0 = t - t % ratio, t1 = t0 + ratio;
+            float h0 = (i == 0 || i == last) ? heightOf(i, t0) : heightOf(t0, j),
+                  h1 = (i == 0 || i == last) ? heightOf(i, t1) : heightOf(t1, j);
+            if (h0 == Tile::NO_DATA || h1 == Tile::NO_DATA) return height;
+
+            return h0 + (h1 - h0) * (float)(t - t0) / ratio;
+        };
+
+        if (this->remap.size() < (size_t)samples * samples) this->remap.assign((size_t)samples * samples, NONE);
+        this->tile_positions.clear();
+        this->tile_global.clear();
+
+        std::vector<unsigned int> const& mesh = decoded.mesh.indices;
+        std::vector<uint32_t> local(mesh.size(), NONE);
+
+        // Wierzchołki: pierwsze użycie próbki w kaflu, na krawędzi - połączenie z kaflem zapisanym wcześniej.
+        // Trójkąty z próbką bez danych (NO_DATA, kafel bez wypełniania braków) są pomijane.
+        for (size_t k = 0; k + 2 < mesh.size(); k += 3) {
+            if (decoded.heights[mesh[k]] == Tile::NO_DATA || decoded.heights[mesh[k + 1]] == Tile::NO_DATA || decoded.heights[mesh[k + 2]] == Tile::NO_DATA)
+                continue;
+
+            for (size_t corner = k; corner < k + 3; corner++) {
+                size_t v = mesh[corner];
+                size_t block = v / ((size_t)side * side), offset = v % ((size_t)side * side);
+
+                int i = (int)(block / blocks) * (side - 1) + (int)(offset / side),
+                    j = (int)(block % blocks) * (side - 1) + (int)(offset % side);
+                size_t sample = (size_t)i * samples + j;
+
+                if (this->remap[sample] == NONE) {
+                    this->remap[sample] = (uint32_t)this->tile_positions.size();
+                    this->touched.push_back(sample);
+
+                    bool border = i == 0 || i == last || j == 0 || j == last;
+                    float height = border ? stitch(i, j, decoded.heights[v]) : decoded.heights[v];
+
+                    uint32_t global = NONE;
+                    uint64_t key = keyOf(i, j);
+
+                    if (border) {
+                        auto it = this->weld.find(key);
+                        if (it != this->weld.end()) {
+                            global = it->second.global;
+                            height = it->second.height;
+                            this->stats.welded++;
+                        }
+                    }
+
+                    glm::vec3 p = this->position(lat0 + (double)i / last, lon0 + (double)j / last, height);
+                    this->tile_positions.push_back(p);
+
+                    if (global == NONE) {
+                        global = (uint32_t)this->stats.vertices++;
+                        this->writeVertex(p);
+                        if (border) this->weld.emplace(key, Weld{ global, height });
+                    }
+                    this->tile_global.push_back(global);
+                }
+                local[corner] = this->remap[sample];
+            }
+        }
+
+        // Trójkąty; w rzucie na glob kolejność odwrócona - przednie ściany na zewnątrz kuli
+        bool flip = this->projection == MeshProjection::Sphere;
+
+        for (size_t k = 0; k + 2 < local.size(); k += 3) {
+            if (local[k] == NONE) continue;
+
+            uint32_t a = local[k], b = local[k + (flip ? 2 : 1)], c = local[k + (flip ? 1 : 2)];
+            this->writeTriangle(a, b, c);
+            this->stats.triangles++;
+        }
+        this->stats.tiles++;
+
+        for (size_t sample : this->touched) this->remap[sample] = NONE;
+        this->touched.clear();
+    }
+    // Stosunek rozdzielczości kafla (samples) do sąsiada z indeksu, jeśli sąsiad jest rzadszy (3 dla 1" obok 3"), wpp. 0
+    int coarseRatio(int samples, short lat, short lon) const {
+        TileIndexEntry const* e = this->tileManager.getIndex().find(lat, lon);
+        if (e == nullptr || e->size != (uintmax_t)1201 * 1201 * 2 || samples <= 1201) return 0;
+
+        return (samples - 1) / 1200;
+    }
+    void writeVertex(glm::vec3 const& p) {
+        if (this->format == MeshFormat::Obj) {
+            this->main->print("v %.7g %.7g %.7g\n", p.x, p.y, p.z);
+        }
+        else if (this->format == MeshFormat::Gltf) {
+            glm::vec3 q = this->projection == MeshProjection::Sphere ? p : glm::vec3(p.x, p.z, -p.y);
+
+            this->positions->write(q);
+            this->min = glm::min(this->min, q);
+            this->max = glm::max(this->max, q);
+        }
+    }
+    // a, b, c - wierzchołki lokalne bieżącego kafla
+    void writeTriangle(uint32_t a, uint32_t b, uint32_t c) {
+        if (this->format == MeshFormat::Obj) {
+            this->main->print("f %u %u %u\n", this->tile_global[a] + 1, this->tile_global[b] + 1, this->tile_global[c] + 1);
+        }
+        else if (this->format == MeshFormat::Gltf) {
+            uint32_t triangle[3] = { this->tile_global[a], this->tile_global[b], this->tile_global[c] };
+            this->indices->write(triangle, sizeof(triangle));
+        }
+        else {
+            glm::vec3 const& pa = this->tile_positions[a], pb = this->tile_positions[b], pc = this->tile_positions[c];
+            glm::vec3 n = glm::cross(pb - pa, pc - pa);
+            float length = glm::length(n);
+            if (length > 0.0f) n /= length;
+
+            this->main->write(n);
+            this->main->write(pa);
+            this->main->write(pb);
+            this->main->write(pc);
+            this->main->write<uint16_t>(0);
+        }
+    }
+};
@@ -0,0 +1,493 @@
+// ==========================================================================
+// PolygonStats: class definitions
+//
+// Michał Chawar
+// ==========================================================================
+// GeoPolygon
+// PolygonStats
+// PolygonMethod
+// PolygonAggregator
+//===========================================================================
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cfloat>
+#include <cstdint>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+#include <TileManager.hpp>
+
+
+// ----------------------------------------
+//
+//      GEO POLYGON class
+//
+// ----------------------------------------
+
+// Wielokąt w stopniach (x - długość, y - szerokość), np. granica jednostki administracyjnej. Pierścienie
+// domykane automatycznie; wnętrze według reguły parzystości - dziury i części rozłączne to kolejne pierścienie.
+class GeoPolygon {
+public:
+    std::vector<std::vector<glm::dvec2>> rings;
+public:
+    void addRing(std::vector<glm::dvec2> ring) {
+        if (ring.size() >= 3) this->rings.push_back(std::move(ring));
+    }
+    bool isEmpty() const {
+        return this->rings.empty();
+    }
+    size_t getVertices() const {
+        size_t n = 0;
+        for (auto const& ring : this->rings) n += ring.size();
+        return n;
+    }
+    // (długość min, szerokość min, długość max, szerokość max)
+    glm::dvec4 getBounds() const {
+        glm::dvec4 bounds(DBL_MAX, DBL_MAX, -DBL_MAX, -DBL_MAX);
+
+        for (auto const& ring : this->rings) {
+            for (glm::dvec2 const& p : ring) {
+                bounds.x = std::min(bounds.x, p.x);
+                bounds.y = std::min(bounds.y, p.y);
+                bounds.z = std::max(bounds.z, p.x);
+                bounds.w = std::max(bounds.w, p.y);
+            }
+        }
+        return bounds;
+    }
+};
+
+
+// ----------------------------------------
+//
+//      POLYGON STATS class
+//
+// ----------------------------------------
+
+// Statystyki wysokości próbek siatki 3" wewnątrz wielokąta (zob. PolygonAggregator). Próbka należy do
+// wielokąta, jeśli leży w jego wnętrzu lub na lewej / dolnej krawędzi - sąsiednie wielokąty podziału
+// administracyjnego nie liczą wspólnych próbek podwójnie.
+struct PolygonStats {
+    constexpr static float HEIGHT_MIN = -500.0f;        // Zakres histogramu; wysokości spoza - skrajne przedziały
+    constexpr static float HEIGHT_MAX = 9000.0f;
+
+    uint64_t count = 0;                 // Próbek z danymi
+    float min = FLT_MAX, max = -FLT_MAX;
+    double sum = 0.0;
+    double area = 0.0;                  // Powierzchnia próbek z danymi (km²)
+
+    float bin_width = 10.0f;            // histogram[k] - próbki w [(bin_first + k) * bin_width, (bin_first + k + 1) * bin_width),
+                                        // 0 - bez histogramu
+    int bin_first = 0;
+    std::vector<uint64_t> histogram;
+
+    size_t tiles = 0;                   // Kafli przecinających prostokąt ograniczający
+    uint64_t blocks = 0;                // Bloków piramidy wewnątrz wielokąta zliczonych bez czytania próbek
+    uint64_t scanned = 0;               // Próbek przeczytanych
+    unsigned int threads = 0;
+    float ms = 0.0f;
+public:
+    PolygonStats() {}
+    explicit PolygonStats(float bin_width) {
+        this->bin_width = bin_width;
+        if (bin_width <= 0.0f) return;
+
+        this->bin_first = (int)std::floor(HEIGHT_MIN / bin_width);
+        this->histogram.assign((size_t)((int)std::floor(HEIGHT_MAX / bin_width) - this->bin_first + 1), 0);
+    }
+    double getMean() const {
+        return this->count > 0 ? this->sum / this->count : 0.0;
+    }
+    bool hasHistogram() const {
+        return !this->histogram.empty();
+    }
+    int getBin(float h) const {
+        if (this->histogram.empty()) return 0;
+
+        int bin = (int)std::floor(h / this->bin_width) - this->bin_first;
+        return std::clamp(bin, 0, (int)this->histogram.size() - 1);
+    }
+    // Kwantyl q z histogramu, interpolowany liniowo w przedziale (np. 0.5 - mediana)
+    float getQuantile(double q) const {
+        if (this->count == 0) return 0.0f;
+
+        double target = q * this->count, seen = 0.0;
+        for (size_t k = 0; k < this->histogram.size(); k++) {
+            if (this->histogram[k] == 0 || seen + this->histogram[k] < target) {
+                seen += this->histogram[k];
+                continue;
+            }
+            float low = (this->bin_first + (int)k) * this->bin_width;
+            float h   = low + (float)((target - seen) / this->histogram[k]) * this->bin_width;
+            return std::clamp(h, this->min, this->max);
+        }
+        return this->max;
+    }
+    void add(float h) {
+        this->count++;
+        this->min = std::min(this->min, h);
+        this->max = std::max(this->max, h);
+        this->sum += h;
+        if (!this->histogram.empty()) this->histogram[this->getBin(h)]++;
+    }
+    // Blok piramidy wewnątrz wielokąta w całości w jednym przedziale histogramu (lub bez histogramu)
+    void addBlock(HeightPyramid::Block const& block) {
+        this->count += block.count;
+        this->min = std::min(this->min, block.min);
+        this->max = std::max(this->max, block.max);
+        this->sum += block.sum;
+        if (!this->histogram.empty()) this->histogram[this->getBin(block.min)] += block.count;
+        this->blocks++;
+    }
+    void merge(PolygonStats const& other) {
+        this->count += other.count;
+        this->min = std::min(this->min, other.min);
+        this->max = std::max(this->max, other.max);
+        this->sum  += other.sum;
+        this->area += other.area;
+        for (size_t k = 0; k < this->histogram.size(); k++) this->histogram[k] += other.histogram[k];
+
+        this->tiles   += other.tiles;
+        this->blocks  += other.blocks;
+        this->scanned += other.scanned;
+    }
+};
+
+
+// ----------------------------------------
+//
+//      POLYGON AGGREGATOR class
+//
+// ----------------------------------------
+
+enum class PolygonMethod {
+    Lookup,         // TileManager::getHeight dla każdej próbki, jeden wątek (odniesienie w -bench polygon)
+    Scan,           // Próbki odcinków wierszy, kafle w wątkach
+    Pyramid         // Jak Scan, bloki piramidy min/max w całości wewnątrz lub na zewnątrz bez czytania próbek
+};
+
+// Statystyki wysokości wewnątrz wielokąta na siatce 3" (kafle 1" - co trzecia próbka). Wielokąt
+// rasteryzowany wierszami siatki: przecięcia wiersza z krawędziami wyznaczają odcinki kolumn wewnątrz.
+// Zadanie na kafel (wspólny wiersz i kolumnę krawędzi liczy kafel północny / wschodni, jeśli jest, jak
+// w TerrainAnalysis::computeRegion); wyniki łączone w kolejności kafli - niezależne od liczby wątków.
+// Z PolygonMethod::Pyramid piramida kafla (Tile::getHeightPyramid) przeglądana od góry: blok bez
+// odcinków pomijany, blok w całości wewnątrz, którego min i max wpadają do jednego przedziału
+// histogramu (lub bez histogramu), dodawany z samych statystyk bloku; pozostałe dzielone aż do bloków
+// LEAF x LEAF.
+class PolygonAggregator {
+public:
+    PolygonAggregator(TileManager& tileManager) : tileManager(tileManager) {}
+
+    PolygonStats compute(GeoPolygon const& polygon) {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        PolygonStats result(this->binWidth);
+        if (polygon.isEmpty()) return result;
+
+        const int grid = Tile::BLOCK - 1;       // Próbek na stopień
+
+        // Krawędzie w jednostkach siatki (x - kolumna, y - wiersz od równika / południka 0), bez poziomych
+        std::vector<Edge> edges;
+        for (auto const& ring : polygon.rings) {
+            for (size_t k = 0; k < ring.size(); k++) {
+                glm::dvec2 a = ring[k] * (double)grid, b = ring[(k + 1) % ring.size()] * (double)grid;
+                if (a.y == b.y) continue;
+
+                edges.push_back(Edge{ a.x, a.y, b.y, (b.x - a.x) / (b.y - a.y) });
+            }
+        }
+
+        glm::dvec4 bounds = polygon.getBounds();
+        int row0 = (int)std::ceil(bounds.y * grid),  row1 = (int)std::floor(bounds.w * grid),
+            col0 = (int)std::ceil(bounds.x * grid),  col1 = (int)std::floor(bounds.z * grid);
+
+        if (this->method == PolygonMethod::Lookup) {
+            this->lookup(edges, row0, row1, result);
+        } else {
+            std::vector<Job> jobs;
+
+            for (int lat = (int)std::floor((double)row0 / grid); lat * grid <= row1; lat++) {
+                for (int lon = (int)std::floor((double)col0 / grid); lon * grid <= col1; lon++) {
+                    Tile const* tile = this->tileManager.findTile(lat, lon);
+                    if (tile == nullptr || (tile->getSamples() - 1) % grid != 0) continue;
+
+                    int i0 = std::max(row0 - lat * grid, 0), i1 = std::min(row1 - lat * grid, grid - 1),
+                        j0 = std::max(col0 - lon * grid, 0), j1 = std::min(col1 - lon * grid, grid - 1);
+
+                    if (this->tileManager.findTile(lat + 1, lon) == nullptr) i1 = std::min(row1 - lat * grid, grid);
+                    if (this->tileManager.findTile(lat, lon + 1) == nullptr) j1 = std::min(col1 - lon * grid, grid);
+                    if (i0 > i1 || j0 > j1) continue;
+
+                    jobs.push_back(Job{ tile, lat * grid, lon * grid, i0, i1, j0, j1 });
+                }
+            }
+            result.tiles   = jobs.size();
+            result.threads = this->run(jobs, edges, result);
+        }
+
+        result.ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        return result;
+    }
+public:
+    void setThreadCount(unsigned int n) {
+        this->threadCount = std::max(1u, n);
+    }
+    unsigned int getThreadCount() const {
+        return this->threadCount;
+    }
+    void setMethod(PolygonMethod method) {
+        this->method = method;
+    }
+    PolygonMethod getMethod() const {
+        return this->method;
+    }
+    // Szerokość przedziału histogramu (m), 0 - bez histogramu (piramida nie czyta próbek bloków wewnątrz)
+    void setBinWidth(float width) {
+        this->binWidth = width > 0.0f ? std::max(width, 0.1f) : 0.0f;
+    }
+    float getBinWidth() const {
+        return this->binWidth;
+    }
+private:
+    TileManager& tileManager;
+
+    unsigned int threadCount = std::max(1u, std::thread::hardware_concurrency());
+    PolygonMethod method = PolygonMethod::Pyramid;
+    float binWidth = 10.0f;
+
+    // Krawędź od (x0, y0) do wiersza y1, dxdy - przyrost x na wiersz
+    struct Edge {
+        double x0, y0, y1, dxdy;
+    };
+    // Wiersze [i0, i1] i kolumny [j0, j1] siatki kafla, którego próbka (0, 0) to wiersz row / kolumna col
+    struct Job {
+        Tile const* tile;
+        int row, col;
+        int i0, i1, j0, j1;
+    };
+    // Odcinek kolumn [begin, end) wiersza wewnątrz wielokąta
+    struct Span {
+        int begin, end;
+    };
+    enum class Cover { Outside, Inside, Partial };
+
+    // Stan zadania kafla: odcinki wierszy (wiersz i - spans[first[i - i0] .. first[i - i0 + 1]))
+    struct Context {
+        Tile const* tile;
+        HeightPyramid const* pyramid;
+        int step;
+        int i0, i1;
+        std::vector<int>    first;
+        std::vector<Span>   spans;
+        std::vector<double> row_area;       // Powierzchnia komórki wiersza (km²)
+        PolygonStats& stats;
+
+        Span const* begin(int i) const { return this->spans.data() + this->first[i - this->i0]; }
+        Span const* end(int i)   const { return this->spans.data() + this->first[i - this->i0 + 1]; }
+
+        float sample(int i, int j) const {
+            return this->tile->getSample(i * this->step, j * this->step);
+        }
+    };
+
+    // Powierzchnia komórki siatki 3" na szerokości `row` (wiersz od równika), km²
+    double cellArea(double row) const {
+        const int grid = Tile::BLOCK - 1;
+        double side = this->tileManager.getEarthRadiusMeters() / 1000.0 * glm::radians(1.0 / grid);
+
+        return side * side * std::cos(glm::radians(row / grid));
+    }
+    // Posortowane przecięcia krawędzi z wierszem y; próbki wewnątrz - kolumny [ceil(x[2k]), ceil(x[2k + 1]))
+    static void crossings(std::vector<Edge const*> const& edges, double y, std::vector<double>& xs) {
+        xs.clear();
+        for (Edge const* e : edges) {
+            if ((e->y0 <= y) != (e->y1 <= y)) xs.push_back(e->x0 + (y - e->y0) * e->dxdy);
+        }
+        std::sort(xs.begin(), xs.end());
+    }
+
+    unsigned int run(std::vector<Job> const& jobs, std::vector<Edge> const& edges, PolygonStats& result) {
+        std::vector<PolygonStats> partial(jobs.size(), PolygonStats(this->binWidth));
+        std::atomic<size_t> next{ 0 };
+
+        auto work = [&]() {
+            for (size_t k; (k = next++) < jobs.size(); ) this->compute(jobs[k], edges, partial[k]);
+        };
+
+        unsigned int n = (unsigned int)std::min<size_t>(this->threadCount, jobs.size());
+        std::vector<std::thread> workers;
+        for (unsigned int t = 1; t < n; t++) workers.emplace_back(work);
+        work();
+        for (auto& worker : workers) worker.join();
+
+        for (PolygonStats const& p : partial) result.merge(p);
+
+        return std::max(n, 1u);
+    }
+
+    void compute(Job const& job, std::vector<Edge> const& all_edges, PolygonStats& stats) {
+        // Krawędzie przecinające wiersze kafla
+        std::vector<Edge const*> edges;
+        double y_min = job.row + job.i0, y_max = job.row + job.i1;
+
+        for (Edge const& e : all_edges) {
+            if (std::max(e.y0, e.y1) >= y_min && std::min(e.y0, e.y1) <= y_max) edges.push_back(&e);
+        }
+
+        const int grid = Tile::BLOCK - 1;
+        Context ctx{ job.tile, nullptr, (job.tile->getSamples() - 1) / grid, job.i0, job.i1, {}, {}, {}, stats };
+        ctx.first.reserve(job.i1 - job.i0 + 2);
+        ctx.row_area.reserve(job.i1 - job.i0 + 1);
+
+        std::vector<double> xs;
+        for (int i = job.i0; i <= job.i1; i++) {
+            ctx.first.push_back((int)ctx.spans.size());
+            ctx.row_area.push_back(this->cellArea(job.row + i));
+
+            crossings(edges, job.row + i, xs);
+            for (size_t k = 0; k + 1 < xs.size(); k += 2) {
+                int a = std::max((int)std::ceil(xs[k]     - job.col), job.j0),
+                    b = std::min((int)std::ceil(xs[k + 1] - job.col), job.j1 + 1);
+
+                if (a < b) ctx.spans.push_back(Span{ a, b });
+            }
+        }
+        ctx.first.push_back((int)ctx.spans.size());
+        if (ctx.spans.empty()) return;
+
+        if (this->method == PolygonMethod::Pyramid) {
+            ctx.pyramid = &job.tile->getHeightPyramid();
+            this->visit(ctx, ctx.pyramid->getLevels() - 1, 0, 0, false);
+        } else {
+            for (int i = job.i0; i <= job.i1; i++) this->scanRow(ctx, i, 0, grid);
+        }
+    }
+
+    // Próbki wiersza i w odcinkach przyciętych do kolumn [c0, c1]
+    void scanRow(Context& ctx, int i, int c0, int c1) {
+        if (i < ctx.i0 || i > ctx.i1) return;
+
+        uint64_t count = ctx.stats.count;
+        for (Span const* s = ctx.begin(i); s != ctx.end(i); s++) {
+            int j1 = std::min(s->end - 1, c1);
+
+            for (int j = std::max(s->begin, c0); j <= j1; j++) {
+                float h = ctx.sample(i, j);
+                if (h != Tile::NO_DATA) ctx.stats.add(h);
+            }
+            ctx.stats.scanned += std::max(j1 - std::max(s->begin, c0) + 1, 0);
+        }
+        ctx.stats.area += (ctx.stats.count - count) * ctx.row_area[i - ctx.i0];
+    }
+
+    // Położenie bloku wierszy [r0, r1] i kolumn [c0, c1] względem odcinków
+    static Cover classify(Context const& ctx, int r0, int r1, int c0, int c1) {
+        bool inside = true, overlap = false;
+
+        for (int i = r0; i <= r1; i++) {
+            if (i < ctx.i0 || i > ctx.i1) {
+                inside = false;
+            } else {
+                // Pierwszy odcinek kończący się za c0
+                Span const* s = std::upper_bound(ctx.begin(i), ctx.end(i), c0, [](int c, Span const& span) { return c < span.end; });
+
+                bool row_overlap = s != ctx.end(i) && s->begin <= c1;
+                overlap = overlap || row_overlap;
+                inside  = inside && row_overlap && s->begin <= c0 && s->end > c1;
+            }
+            if (overlap && !inside) return Cover::Partial;
+        }
+        return inside ? Cover::Inside : (overlap ? Cover::Partial : Cover::Outside);
+    }
+
+    void visit(Context& ctx, int level, int bi, int bj, bool inside) {
+        HeightPyramid const& pyramid = *ctx.pyramid;
+
+        int size = HeightPyramid::getBlockSize(level);
+        int r0 = bi * size, r1 = std::min(r0 + size, pyramid.getGrid()) - 1,
+            c0 = bj * size, c1 = std::min(c0 + size, pyramid.getGrid()) - 1;
+
+        if (!inside) {
+            Cover cover = classify(ctx, r0, r1, c0, c1);
+            if (cover == Cover::Outside) return;
+            inside = cover == Cover::Inside;
+        }
+
+        if (inside) {
+            HeightPyramid::Block const& block = pyramid.get(level, bi, bj);
+            if (block.count == 0) return;
+
+            if (ctx.stats.getBin(block.min) == ctx.stats.getBin(block.max)) {
+                ctx.stats.addBlock(block);
+                ctx.stats.area += block.count * ctx.row_area[(r0 + r1) / 2 - ctx.i0];
+                return;
+            }
+        }
+
+        if (level > 0) {
+            int side = pyramid.getSide(level - 1);
+
+            for (int ci = 2 * bi; ci <= std::min(2 * bi + 1, side - 1); ci++) {
+                for (int cj = 2 * bj; cj <= std::min(2 * bj + 1, side - 1); cj++) this->visit(ctx, level - 1, ci, cj, inside);
+            }
+            return;
+        }
+
+        if (!inside) {
+            for (int i = r0; i <= r1; i++) this->scanRow(ctx, i, c0, c1);
+            return;
+        }
+
+        // Blok wewnątrz - wszystkie próbki, bez odcinków
+        for (int i = r0; i <= r1; i++) {
+            uint64_t count = ctx.stats.count;
+
+            for (int j = c0; j <= c1; j++) {
+                float h = ctx.sample(i, j);
+                if (h != Tile::NO_DATA) ctx.stats.add(h);
+            }
+            ctx.stats.area += (ctx.stats.count - count) * ctx.row_area[i - ctx.i0];
+        }
+        ctx.stats.scanned += (uint64_t)(r1 - r0 + 1) * (c1 - c0 + 1);
+    }
+
+    // Odniesienie: odcinki wierszy jak w compute, wysokość każdej próbki przez TileManager::getHeight
+    // (wyszukanie kafla po nazwie; próbka na krawędzi - kafel północny / wschodni, jeśli jest)
+    void lookup(std::vector<Edge> const& edges, int row0, int row1, PolygonStats& stats) {
+        std::vector<Edge const*> all;
+        for (Edge const& e : edges) all.push_back(&e);
+
+        std::vector<double> xs;
+        for (int row = row0; row <= row1; row++) {
+            crossings(all, row, xs);
+
+            uint64_t count = stats.count;
+            for (size_t k = 0; k + 1 < xs.size(); k += 2) {
+                for (int col = (int)std::ceil(xs[k]); col < (int)std::ceil(xs[k + 1]); col++) {
+                    float h = this->tileManager.getHeight(Coordinates(
+                        this->coordinate(row, Hemisphere::North, Hemisphere::South),
+                        this->coordinate(col, Hemisphere::East,  Hemisphere::West)
+                    ));
+                    if (h != Tile::NO_DATA) stats.add(h);
+                    stats.scanned++;
+                }
+            }
+            stats.area += (stats.count - count) * this->cellArea(row);
+        }
+        stats.threads = 1;
+    }
+    // Współrzędna próbki siatki 3" (numer od równika / południka 0)
+    static Coordinate coordinate(int index, Hemisphere positive, Hemisphere negative) {
+        const int grid = Tile::BLOCK - 1;
+        int seconds = std::abs(index) * (3600 / grid);
+
+        return Coordinate(seconds / 3600, seconds / 60 % 60, seconds % 60, index >= 0 ? positive : negative);
+    }
+};
@@ -0,0 +1,593 @@
+// ==========================================================================
+// SoftRasterizer: class definitions
+//
+// Michał Chawar
+// ==========================================================================
+// SoftRasterizer
+//===========================================================================
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+#include <TileManager.hpp>
+
+
+// ----------------------------------------
+//
+//      SOFT RASTERIZER class
+//
+// ----------------------------------------
+
+// Rysowanie kafli TileManager na CPU, bez OpenGL: te same pozycje wierzchołków co tile.vs (2D)
+// i tile3d.vs (3D), kolor heightToColor i cieniowanie rzeźby jak w shaderach, test głębokości
+// GL_LEQUAL. Obraz RGBA wierszami od dołu (jak z glReadPixels).
+//
+// Klatka w dwóch etapach w puli wątków (tworzonej raz, między etapami wątki czekają na kolejne zadanie):
+//   1. wierzchołki - kafle rozdzielane między wątki; krok siatki dobierany tak, by odstęp próbek
+//      na ekranie był nie mniejszy niż piksel; trójkąty trafiają do list kubełków ekranu
+//      (BIN x BIN pikseli) wątku, który je utworzył
+//   2. rasteryzacja - kubełki rozdzielane między wątki, każdy piksel zapisuje jeden wątek;
+//      funkcje krawędzi, głębokość i kolor liczone dla 4 pikseli naraz (wektory GCC - SSE / NEON)
+// Atrybuty interpolowane liniowo w przestrzeni ekranu (trójkąty mają rozmiar kilku pikseli).
+// Bez nakładki widoczności, maski wypełnionych braków i piramidy przeglądowej.
+class SoftRasterizer {
+public:
+    constexpr static int BIN = 64;
+
+    SoftRasterizer(unsigned int threads = 0) {
+        this->setThreads(threads);
+    }
+    ~SoftRasterizer() {
+        this->stopPool();
+    }
+public:
+    void setThreads(unsigned int threads) {
+        threads = threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+        if (threads != this->threads) this->stopPool();
+
+        this->threads = threads;
+    }
+    unsigned int getThreads() const {
+        return this->threads;
+    }
+    void resize(int width, int height) {
+        if (width == this->width && height == this->height) return;
+
+        this->width  = width;
+        this->height = height;
+        this->pitch  = (width + 3) & ~3;
+
+        this->bins_x = (width  + BIN - 1) / BIN;
+        this->bins_y = (height + BIN - 1) / BIN;
+
+        this->color.assign((size_t)this->pitch * height, 0);
+        this->depth.assign((size_t)this->pitch * height, 1.0f);
+    }
+    // Parametry jak TileManager::draw (drawDistance z tym samym mnożnikiem), tryb 2D / 3D z TileManager
+    void draw(TileManager& tileManager, glm::mat4 const& view, glm::mat4 const& projection, glm::vec3 const& position, glm::dvec3 const& eye, float drawDistance) {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        this->triangle_count = 0;
+        this->is3D       = tileManager.get3DProjection();
+        this->hillshade  = tileManager.getHillshade();
+        this->condensation = tileManager.getXCondensation();
+        this->radius     = tileManager.getEarthRadiusMeters() / 10.0;
+        this->transform  = projection * view;
+        this->focal      = projection[1][1] * this->height / 2.0f;
+        this->eye        = eye;
+        this->position   = position;
+
+        std::vector<Tile*> tiles = tileManager.getTilesInRange(position, drawDistance * 1.2f);
+
+        this->batches.resize(tiles.size());
+        this->bins.resize(this->threads);
+        for (auto& lists : this->bins) {
+            lists.resize((size_t)this->bins_x * this->bins_y);
+            for (auto& list : lists) list.clear();
+        }
+
+        // Etap 1: wierzchołki i przydział trójkątów do kubełków
+        std::atomic<size_t> next_tile{ 0 };
+        this->parallel([&](unsigned int thread) {
+            for (size_t k; (k = next_tile++) < tiles.size(); ) {
+                this->transformTile(*tiles[k], (uint32_t)k, this->bins[thread]);
+            }
+        });
+
+        auto raster = std::chrono::high_resolution_clock::now();
+        this->vertex_ms = std::chrono::duration<double, std::milli>(raster - start).count();
+
+        // Etap 2: czyszczenie i rasteryzacja kubełków
+        std::atomic<int> next_bin{ 0 };
+        std::atomic<uint64_t> triangles{ 0 };
+        this->parallel([&](unsigned int) {
+            uint64_t drawn = 0;
+
+            for (int b; (b = next_bin++) < this->bins_x * this->bins_y; ) {
+                int x0 = (b % this->bins_x) * BIN, y0 = (b / this->bins_x) * BIN;
+                int x1 = std::min(x0 + BIN, this->width), y1 = std::min(y0 + BIN, this->height);
+
+                for (int y = y0; y < y1; y++) {
+                    std::fill_n(&this->color[(size_t)y * this->pitch + x0], x1 - x0, CLEAR_COLOR);
+                    std::fill_n(&this->depth[(size_t)y * this->pitch + x0], x1 - x0, 1.0f);
+                }
+
+                for (auto const& lists : this->bins) {
+                    for (Triangle const& triangle : lists[b]) this->rasterize(triangle, x0, y0, x1, y1);
+                    drawn += lists[b].size();
+                }
+            }
+            triangles += drawn;
+        });
+
+        this->triangle_refs = triangles;
+        this->raster_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - raster).count();
+    }
+    // RGBA wierszami od dołu
+    std::vector<uint8_t> getImage() const {
+        std::vector<uint8_t> rgba((size_t)this->width * this->height * 4);
+
+        for (int y = 0; y < this->height; y++) {
+            std::memcpy(&rgba[(size_t)y * this->width * 4], &this->color[(size_t)y * this->pitch], (size_t)this->width * 4);
+        }
+        return rgba;
+    }
+    uint64_t getTriangleCount() const {
+        return this->triangle_count;
+    }
+    // Trójkąty razem z powtórzeniami w kolejnych kubełkach
+    uint64_t getBinnedCount() const {
+        return this->triangle_refs;
+    }
+    double getVertexMs() const {
+        return this->vertex_ms;
+    }
+    double getRasterMs() const {
+        return this->raster_ms;
+    }
+private:
+    typedef float   f4 __attribute__((vector_size(16)));
+    typedef int32_t i4 __attribute__((vector_size(16)));
+
+    constexpr static uint32_t CLEAR_COLOR = 0xFF000000;         // Czarny, alfa 1 (jak MapRenderer)
+
+    struct Vertex {
+        float x, y, z;                  // Piksele, głębokość [0, 1]; z < 0 - wierzchołek za kamerą
+        float r, g, b, shade;
+    };
+    struct Batch {
+        std::vector<Vertex> vertices;
+    };
+    struct Triangle {
+        uint32_t batch, v0, v1, v2;
+    };
+
+    unsigned int threads = 0;
+    int width = 0, height = 0, pitch = 0, bins_x = 0, bins_y = 0;
+    std::vector<uint32_t> color;
+    std::vector<float> depth;
+
+    std::vector<Batch> batches;
+    std::vector<std::vector<std::vector<Triangle>>> bins;       // [wątek][kubełek]
+
+    bool is3D = false, hillshade = true;
+    float condensation = 1.0f, focal = 1.0f;
+    double radius = 637800.0;
+    glm::mat4 transform;
+    glm::dvec3 eye;
+    glm::vec3 position;
+
+    std::atomic<uint64_t> triangle_count{ 0 };
+    uint64_t triangle_refs = 0;
+    double vertex_ms = 0.0, raster_ms = 0.0;
+
+    // Pula threads - 1 wątków (wątek 0 to wywołujący parallel), zadanie przekazywane przez numer pokolenia
+    std::vector<std::thread> pool;
+    std::mutex pool_mutex;
+    std::condition_variable pool_start, pool_done;
+    std::function<void(unsigned int)> const* job = nullptr;
+    uint64_t generation = 0;
+    unsigned int busy = 0;
+    bool stopping = false;
+
+    // work(wątek) we wszystkich wątkach puli i w wątku wywołującym, powrót po zakończeniu wszystkich
+    void parallel(std::function<void(unsigned int)> const& work) {
+        if (this->pool.size() + 1 != this->threads) this->startPool();
+
+        {
+            std::lock_guard<std::mutex> lock(this->pool_mutex);
+            this->job  = &work;
+            this->busy = (unsigned int)this->pool.size();
+            this->generation++;
+        }
+        this->pool_start.notify_all();
+
+        work(0);
+
+        std::unique_lock<std::mutex> lock(this->pool_mutex);
+        this->pool_done.wait(lock, [this]() { return this->busy == 0; });
+        this->job = nullptr;
+    }
+    void startPool() {
+        this->stopPool();
+
+        uint64_t seen = this->generation;
+        for (unsigned int k = 1; k < this->threads; k++) {
+            this->pool.emplace_back([this, k, seen]() mutable {
+                std::unique_lock<std::mutex> lock(this->pool_mutex);
+
+                while (true) {
+                    this->pool_start.wait(lock, [this, &seen]() { return this->stopping || this->generation != seen; });
+                    if (this->stopping) return;
+                    seen = this->generation;
+
+                    std::function<void(unsigned int)> const* work = this->job;
+                    lock.unlock();
+                    (*work)(k);
+                    lock.lock();
+
+                    if (--this->busy == 0) this->pool_done.notify_one();
+                }
+            });
+        }
+    }
+    void stopPool() {
+        {
+            std::lock_guard<std::mutex> lock(this->pool_mutex);
+            this->stopping = true;
+        }
+        this->pool_start.notify_all();
+
+        for (std::thread& thread : this->pool) thread.join();
+        this->pool.clear();
+        this->stopping = false;
+    }
+
+    // Jak heightToColor w tile.vs / tile3d.vs
+    static glm::vec3 heightToColor(float ht) {
+        if (ht < 0.0f) return glm::vec3(0.0f, 0.0f, 1.0f);
+        else if (ht < 500.0f) return glm::vec3(0.0f, ht / 500.0f, 0.0f);
+        else if (ht < 1000.0f) return glm::vec3((ht / 500.0f) - 1.0f, 1.0f, 0.0f);
+        else if (ht < 2000.0f) return glm::vec3(1.0f, 2.0f - ht / 1000.0f, 0.0f);
+        else return glm::vec3(1.0f, ht / 2000.0f - 1.0f, ht / 2000.0f - 1.0f);
+    }
+    // Jak hillshade w shaderach: różnice centralne sąsiednich próbek kafla, światło z północnego zachodu
+    static float hillshadeAt(Tile const& tile, int i, int j, float h, float cos_latitude) {
+        int last = tile.getSamples() - 1;
+        int w = std::max(j - 1, 0), e = std::min(j + 1, last),
+            s = std::max(i - 1, 0), n = std::min(i + 1, last);
+
+        float hw = tile.getSample(i, w), he = tile.getSample(i, e),
+              hs = tile.getSample(s, j), hn = tile.getSample(n, j);
+
+        if (hw < -999.0f) hw = h;
+        if (he < -999.0f) he = h;
+        if (hs < -999.0f) hs = h;
+        if (hn < -999.0f) hn = h;
+
+        float cell = 6378000.0f * glm::radians(1.0f / last);
+        float dzdx = (he - hw) / ((e - w) * cell * cos_latitude);
+        float dzdy = (hn - hs) / ((n - s) * cell);
+
+        glm::vec3 normal = glm::normalize(glm::vec3(-dzdx * 3.0f, -dzdy * 3.0f, 1.0f));
+        glm::vec3 light  = glm::normalize(glm::vec3(-0.5f, 0.5f, 0.7071f));
+
+        return glm::clamp(glm::dot(normal, light) / light.z, 0.0f, 1.5f);
+    }
+    // Położenie próbki w przestrzeni sceny: 2D jak tile.vs, 3D względem kamery jak tile3d.vs
+    glm::vec4 scenePosition(double lat, double lon, float h) const {
+        if (!this->is3D) return glm::vec4(lon * this->condensation, lat, 0.0f, 1.0f);
+
+        double la = glm::radians(lat), lo = glm::radians(lon);
+        glm::dvec3 up( std::cos(la) * std::cos(lo), std::sin(la), std::cos(la) * std::sin(lo) );
+
+        return glm::vec4( glm::vec3(up * (this->radius + h / 10.0) - this->eye), 1.0f );
+    }
+    // Kroki siatki części kafla (dzielą bok części: 120 lub 360 próbek). W 3D każdy krok dzieli
+    // następny (sklejanie krawędzi), w 2D wszystkie części kafla mają ten sam krok.
+    constexpr static int PATCHES = 10;
+    constexpr static int STEPS_3D[] = { 1, 2, 4, 8, 24, 120 };
+    constexpr static int STEPS_2D[] = { 1, 2, 3, 4, 5, 6, 8, 10, 12, 15, 20, 24, 30, 40, 60, 120 };
+
+    // Krok siatki części kafla (lat0, lon0, size stopni): odstęp sąsiednich wierzchołków na ekranie
+    // co najmniej 1 piksel w punkcie części najbliższym kamerze (jak TileManager::inDrawRange)
+    int patchStep(double lat0, double lon0, double size, int last) const {
+        double lat = glm::clamp((double)this->position.y, lat0, lat0 + size),
+               lon = glm::clamp((double)this->position.x, lon0, lon0 + size);
+
+        double pixels;
+        if (this->is3D) {
+            double distance = std::max(1.0, glm::length( glm::dvec3(this->scenePosition(lat, lon, 0.0f)) ));
+            pixels = this->radius * glm::radians(1.0 / last) / distance * this->focal;
+        } else {
+            glm::vec4 p = this->transform * this->scenePosition(lat, lon, 0.0f),
+                      u = this->transform * this->scenePosition(lat + 1.0 / last, lon + 1.0 / last, 0.0f);
+
+            pixels = std::min( std::abs(u.x - p.x) * this->width, std::abs(u.y - p.y) * this->height ) / 2.0;
+        }
+
+        auto largest = [pixels](auto const& steps) {
+            int step = 1;
+            for (int s : steps) {
+                if (s * pixels <= 1.0) step = s;
+            }
+            return step;
+        };
+        return this->is3D ? largest(STEPS_3D) : largest(STEPS_2D);
+    }
+    // Odrzucenie obszaru (size x size stopni), którego narożniki (w 3D na wysokościach od -1000
+    // do 9000 m) leżą poza tą samą płaszczyzną bryły widzenia
+    bool outsideFrustum(double lat0, double lon0, double size) const {
+        int outside[6] = { 0, 0, 0, 0, 0, 0 }, points = 0;
+
+        for (float h : { -1000.0f, 9000.0f }) {
+            for (int corner = 0; corner < 4; corner++) {
+                glm::vec4 c = this->transform * this->scenePosition(lat0 + size * (corner / 2), lon0 + size * (corner % 2), h);
+
+                outside[0] += c.x < -c.w; outside[1] += c.x > c.w;
+                outside[2] += c.y < -c.w; outside[3] += c.y > c.w;
+                outside[4] += c.z < -c.w; outside[5] += c.z > c.w;
+                points++;
+            }
+            if (!this->is3D) break;
+        }
+
+        for (int plane = 0; plane < 6; plane++) {
+            if (outside[plane] == points) return true;
+        }
+        return false;
+    }
+    // Kafel dzielony na PATCHES x PATCHES części odrzucanych osobno, każda z własnym krokiem siatki.
+    // Na krawędzi z rzadszą sąsiednią częścią wierzchołki pośrednie leżą na odcinku między jej
+    // wierzchołkami (bez szczelin w obrazie). Krawędzie kafli łączą się jak w OpenGL (bez sklejania).
+    void transformTile(Tile const& tile, uint32_t index, std::vector<std::vector<Triangle>>& lists) {
+        int lat0 = tile.origin.latitude .getDegreesSigned(),
+            lon0 = tile.origin.longitude.getDegreesSigned();
+
+        Batch& batch = this->batches[index];
+        batch.vertices.clear();
+        if (this->outsideFrustum(lat0, lon0, 1.0)) return;
+
+        int last = tile.getSamples() - 1,
+            side = last / PATCHES;
+        double patch = 1.0 / PATCHES;
+
+        int steps[PATCHES * PATCHES];
+        bool visible[PATCHES * PATCHES];
+        for (int p = 0; p < PATCHES * PATCHES; p++) {
+            double lat = lat0 + (p / PATCHES) * patch, lon = lon0 + (p % PATCHES) * patch;
+
+            visible[p] = !this->outsideFrustum(lat, lon, patch);
+            steps[p]   = visible[p] ? this->patchStep(lat, lon, patch, last) : 1;
+        }
+
+        // cos szerokości wierszy (cieniowanie), w 3D także sin i sin/cos długości kolumn - podwójna precyzja, raz na kafel
+        std::vector<double> trig(4 * (last + 1));
+        for (int k = 0; k <= last; k++) {
+            double angle = (double)k / last;
+            trig[4 * k] = std::cos(glm::radians(lat0 + angle));
+            if (!this->is3D) continue;
+
+            trig[4 * k + 1] = std::sin(glm::radians(lat0 + angle));
+            trig[4 * k + 2] = std::cos(glm::radians(lon0 + angle));
+            trig[4 * k + 3] = std::sin(glm::radians(lon0 + angle));
+        }
+
+        auto transform = [&](int i, int j, Vertex& v) {
+            float h = tile.getSample(i, j);
+            double const* row = &trig[4 * i];
+            double const* col = &trig[4 * j];
+
+            glm::vec4 scene;
+            if (this->is3D) {
+                double distance = this->radius + h / 10.0;
+
+                scene = glm::vec4( glm::vec3( glm::dvec3(row[0] * col[2], row[1], row[0] * col[3]) * distance - this->eye ), 1.0f );
+            } else {
+                scene = glm::vec4( (lon0 + (double)j / last) * this->condensation, lat0 + (double)i / last, 0.0f, 1.0f );
+            }
+
+            glm::vec4 clip = this->transform * scene;
+            glm::vec3 rgb  = heightToColor(h);
+
+            if (clip.w > 1e-6f) {
+                v.x = (clip.x / clip.w * 0.5f + 0.5f) * this->width;
+                v.y = (clip.y / clip.w * 0.5f + 0.5f) * this->height;
+                v.z =  clip.z / clip.w * 0.5f + 0.5f;
+            } else {
+                v.z = -1.0f;
+            }
+            v.r = rgb.x; v.g = rgb.y; v.b = rgb.z;
+            v.shade = this->hillshade ? hillshadeAt(tile, i, j, h, (float)row[0]) : 1.0f;
+        };
+        auto lerp = [](Vertex const& a, Vertex const& b, float t) {
+            if (a.z < 0.0f || b.z < 0.0f) return Vertex{ 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+
+            return Vertex{ a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t,
+                           a.r + (b.r - a.r) * t, a.g + (b.g - a.g) * t, a.b + (b.b - a.b) * t, a.shade + (b.shade - a.shade) * t };
+        };
+
+        uint64_t created = 0;
+        for (int p = 0; p < PATCHES * PATCHES; p++) {
+            if (!visible[p]) continue;
+
+            int pr = p / PATCHES, pc = p % PATCHES;
+            int step = steps[p], m = side / step;
+            uint32_t base = batch.vertices.size();
+
+            batch.vertices.resize(base + (size_t)(m + 1) * (m + 1));
+            Vertex* grid = &batch.vertices[base];
+
+            for (int r = 0; r <= m; r++) {
+                for (int c = 0; c <= m; c++) transform(pr * side + r * step, pc * side + c * step, grid[r * (m + 1) + c]);
+            }
+
+            // Sklejanie z rzadszymi sąsiednimi częściami: południe, północ, zachód, wschód
+            int neighbours[4][2] = { { pr - 1, pc }, { pr + 1, pc }, { pr, pc - 1 }, { pr, pc + 1 } };
+            for (int edge = 0; edge < 4; edge++) {
+                int nr = neighbours[edge][0], nc = neighbours[edge][1];
+                if (nr < 0 || nr >= PATCHES || nc < 0 || nc >= PATCHES) continue;
+
+                int ratio = steps[nr * PATCHES + nc] / step;
+                if (ratio <= 1) continue;
+
+                for (int k = 0; k <= m; k++) {
+                    if (k % ratio == 0) continue;
+
+                    int k0 = k - k % ratio, k1 = k0 + ratio;
+                    auto at = [&](int kk) -> Vertex& {
+                        return edge < 2 ? grid[(edge == 0 ? 0 : m) * (m + 1) + kk] : grid[kk * (m + 1) + (edge == 2 ? 0 : m)];
+                    };
+                    at(k) = lerp(at(k0), at(k1), (float)(k - k0) / ratio);
+                }
+            }
+
+            for (int r = 0; r < m; r++) {
+                for (int c = 0; c < m; c++) {
+                    uint32_t a = base + r * (m + 1) + c, b = a + 1, d = a + m + 1, e = d + 1;
+
+                    created += this->bin(batch, index, a, b, e, lists);
+                    created += this->bin(batch, index, a, e, d, lists);
+                }
+            }
+        }
+        this->triangle_count += created;
+    }
+    // Trójkąt do list kubełków, które przecina jego prostokąt otaczający
+    bool bin(Batch const& batch, uint32_t index, uint32_t i0, uint32_t i1, uint32_t i2, std::vector<std::vector<Triangle>>& lists) const {
+        Vertex const& v0 = batch.vertices[i0];
+        Vertex const& v1 = batch.vertices[i1];
+        Vertex const& v2 = batch.vertices[i2];
+
+        // Przycinanie do płaszczyzny bliskiej bez dzielenia trójkąta - odrzucenie całego
+        if (v0.z < 0.0f || v1.z < 0.0f || v2.z < 0.0f) return false;
+        if (v0.z > 1.0f && v1.z > 1.0f && v2.z > 1.0f) return false;
+
+        float min_x = std::min({ v0.x, v1.x, v2.x }), max_x = std::max({ v0.x, v1.x, v2.x }),
+              min_y = std::min({ v0.y, v1.y, v2.y }), max_y = std::max({ v0.y, v1.y, v2.y });
+
+        if (max_x < 0.0f || max_y < 0.0f || min_x >= this->width || min_y >= this->height) return false;
+
+        // Trójkąt między środkami pikseli
+        int x0 = (int)std::ceil(min_x - 0.5f), x1 = (int)std::floor(max_x - 0.5f),
+            y0 = (int)std::ceil(min_y - 0.5f), y1 = (int)std::floor(max_y - 0.5f);
+        if (x0 > x1 || y0 > y1) return false;
+
+        int bx0 = std::max(x0, 0) / BIN, bx1 = std::min(x1, this->width  - 1) / BIN,
+            by0 = std::max(y0, 0) / BIN, by1 = std::min(y1, this->height - 1) / BIN;
+
+        for (int by = by0; by <= by1; by++) {
+            for (int bx = bx0; bx <= bx1; bx++) lists[(size_t)by * this->bins_x + bx].push_back( Triangle{ index, i0, i1, i2 } );
+        }
+        return true;
+    }
+    void rasterize(Triangle const& triangle, int bin_x0, int bin_y0, int bin_x1, int bin_y1) {
+        std::vector<Vertex> const& vertices = this->batches[triangle.batch].vertices;
+        Vertex const* v0 = &vertices[triangle.v0];
+        Vertex const* v1 = &vertices[triangle.v1];
+        Vertex const* v2 = &vertices[triangle.v2];
+
+        float area = (v1->x - v0->x) * (v2->y - v0->y) - (v2->x - v0->x) * (v1->y - v0->y);
+        if (area == 0.0f) return;
+        if (area < 0.0f) {
+            std::swap(v1, v2);
+            area = -area;
+        }
+
+        int x0 = std::max(bin_x0,     (int)std::ceil (std::min({ v0->x, v1->x, v2->x }) - 0.5f)),
+            x1 = std::min(bin_x1 - 1, (int)std::floor(std::max({ v0->x, v1->x, v2->x }) - 0.5f)),
+            y0 = std::max(bin_y0,     (int)std::ceil (std::min({ v0->y, v1->y, v2->y }) - 0.5f)),
+            y1 = std::min(bin_y1 - 1, (int)std::floor(std::max({ v0->y, v1->y, v2->y }) - 0.5f));
+        if (x0 > x1 || y0 > y1) return;
+
+        // Funkcje krawędzi (wagi wierzchołków razy pole) i ich przyrosty w x i y
+        float ax[3] = { -(v2->y - v1->y), -(v0->y - v2->y), -(v1->y - v0->y) },
+              ay[3] = {   v2->x - v1->x,    v0->x - v2->x,    v1->x - v0->x  };
+
+        x0 &= ~3;
+        float px = x0 + 0.5f, py = y0 + 0.5f;
+        float e_start[3] = {
+            ax[0] * (px - v1->x) + ay[0] * (py - v1->y),
+            ax[1] * (px - v2->x) + ay[1] * (py - v2->y),
+            ax[2] * (px - v0->x) + ay[2] * (py - v0->y)
+        };
+
+        // Atrybut w punkcie = suma wag wierzchołków razy wartości / pole
+        auto plane = [&](float a0, float a1, float a2, float& dx, float& dy) {
+            dx = (ax[0] * a0 + ax[1] * a1 + ax[2] * a2) / area;
+            dy = (ay[0] * a0 + ay[1] * a1 + ay[2] * a2) / area;
+            return (e_start[0] * a0 + e_start[1] * a1 + e_start[2] * a2) / area;
+        };
+
+        float attribute[5], dx[5], dy[5];
+        attribute[0] = plane(v0->z,     v1->z,     v2->z,     dx[0], dy[0]);
+        attribute[1] = plane(v0->r,     v1->r,     v2->r,     dx[1], dy[1]);
+        attribute[2] = plane(v0->g,     v1->g,     v2->g,     dx[2], dy[2]);
+        attribute[3] = plane(v0->b,     v1->b,     v2->b,     dx[3], dy[3]);
+        attribute[4] = plane(v0->shade, v1->shade, v2->shade, dx[4], dy[4]);
+
+        const f4 lanes = { 0.0f, 1.0f, 2.0f, 3.0f };
+        f4 step_e[3], step_a[5];
+        for (int k = 0; k < 3; k++) step_e[k] = (f4){} + ax[k] * 4.0f;
+        for (int k = 0; k < 5; k++) step_a[k] = (f4){} + dx[k] * 4.0f;
+
+        for (int y = y0; y <= y1; y++) {
+            float row = y - y0;
+            f4 e[3], a[5];
+            for (int k = 0; k < 3; k++) e[k] = e_start[k] + ay[k] * row + ax[k] * lanes;
+            for (int k = 0; k < 5; k++) a[k] = attribute[k] + dy[k] * row + dx[k] * lanes;
+
+            uint32_t* color_row = &this->color[(size_t)y * this->pitch];
+            float*    depth_row = &this->depth[(size_t)y * this->pitch];
+
+            for (int x = x0; x <= x1; x += 4) {
+                const i4 columns = { x, x + 1, x + 2, x + 3 };
+                i4 inside = (e[0] >= 0.0f) & (e[1] >= 0.0f) & (e[2] >= 0.0f) & (columns <= x1);
+
+                if (inside[0] | inside[1] | inside[2] | inside[3]) {
+                    f4 old_depth;
+                    std::memcpy(&old_depth, depth_row + x, sizeof(f4));
+
+                    i4 pass = inside & (a[0] <= old_depth) & (a[0] >= 0.0f) & (a[0] <= 1.0f);
+
+                    if (pass[0] | pass[1] | pass[2] | pass[3]) {
+                        i4 old_color;
+                        std::memcpy(&old_color, color_row + x, sizeof(i4));
+
+                        // Kolor * cieniowanie do RGBA8 z zaokrągleniem (jak zapis do GL_RGBA8)
+                        f4 shade = a[4];
+                        auto channel = [&shade](f4 value) {
+                            f4 c = value * shade;
+                            c = c < 0.0f ? (f4){} : c;
+                            c = c > 1.0f ? (f4){} + 1.0f : c;
+                            return __builtin_convertvector(c * 255.0f + 0.5f, i4);
+                        };
+                        i4 rgba = channel(a[1]) | (channel(a[2]) << 8) | (channel(a[3]) << 16) | ((i4){} + (int32_t)CLEAR_COLOR);
+
+                        old_color = (rgba & pass) | (old_color & ~pass);
+                        old_depth = pass ? a[0] : old_depth;
+
+                        std::memcpy(color_row + x, &old_color, sizeof(i4));
+                        std::memcpy(depth_row + x, &old_depth, sizeof(f4));
+                    }
+                }
+
+                for (int k = 0; k < 3; k++) e[k] += step_e[k];
+                for (int k = 0; k < 5; k++) a[k] += step_a[k];
+            }
+        }
+    }
+};
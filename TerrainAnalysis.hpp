@@ -0,0 +1,406 @@
+// ==========================================================================
+// TerrainAnalysis: class definitions
+//
+// Michał Chawar
+// ==========================================================================
+// TerrainMeasure
+// TerrainRaster
+// TerrainAnalysis
+//===========================================================================
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <glm/glm.hpp>
+
+#include <TileManager.hpp>
+
+
+// ----------------------------------------
+//
+//      TERRAIN RASTER class
+//
+// ----------------------------------------
+
+enum class TerrainMeasure {
+    Slope,          // Nachylenie w stopniach (0 - 90)
+    Aspect,         // Ekspozycja: kierunek spadku w stopniach od północy zgodnie z ruchem wskazówek zegara (0 - 360)
+    Ruggedness      // Wskaźnik szorstkości TRI (Riley 1999): pierwiastek z sumy kwadratów różnic z 8 sąsiadami (m)
+};
+
+class TerrainRaster {
+public:
+    constexpr static float NO_VALUE = -1.0f;            // Brak danych (ekspozycja: także teren płaski)
+    constexpr static float SLOPE_SCALE = 60.0f;         // Nachylenie (°) odpowiadające pełnej skali nakładki
+    constexpr static float RUGGEDNESS_SCALE = 250.0f;   // TRI (m) odpowiadający pełnej skali nakładki
+
+    TerrainMeasure measure = TerrainMeasure::Slope;
+
+    double lat_min = 0.0, lon_min = 0.0;    // Położenie wartości (0, 0), czyli próbki w rogu południowo-zachodnim
+    double cell_size = 1.0 / 1200.0;        // Odstęp wartości w stopniach
+    int rows = 0, cols = 0;
+    std::vector<float> values;              // Wierszami od południa, rows * cols wartości
+
+    size_t tiles = 0;                       // Kafli, z których liczono
+    unsigned int threads = 0;
+    float computeTimeMs = 0.0f;
+public:
+    float get(int row, int col) const {
+        return this->values[(size_t)row * this->cols + col];
+    }
+    // Granice nakładki (lon, lat, szerokość, wysokość) - krawędzie skrajnych komórek (jak ViewshedResult)
+    glm::vec4 getOverlayBounds() const {
+        return glm::vec4(
+            this->lon_min - this->cell_size / 2.0,
+            this->lat_min - this->cell_size / 2.0,
+            this->cols * this->cell_size,
+            this->rows * this->cell_size
+        );
+    }
+    OverlayKind getOverlayKind() const {
+        switch (this->measure) {
+            case TerrainMeasure::Slope:  return OverlayKind::Slope;
+            case TerrainMeasure::Aspect: return OverlayKind::Aspect;
+            default:                     return OverlayKind::Ruggedness;
+        }
+    }
+    // Wartości dla TileManager::setOverlay: 0 - brak wartości, 1 - 255 - wartość przeskalowana do (0, 1]
+    // (nachylenie liniowo do SLOPE_SCALE, ekspozycja liniowo do 360°, TRI pierwiastkowo do RUGGEDNESS_SCALE)
+    std::vector<uint8_t> toOverlay() const {
+        std::vector<uint8_t> result(this->values.size());
+
+        for (size_t k = 0; k < this->values.size(); k++) {
+            float v = this->values[k];
+            if (v < 0.0f) { result[k] = 0; continue; }
+
+            switch (this->measure) {
+                case TerrainMeasure::Slope:  v = v / SLOPE_SCALE;                       break;
+                case TerrainMeasure::Aspect: v = v / 360.0f;                            break;
+                default:                     v = std::sqrt(v / RUGGEDNESS_SCALE);       break;
+            }
+            result[k] = (uint8_t)(1 + std::lround(std::min(v, 1.0f) * 254.0f));
+        }
+        return result;
+    }
+    static char const* getName(TerrainMeasure measure) {
+        switch (measure) {
+            case TerrainMeasure::Slope:  return "nachylenie";
+            case TerrainMeasure::Aspect: return "ekspozycja";
+            default:                     return "szorstkość (TRI)";
+        }
+    }
+};
+
+
+// ----------------------------------------
+//
+//      TERRAIN ANALYSIS class
+//
+// ----------------------------------------
+
+// Nachylenie, ekspozycja i szorstkość z okna 3 x 3 wokół każdej próbki (gradient metodą Horna).
+// Odstęp próbek w metrach: w pionie stały, w poziomie skrócony o cos szerokości geograficznej wiersza
+// (dokładna wartość, którą w widoku 2D przybliża TileManager::getXCondensation dla środka obszaru).
+// Okno na krawędziach kafla z sąsiadów (Tile::getHeightLinked), brakujące próbki zastępowane środkiem.
+//
+// Wiersz wyniku liczony jest z trzech wierszy wysokości z marginesem - z SSE2 po 4 próbki naraz
+// (arcus tangens wielomianem, błąd poniżej 0.001°), bez SSE2 lub z setVectorized(false) skalarnie
+// funkcjami z <cmath>. Kafle (dla jednego kafla - pasy wierszy) rozdzielane są między wątki.
+class TerrainAnalysis {
+public:
+    TerrainAnalysis(TileManager& tileManager) : tileManager(tileManager) {}
+public:
+    // Jeden kafel w jego rozdzielczości (1201 lub 3601 próbek na bok)
+    TerrainRaster computeTile(Tile const& tile, TerrainMeasure measure) {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        int last = tile.getSamples() - 1;
+
+        TerrainRaster result;
+        result.measure   = measure;
+        result.lat_min   = tile.origin.latitude .getDegreesSigned();
+        result.lon_min   = tile.origin.longitude.getDegreesSigned();
+        result.cell_size = 1.0 / last;
+        result.rows = result.cols = last + 1;
+        result.values.assign((size_t)result.rows * result.cols, TerrainRaster::NO_VALUE);
+        result.tiles = 1;
+
+        std::vector<Job> jobs;
+        int band = std::max(16, (result.rows + (int)this->threadCount * 4 - 1) / ((int)this->threadCount * 4));
+
+        for (int i = 0; i < result.rows; i += band)
+            jobs.push_back(Job{ &tile, 1, i, std::min(i + band, result.rows), 0, result.cols, (size_t)i * result.cols });
+
+        result.threads = this->run(jobs, measure, result);
+        result.computeTimeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        return result;
+    }
+    // Obszar w stopniach w siatce 3" (kafle 1" - co trzecia próbka); wartości bez kafla - NO_VALUE
+    TerrainRaster computeRegion(double lon_min, double lat_min, double lon_max, double lat_max, TerrainMeasure measure) {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        const int grid = Tile::BLOCK - 1;       // Wartości na stopień
+
+        int row0 = (int)std::floor(lat_min * grid), row1 = (int)std::ceil(lat_max * grid),
+            col0 = (int)std::floor(lon_min * grid), col1 = (int)std::ceil(lon_max * grid);
+
+        TerrainRaster result;
+        result.measure   = measure;
+        result.lat_min   = (double)row0 / grid;
+        result.lon_min   = (double)col0 / grid;
+        result.cell_size = 1.0 / grid;
+        result.rows = row1 - row0 + 1;
+        result.cols = col1 - col0 + 1;
+        result.values.assign((size_t)result.rows * result.cols, TerrainRaster::NO_VALUE);
+
+        // Zadanie na kafel; wspólny wiersz i kolumnę krawędzi liczy kafel północny / wschodni, jeśli jest
+        std::vector<Job> jobs;
+
+        for (int lat = (int)std::floor((double)row0 / grid); lat * grid <= row1; lat++) {
+            for (int lon = (int)std::floor((double)col0 / grid); lon * grid <= col1; lon++) {
+                Tile const* tile = this->tileManager.findTile(lat, lon);
+                if (tile == nullptr || (tile->getSamples() - 1) % grid != 0) continue;
+
+                int i0 = std::max(row0 - lat * grid, 0), i1 = std::min(row1 - lat * grid, grid - 1),
+                    j0 = std::max(col0 - lon * grid, 0), j1 = std::min(col1 - lon * grid, grid - 1);
+
+                if (this->tileManager.findTile(lat + 1, lon) == nullptr) i1 = std::min(row1 - lat * grid, grid);
+                if (this->tileManager.findTile(lat, lon + 1) == nullptr) j1 = std::min(col1 - lon * grid, grid);
+                if (i0 > i1 || j0 > j1) continue;
+
+                size_t offset = (size_t)(lat * grid + i0 - row0) * result.cols + (lon * grid + j0 - col0);
+                jobs.push_back(Job{ tile, (tile->getSamples() - 1) / grid, i0, i1 + 1, j0, j1 + 1, offset });
+                result.tiles++;
+            }
+        }
+
+        result.threads = this->run(jobs, measure, result);
+        result.computeTimeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        return result;
+    }
+public:
+    void setThreadCount(unsigned int n) {
+        this->threadCount = std::max(1u, n);
+    }
+    unsigned int getThreadCount() const {
+        return this->threadCount;
+    }
+    // false - wiersze liczone skalarnie (std::atan, std::atan2) - porównanie w -bench terrain
+    void setVectorized(bool vectorized) {
+#if defined(__SSE2__)
+        this->vectorized = vectorized;
+#endif
+    }
+    bool isVectorized() const {
+        return this->vectorized;
+    }
+private:
+    TileManager& tileManager;
+
+    unsigned int threadCount = std::max(1u, std::thread::hardware_concurrency());
+#if defined(__SSE2__)
+    bool vectorized = true;
+#else
+    bool vectorized = false;
+#endif
+
+    // Wiersze [i0, i1) i kolumny [j0, j1) wyniku z kafla w krokach co step próbek; pierwsza wartość
+    // zapisywana pod offset, kolejne wiersze co TerrainRaster::cols
+    struct Job {
+        Tile const* tile;
+        int step;
+        int i0, i1, j0, j1;
+        size_t offset;
+    };
+
+    unsigned int run(std::vector<Job> const& jobs, TerrainMeasure measure, TerrainRaster& result) {
+        std::atomic<size_t> next{ 0 };
+        double earth_radius = this->tileManager.getEarthRadiusMeters();
+
+        auto work = [&]() {
+            for (size_t k; (k = next++) < jobs.size(); )
+                this->compute(jobs[k], measure, earth_radius, result.values.data() + jobs[k].offset, result.cols);
+        };
+
+        unsigned int n = (unsigned int)std::min<size_t>(this->threadCount, jobs.size());
+        std::vector<std::thread> workers;
+        for (unsigned int t = 1; t < n; t++) workers.emplace_back(work);
+
+        work();
+        for (auto& w : workers) w.join();
+
+        return std::max(n, 1u);
+    }
+
+    void compute(Job const& job, TerrainMeasure measure, double earth_radius, float* out, int stride) const {
+        Tile const& tile = *job.tile;
+        int last = tile.getSamples() - 1, count = job.j1 - job.j0;
+        int padded = (count + 3) & ~3;
+
+        // Wiersze wysokości z marginesem: kolumna c wyniku pod indeksem c + 1, dopełnione do 4 wartości
+        std::vector<float> rows[3], values(padded);
+        for (auto& row : rows) row.assign(padded + 2, 0.0f);
+
+        auto read = [&tile, &job, last, count](int i, std::vector<float>& row) {
+            for (int c = -1; c <= count; c++) {
+                int j = (job.j0 + c) * job.step;
+
+                row[c + 1] = (i >= 0 && i <= last && j >= 0 && j <= last) ? tile.getSample(i, j) : (float)tile.getHeightLinked(i, j);
+            }
+        };
+
+        double cell_h = earth_radius * glm::radians((double)job.step / last);
+        double lat0   = tile.origin.latitude.getDegreesSigned();
+
+        read((job.i0 - 1) * job.step, rows[0]);
+        read( job.i0      * job.step, rows[1]);
+
+        for (int i = job.i0; i < job.i1; i++) {
+            read((i + 1) * job.step, rows[(i - job.i0 + 2) % 3]);
+
+            float const* s = rows[(i - job.i0)     % 3].data();
+            float const* m = rows[(i - job.i0 + 1) % 3].data();
+            float const* n = rows[(i - job.i0 + 2) % 3].data();
+
+            double cell_w = cell_h * std::cos(glm::radians(lat0 + (double)i * job.step / last));
+            float inv_dx8 = (float)(1.0 / (8.0 * cell_w)),
+                  inv_dy8 = (float)(1.0 / (8.0 * cell_h));
+
+            if (this->vectorized) kernelVector(measure, s, m, n, values.data(), padded, inv_dx8, inv_dy8);
+            else                  kernelScalar(measure, s, m, n, values.data(), count,  inv_dx8, inv_dy8);
+
+            std::memcpy(out + (size_t)(i - job.i0) * stride, values.data(), count * sizeof(float));
+        }
+    }
+
+    // Okno z, wierszami od południa: z[0] z[1] z[2] - południe, z[3] z[4] z[5], z[6] z[7] z[8] - północ
+    static void kernelScalar(TerrainMeasure measure, float const* s, float const* m, float const* n, float* out, int count, float inv_dx8, float inv_dy8) {
+        for (int c = 0; c < count; c++) {
+            float e = m[c + 1];
+            if (e <= Tile::NO_DATA) { out[c] = TerrainRaster::NO_VALUE; continue; }
+
+            float z[9] = { s[c], s[c + 1], s[c + 2], m[c], e, m[c + 2], n[c], n[c + 1], n[c + 2] };
+            for (float& v : z) if (v <= Tile::NO_DATA) v = e;
+
+            if (measure == TerrainMeasure::Ruggedness) {
+                float sum = 0.0f;
+                for (float v : z) sum += (v - e) * (v - e);
+
+                out[c] = std::sqrt(sum);
+                continue;
+            }
+
+            float dzdx = ((z[2] + 2.0f * z[5] + z[8]) - (z[0] + 2.0f * z[3] + z[6])) * inv_dx8,
+                  dzdy = ((z[6] + 2.0f * z[7] + z[8]) - (z[0] + 2.0f * z[1] + z[2])) * inv_dy8;
+
+            if (measure == TerrainMeasure::Slope) {
+                out[c] = glm::degrees(std::atan(std::sqrt(dzdx * dzdx + dzdy * dzdy)));
+            } else if (dzdx == 0.0f && dzdy == 0.0f) {
+                out[c] = TerrainRaster::NO_VALUE;
+            } else {
+                float aspect = glm::degrees(std::atan2(-dzdx, -dzdy));
+                out[c] = aspect < 0.0f ? aspect + 360.0f : aspect;
+            }
+        }
+    }
+
+#if defined(__SSE2__)
+    static __m128 select(__m128 mask, __m128 a, __m128 b) {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+    // arcus tangens dla x w [0, 1] (wielomian minimaksowy, błąd ok. 1e-5 rad)
+    static __m128 atanUnit(__m128 x) {
+        __m128 x2 = _mm_mul_ps(x, x);
+        __m128 p = _mm_set1_ps(-0.01172120f);
+        p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps( 0.05265332f));
+        p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(-0.11643287f));
+        p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps( 0.19354346f));
+        p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(-0.33262347f));
+        p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps( 0.99997726f));
+        return _mm_mul_ps(p, x);
+    }
+    // Jak kernelScalar, po 4 kolumny; count - wielokrotność 4
+    static void kernelVector(TerrainMeasure measure, float const* s, float const* m, float const* n, float* out, int count, float inv_dx8, float inv_dy8) {
+        const __m128 no_data  = _mm_set1_ps((float)Tile::NO_DATA),
+                     no_value = _mm_set1_ps(TerrainRaster::NO_VALUE),
+                     two      = _mm_set1_ps(2.0f),
+                     zero     = _mm_setzero_ps(),
+                     sign     = _mm_set1_ps(-0.0f),
+                     half_pi  = _mm_set1_ps((float)(M_PI / 2.0)),
+                     degrees  = _mm_set1_ps((float)(180.0 / M_PI)),
+                     dx8      = _mm_set1_ps(inv_dx8),
+                     dy8      = _mm_set1_ps(inv_dy8);
+
+        for (int c = 0; c < count; c += 4) {
+            __m128 e = _mm_loadu_ps(m + c + 1);
+            __m128 z[9] = {
+                _mm_loadu_ps(s + c), _mm_loadu_ps(s + c + 1), _mm_loadu_ps(s + c + 2),
+                _mm_loadu_ps(m + c), e,                       _mm_loadu_ps(m + c + 2),
+                _mm_loadu_ps(n + c), _mm_loadu_ps(n + c + 1), _mm_loadu_ps(n + c + 2)
+            };
+            for (__m128& v : z) v = select(_mm_cmple_ps(v, no_data), e, v);
+
+            __m128 result;
+
+            if (measure == TerrainMeasure::Ruggedness) {
+                __m128 sum = zero;
+                for (__m128 const& v : z) {
+                    __m128 d = _mm_sub_ps(v, e);
+                    sum = _mm_add_ps(sum, _mm_mul_ps(d, d));
+                }
+                result = _mm_sqrt_ps(sum);
+            } else {
+                __m128 dzdx = _mm_mul_ps(_mm_sub_ps(
+                                  _mm_add_ps(_mm_add_ps(z[2], _mm_mul_ps(two, z[5])), z[8]),
+                                  _mm_add_ps(_mm_add_ps(z[0], _mm_mul_ps(two, z[3])), z[6])), dx8),
+                       dzdy = _mm_mul_ps(_mm_sub_ps(
+                                  _mm_add_ps(_mm_add_ps(z[6], _mm_mul_ps(two, z[7])), z[8]),
+                                  _mm_add_ps(_mm_add_ps(z[0], _mm_mul_ps(two, z[1])), z[2])), dy8);
+
+                if (measure == TerrainMeasure::Slope) {
+                    // atan(g) = pi/2 - atan(1/g) dla g > 1
+                    __m128 g   = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dzdx, dzdx), _mm_mul_ps(dzdy, dzdy)));
+                    __m128 big = _mm_cmpgt_ps(g, _mm_set1_ps(1.0f));
+                    __m128 a   = atanUnit(select(big, _mm_div_ps(_mm_set1_ps(1.0f), g), g));
+
+                    result = _mm_mul_ps(select(big, _mm_sub_ps(half_pi, a), a), degrees);
+                } else {
+                    // Kierunek spadku (wschód, północ) = -gradient, kąt od północy zgodnie z ruchem wskazówek zegara
+                    __m128 east  = _mm_xor_ps(dzdx, sign),
+                           north = _mm_xor_ps(dzdy, sign);
+                    __m128 ax = _mm_andnot_ps(sign, east), ay = _mm_andnot_ps(sign, north);
+                    __m128 lo = _mm_min_ps(ax, ay), hi = _mm_max_ps(ax, ay);
+                    __m128 flat = _mm_cmpeq_ps(hi, zero);
+
+                    __m128 a = atanUnit(_mm_div_ps(lo, select(flat, _mm_set1_ps(1.0f), hi)));
+                    a = select(_mm_cmpgt_ps(ax, ay), _mm_sub_ps(half_pi, a), a);
+                    a = select(_mm_cmplt_ps(north, zero), _mm_sub_ps(_mm_set1_ps((float)M_PI), a), a);
+                    a = select(_mm_cmplt_ps(east, zero),  _mm_sub_ps(_mm_set1_ps((float)(2.0 * M_PI)), a), a);
+
+                    result = select(flat, no_value, _mm_mul_ps(a, degrees));
+                }
+            }
+
+            _mm_storeu_ps(out + c, select(_mm_cmple_ps(e, no_data), no_value, result));
+        }
+    }
+#else
+    static void kernelVector(TerrainMeasure measure, float const* s, float const* m, float const* n, float* out, int count, float inv_dx8, float inv_dy8) {
+        kernelScalar(measure, s, m, n, out, count, inv_dx8, inv_dy8);
+    }
+#endif
+};
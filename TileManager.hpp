@@ -7,7 +7,16 @@
 // Coordinate
 // Coordinates
 // 
+// HoleFill
+// HeightPyramid
+// OverlayKind
 // Tile
+// ProfileSample
+// ProfileCursor
+// TileIndex
+// TileLoader
+// OverviewNode
+// OverviewPyramid
 // TileManager
 //===========================================================================
 
@@ -21,17 +30,32 @@
 #include <cmath>
 
 #include <vector>
+#include <deque>
 #include <unordered_map>
+#include <unordered_set>
 
 #include <stdexcept>
 #include <cctype>
 #include <memory>
+#include <climits>
+#include <cfloat>
+#include <algorithm>
+
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
 #include <AGL3Drawable.hpp>
+#include <UploadRing.hpp>
+#include <HeightPool.hpp>
+#include <AdaptiveMesh.hpp>
+#include <VertexCache.hpp>
 
 
 // ----------------------------------------
@@ -233,19 +257,136 @@ public:
 //  
 // ----------------------------------------
 
+// Wynik wypełniania braków danych kafla (zob. Tile::fillHoles)
+struct HoleFill {
+    std::vector<uint8_t> mask;      // 1 - próbka wypełniona, układ jak wysokości kafla; puste - kafel bez braków
+    unsigned int filled = 0;        // Liczba wypełnionych próbek
+    float ms = 0.0f;                // Czas wypełniania (razem z wyszukaniem braków)
+};
+
+// Piramida min/max wysokości kafla (zob. Tile::getHeightPyramid): poziom 0 - bloki LEAF x LEAF próbek
+// siatki 3" (w kaflu 1" co trzecia próbka), każdy kolejny poziom łączy 2 x 2 bloki poprzedniego, aż do
+// jednego bloku na kafel. Próbki bez danych pomijane - count to liczba próbek z danymi.
+class HeightPyramid {
+public:
+    constexpr static int LEAF = 16;
+
+    struct Block {
+        float min, max;
+        double sum;                 // Suma wysokości - dokładna (wysokości float, suma double)
+        uint32_t count;
+    };
+
+    // get(i, j) - wysokość próbki siatki, grid - próbek siatki na bok, no_data - wartość braku danych
+    template <class Get>
+    void build(Get get, int grid, float no_data) {
+        this->grid = grid;
+        this->levels.clear();
+
+        int n = (grid + LEAF - 1) / LEAF;
+        std::vector<Block> level((size_t)n * n, Block{ FLT_MAX, -FLT_MAX, 0.0, 0 });
+
+        for (int i = 0; i < grid; i++) {
+            Block* row = level.data() + (size_t)(i / LEAF) * n;
+
+            for (int j = 0; j < grid; j++) {
+                float h = get(i, j);
+                if (h == no_data) continue;
+
+                Block& b = row[j / LEAF];
+                b.min = std::min(b.min, h);
+                b.max = std::max(b.max, h);
+                b.sum += h;
+                b.count++;
+            }
+        }
+        this->sides.assign(1, n);
+        this->levels.push_back(std::move(level));
+
+        while (n > 1) {
+            int m = (n + 1) / 2;
+            std::vector<Block> const& lower = this->levels.back();
+            std::vector<Block> upper((size_t)m * m, Block{ FLT_MAX, -FLT_MAX, 0.0, 0 });
+
+            for (int bi = 0; bi < n; bi++) {
+                for (int bj = 0; bj < n; bj++) {
+                    Block const& c = lower[(size_t)bi * n + bj];
+                    Block& b = upper[(size_t)(bi / 2) * m + bj / 2];
+
+                    b.min = std::min(b.min, c.min);
+                    b.max = std::max(b.max, c.max);
+                    b.sum += c.sum;
+                    b.count += c.count;
+                }
+            }
+            this->sides.push_back(m);
+            this->levels.push_back(std::move(upper));
+            n = m;
+        }
+    }
+    int getLevels() const {
+        return (int)this->levels.size();
+    }
+    // Bloków na bok poziomu
+    int getSide(int level) const {
+        return this->sides[level];
+    }
+    // Próbek na bok bloku poziomu (bloki na krawędzi kafla mniejsze)
+    static int getBlockSize(int level) {
+        return LEAF << level;
+    }
+    int getGrid() const {
+        return this->grid;
+    }
+    Block const& get(int level, int bi, int bj) const {
+        return this->levels[level][(size_t)bi * this->sides[level] + bj];
+    }
+    size_t getBytes() const {
+        size_t bytes = 0;
+        for (auto const& level : this->levels) bytes += level.size() * sizeof(Block);
+        return bytes;
+    }
+private:
+    int grid = 0;
+    std::vector<int> sides;
+    std::vector<std::vector<Block>> levels;
+};
+
+// Rodzaj nakładki na kaflach (uniform overlay_mode w tile.fs, zob. TileManager::setOverlay)
+enum class OverlayKind : int {
+    None       = 0,
+    Visibility = 1,         // Maska widoczności (ViewshedResult)
+    Slope      = 2,         // Analiza rzeźby (TerrainRaster::toOverlay)
+    Aspect     = 3,
+    Ruggedness = 4
+};
+
 class Tile : public AGLDrawable {
 public:
     Tile() : AGLDrawable(0) {
         // Inicjalizuj wysokości brakującymi danymi (-1000, wartość dowolna zgodna z aplikacją)
-        for (int i = 0; i < 1201; ++i) {
-            for (int j = 0; j < 1201; ++j) {
-                height_map[i][j] = NO_DATA; // Brak danych domyślnie
-            }
-        }
+        height_map.assign(BLOCK * BLOCK, NO_DATA);
+    }
+    Tile(Coordinates tile_origin, GLuint v2d, GLuint v3d, GLuint f, GLuint ebo, bool fill_holes = true) : AGLDrawable(0) {
+        this->setOrigin(tile_origin);
+        this->setSamples( decode(tile_origin, this->height_map, fill_holes, &this->hole_fill) );
+        if (brick_layout) this->toBricks();
+
+        this->v2d = v2d;
+        this->v3d = v3d;
+        this->f   = f;
+        this->EBO = ebo;
+
+        setShaders();
     }
-    Tile(Coordinates tile_origin, std::vector<glm::vec2> &vert, GLuint v2d, GLuint v3d, GLuint f, GLuint ebo) : Tile() {
-        this->vertices = &vert;
-        this->load(tile_origin);
+    // Kafel z wysokości zdekodowanych wcześniej (np. w wątku TileLoader), zob. decode
+    Tile(Coordinates tile_origin, Heights&& heights, int samples, GLuint v2d, GLuint v3d, GLuint f, GLuint ebo, HoleFill&& fill = HoleFill(), AdaptiveMesh&& mesh = AdaptiveMesh()) : AGLDrawable(0) {
+        this->setOrigin(tile_origin);
+        this->height_map = std::move(heights);
+        this->hole_fill  = std::move(fill);
+        this->mesh       = std::move(mesh);
+        this->setSamples(samples);
+        if (brick_layout) this->toBricks();
 
         this->v2d = v2d;
         this->v3d = v3d;
@@ -253,7 +394,17 @@ public:
         this->EBO = ebo;
 
         setShaders();
-        setBuffers();
+    }
+    ~Tile() {
+        // Sąsiedzi nie mogą wskazywać na usunięty kafel
+        this->unlink();
+
+        if (heightTexture) glDeleteTextures(1, &heightTexture);
+        if (maskTexture) {
+            glDeleteTextures(1, &maskTexture);
+            glDeleteBuffers(1, &maskBuffer);
+        }
+        if (meshBuffer) glDeleteBuffers(1, &meshBuffer);
     }
 public:
     void setShaders() {
@@ -271,10 +422,26 @@ public:
 
         CompileLink(pId, "Linking",  3);
     }
-    void setBuffers() {
+    // ring - bufor pośredni do kopiowania przez GPU; bez niego dane wysyłane są przez glBufferSubData
+    // do świeżo zaalokowanej (przy ponownym wysłaniu - osieroconej) pamięci bufora
+    void setBuffers(UploadRing* ring = nullptr) {
         bindBuffers();
+
+        // GPU zawsze w układzie bloków (zob. texelIndex), z cegiełek przepisywane przy wysyłaniu
+        Heights blocks;
+        float const* data = this->height_map.data();
+        if (this->bricked) {
+            blocks = this->toBlocks();
+            data   = blocks.data();
+        }
         
-        glBufferData(GL_ARRAY_BUFFER, 1201 * 1201 * sizeof(float), height_map, GL_STATIC_DRAW );
+        glBufferData(GL_ARRAY_BUFFER, this->getGpuBytes(), nullptr, GL_STATIC_DRAW );
+        if (ring != nullptr && ring->isAvailable())
+            ring->upload(vboId, data, this->getGpuBytes());
+        else
+            glBufferSubData(GL_ARRAY_BUFFER, 0, this->getGpuBytes(), data);
+
+        glBindBuffer(GL_ARRAY_BUFFER, vboId);
         glEnableVertexAttribArray(0);
         glVertexAttribPointer(
             0,                  // attribute 0, must match the layout in the shader.
@@ -284,29 +451,129 @@ public:
             0,//24,             // stride
             (void*)0            // array buffer offset
         );
+
+        // Widok bufora wysokości jako tekstury - shader wierzchołków odczytuje wysokości sąsiadów
+        // do wyznaczenia normalnych, bez dodatkowej pamięci po stronie CPU i GPU
+        if (heightTexture == 0) glGenTextures(1, &heightTexture);
+        glBindTexture(GL_TEXTURE_BUFFER, heightTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, vboId);
+
+        // Maska wypełnionych braków (tylko kafle z brakami) - do podglądu w tile.fs
+        if (!this->hole_fill.mask.empty()) {
+            if (maskTexture == 0) {
+                glGenBuffers(1, &maskBuffer);
+                glGenTextures(1, &maskTexture);
+            }
+            glBindBuffer(GL_TEXTURE_BUFFER, maskBuffer);
+            glBufferData(GL_TEXTURE_BUFFER, this->hole_fill.mask.size(), this->hole_fill.mask.data(), GL_STATIC_DRAW);
+
+            glBindTexture(GL_TEXTURE_BUFFER, maskTexture);
+            glTexBuffer(GL_TEXTURE_BUFFER, GL_R8, maskBuffer);
+        }
     }
-    void draw(glm::mat4 const& view, glm::mat4 const& projection, unsigned int indices_size, unsigned int offset) {
+    // Wysokości trafiają na GPU dopiero przy pierwszym rysowaniu (zob. TileManager::draw),
+    // kafle używane tylko do zapytań o wysokość nie zajmują pamięci karty
+    void upload(UploadRing* ring = nullptr) {
+        setBuffers(ring);
+        this->uploaded = true;
+    }
+    void release() {
+        bindBuffers();
+        glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_STATIC_DRAW);
+
+        if (maskTexture) {
+            glBindBuffer(GL_TEXTURE_BUFFER, maskBuffer);
+            glBufferData(GL_TEXTURE_BUFFER, 0, nullptr, GL_STATIC_DRAW);
+        }
+        // Indeksy siatki adaptacyjnej zostają w pamięci CPU, wysyłane ponownie przy rysowaniu
+        if (meshBuffer) {
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshBuffer);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, 0, nullptr, GL_STATIC_DRAW);
+            this->mesh_dirty = true;
+        }
+        this->uploaded = false;
+    }
+    bool isUploaded() const {
+        return this->uploaded;
+    }
+    // origin_offset - położenie narożnika kafla względem kamery (tylko 3D, liczone w podwójnej precyzji).
+    // Indeksy opisują siatkę jednego bloku (1201 x 1201), kafle 1" rysowane są blok po bloku.
+    void draw(glm::mat4 const& view, glm::mat4 const& projection, unsigned int indices_size, unsigned int offset, glm::vec3 const& origin_offset = glm::vec3(0.0f)) {
         bindProgram();
         bindBuffers();
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        this->setUniforms(view, projection, origin_offset);
+
+        for (int b = 0; b < this->blocks * this->blocks; b++) {
+            glDrawElementsBaseVertex(GL_TRIANGLES, indices_size, GL_UNSIGNED_INT, (void*)(offset * sizeof(unsigned int)), b * this->side * this->side);
+        }
+    }
+    // Rysowanie siatką adaptacyjną (zob. buildMesh) - indeksy całego kafla w osobnym buforze, wysyłane
+    // przy pierwszym rysowaniu
+    void drawMesh(glm::mat4 const& view, glm::mat4 const& projection, glm::vec3 const& origin_offset = glm::vec3(0.0f)) {
+        bindProgram();
+        bindBuffers();
 
+        if (meshBuffer == 0) glGenBuffers(1, &meshBuffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshBuffer);
+
+        if (this->mesh_dirty) {
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, this->mesh.indices.size() * sizeof(unsigned int), this->mesh.indices.data(), GL_STATIC_DRAW);
+            this->mesh_dirty = false;
+        }
+        this->setUniforms(view, projection, origin_offset);
+
+        glDrawElements(GL_TRIANGLES, this->mesh.indices.size(), GL_UNSIGNED_INT, (void*)0);
+    }
+private:
+    void setUniforms(glm::mat4 const& view, glm::mat4 const& projection, glm::vec3 const& origin_offset) {
         if (!this->is3D) glUniform1f(4, this->x_condensation);
         glUniform1i(5, this->origin.latitude .getDegreesSigned());
         glUniform1i(6, this->origin.longitude.getDegreesSigned());
+        glUniform1i(13, this->samples);
+        if (!this->is3D) glUniform1i(16, this->span);
+
+        if (this->is3D) {
+            glUniform3fv(10, 1, glm::value_ptr(origin_offset));
+            glUniform4fv(11, 1, glm::value_ptr(this->origin_trig));
+
+            glUniform1i(12, this->trig_tables_enabled);
+            if (this->trig_tables_enabled) {
+                glActiveTexture(GL_TEXTURE2);
+                glBindTexture(GL_TEXTURE_BUFFER, this->lat_table);
+                glActiveTexture(GL_TEXTURE3);
+                glBindTexture(GL_TEXTURE_BUFFER, this->lon_table);
+            }
+        }
+
+        glUniform1i(7, (int)this->overlay_kind);
+        if (this->overlay_kind != OverlayKind::None) glUniform4fv(8, 1, glm::value_ptr(this->overlay_bounds));
+
+        glUniform1i(9, this->hillshade_enabled);
+        if (this->hillshade_enabled) {
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_BUFFER, heightTexture);
+        }
+
+        bool mask = this->fill_mask_visible && this->maskTexture != 0;
+        glUniform1i(17, mask);
+        if (mask) {
+            glActiveTexture(GL_TEXTURE4);
+            glBindTexture(GL_TEXTURE_BUFFER, maskTexture);
+        }
 
         glUniformMatrix4fv(14, 1, GL_FALSE, glm::value_ptr(view));
         glUniformMatrix4fv(15, 1, GL_FALSE, glm::value_ptr(projection));
-
-        glDrawElements(GL_TRIANGLES, indices_size, GL_UNSIGNED_INT, (void*)(offset * sizeof(unsigned int)));
     }
 public:
+    // i, j - wiersz (od południa) i kolumna próbki, w zakresie [0, samples - 1]
     short getHeight(int i, int j) const {
-        if (i < 0 || i >= 1201 || j < 0 || j >= 1201) {
+        if (i < 0 || i >= this->samples || j < 0 || j >= this->samples) {
             throw std::out_of_range("Indeks poza zakresem mapy wysokości.");
         }
 
-        return height_map[i][j];
+        return height_map[ this->texel(i, j) ];
     }
     short getHeight(Coordinates const& coords) {
         if (coords.latitude.getMinutes() < 0 || coords.latitude.getMinutes() > 60 || (coords.latitude.getMinutes() == 60 && coords.latitude.getSeconds() != 0) || coords.latitude.getSeconds() < 0 || coords.latitude.getSeconds() > 59) {
@@ -316,326 +583,2120 @@ public:
             throw std::out_of_range("Longitude out of bounds for minutes/seconds: " + std::to_string(coords.longitude.getMinutes()) + " / " + std::to_string(coords.longitude.getSeconds()) + ".");
         }
 
-        int x = coords.longitude.getMinutes() * 20 + coords.longitude.getSeconds() / 3;
-        int y = coords.latitude .getMinutes() * 20 + coords.latitude .getSeconds() / 3;
+        // Krok siatki w sekundach: 3" (1201 próbek) lub 1" (3601 próbek)
+        int last = this->samples - 1;
+        int x = (coords.longitude.getMinutes() * 60 + coords.longitude.getSeconds()) * last / 3600;
+        int y = (coords.latitude .getMinutes() * 60 + coords.latitude .getSeconds()) * last / 3600;
         
         if (coords.longitude.getHemisphere() == Hemisphere::South)
-            y = 1200 - y;
+            y = last - y;
         if (coords.latitude .getHemisphere() == Hemisphere::West)
-            x = 1200 - x;
+            x = last - x;
 
-        return height_map[y][x];
+        return height_map[ this->texel(y, x) ];
     }
-    void  setXCondensation(float x_condensation) {
-        this->x_condensation = x_condensation;
+    // Wysokość interpolowana dwuliniowo, y/x - położenie w kaflu jako ułamek stopnia w zakresie [0, 1]
+    float getHeightInterpolated(double y, double x) const {
+        int last = this->samples - 1;
+
+        y = std::clamp(y, 0.0, 1.0) * last;
+        x = std::clamp(x, 0.0, 1.0) * last;
+
+        int i = std::min((int)y, last - 1),
+            j = std::min((int)x, last - 1);
+        float fy = y - i, fx = x - j;
+
+        float h00 = height_map[ texel(i, j) ],     h01 = height_map[ texel(i, j + 1) ],
+              h10 = height_map[ texel(i + 1, j) ], h11 = height_map[ texel(i + 1, j + 1) ];
+
+        // Przy brakujących danych zwróć najbliższą próbkę zamiast mieszać z NO_DATA
+        if (h00 == NO_DATA || h01 == NO_DATA || h10 == NO_DATA || h11 == NO_DATA)
+            return height_map[ texel(i + (fy >= 0.5f), j + (fx >= 0.5f)) ];
+
+        return (h00 * (1.0f - fx) + h01 * fx) * (1.0f - fy)
+             + (h10 * (1.0f - fx) + h11 * fx) * fy;
     }
-    static Coordinates decodeTileNameString(std::string tileName) {
-        if (tileName.length() != 7) throw std::invalid_argument("Tile name must consist of exactly 7 characters: " + tileName);
-        
-        unsigned short deg_lat, deg_lon;
-        Hemisphere h_lat, h_lon;
+    // Próbka poza kaflem odczytywana z sąsiada (zob. link); i, j w zakresie [-(samples - 1), 2 * (samples - 1)].
+    // Wspólne krawędzie kafli dają tę samą wartość niezależnie od strony. Brak sąsiada - NO_DATA.
+    short getHeightLinked(int i, int j) const {
+        int last = this->samples - 1;
+        int di = (i > last) - (i < 0),
+            dj = (j > last) - (j < 0);
+
+        Tile const* tile = this->neighbours[(di + 1) * 3 + (dj + 1)];
+        if (tile == nullptr) return NO_DATA;
+
+        i -= di * last;
+        j -= dj * last;
+
+        // Sąsiad o innej rozdzielczości - najbliższa próbka
+        if (tile->samples != this->samples) {
+            i = (i * (tile->samples - 1) + last / 2) / last;
+            j = (j * (tile->samples - 1) + last / 2) / last;
+        }
 
-        if      (tileName[0] == 'N') h_lat = Hemisphere::North;
-        else if (tileName[0] == 'S') h_lat = Hemisphere::South;
-        else throw std::invalid_argument("Invalid hemisphere for latitude in tile name: " + tileName);
-        
-        if      (tileName[3] == 'E') h_lon = Hemisphere::East;
-        else if (tileName[3] == 'W') h_lon = Hemisphere::West;
-        else throw std::invalid_argument("Invalid hemisphere for longitude in tile name: " + tileName);
+        return tile->height_map[ tile->texel(i, j) ];
+    }
+    // Próbka (i, j) bez sprawdzania zakresu (pętle po całym kaflu, np. SoftRasterizer)
+    float getSample(int i, int j) const {
+        return height_map[ this->texel(i, j) ];
+    }
+    // Okno 3 x 3 wokół próbki (i, j), wierszami od południa - także na krawędziach kafla (normalne, nachylenie)
+    void getWindow(int i, int j, float window[9]) const {
+        int last = this->samples - 1;
+
+        if (i > 0 && i < last && j > 0 && j < last) {
+            for (int di = -1; di <= 1; di++) {
+                for (int dj = -1; dj <= 1; dj++) {
+                    window[(di + 1) * 3 + (dj + 1)] = height_map[ this->texel(i + di, j + dj) ];
+                }
+            }
+            return;
+        }
 
-        if ( !(std::isdigit(tileName[1]) && std::isdigit(tileName[2]) && std::isdigit(tileName[4]) && std::isdigit(tileName[5]) && std::isdigit(tileName[6])) )
-            throw std::invalid_argument("Invalid digits in tile name: " + tileName);
-        
-        deg_lat = (tileName[1] - '0') * 10  + (tileName[2] - '0');
-        deg_lon = (tileName[4] - '0') * 100 + (tileName[5] - '0') * 10 + (tileName[6] - '0');
+        for (int di = -1; di <= 1; di++) {
+            for (int dj = -1; dj <= 1; dj++) {
+                window[(di + 1) * 3 + (dj + 1)] = this->getHeightLinked(i + di, j + dj);
+            }
+        }
+    }
+    // Sąsiad przesunięty o di (szerokość) i dj (długość) stopni, di, dj w zakresie [-1, 1]; (0, 0) - ten kafel
+    Tile* getNeighbour(int di, int dj) const {
+        return this->neighbours[(di + 1) * 3 + (dj + 1)];
+    }
+    // Łączy kafel z sąsiadem w obu kierunkach (nullptr - rozłączenie), zob. TileManager::addTile
+    void link(int di, int dj, Tile* other) {
+        int k = (di + 1) * 3 + (dj + 1);
 
-        return Coordinates(deg_lat, h_lat, deg_lon, h_lon);
+        this->neighbours[k] = other;
+        if (other != nullptr) other->neighbours[8 - k] = this;
     }
-public:
-    const static short NO_DATA = -1000;
-    static std::string path;
-    Coordinates origin;
-private:
-    float height_map[1201][1201];
+    // Rozłącza kafel ze wszystkimi sąsiadami w obu kierunkach, zob. TileManager::evictTile
+    void unlink() {
+        for (int k = 0; k < 9; k++) {
+            if (k == 4 || this->neighbours[k] == nullptr) continue;
 
-    GLuint v2d, v3d, f;
-    bool is3D = false;
-    
-    GLuint VBO, EBO;
-    std::vector<glm::vec2>* vertices;
-    int height = 1201, width = 1201;
-    float x_condensation = 1.0f;
+            this->neighbours[k]->neighbours[8 - k] = nullptr;
+            this->neighbours[k] = nullptr;
+        }
+    }
+    // Próbek na bok kafla: 1201 (3") lub 3601 (1"), węzły piramidy przeglądowej - 241
+    int getSamples() const {
+        return this->samples;
+    }
+    // Rozmiar boku w stopniach (węzły piramidy przeglądowej obejmują 2^poziom stopni)
+    void  setSpan(short span) {
+        this->span = span;
+    }
+    short getSpan() const {
+        return this->span;
+    }
+    size_t getGpuBytes() const {
+        return (size_t)this->blocks * this->blocks * this->side * this->side * sizeof(float);
+    }
+    bool isBricked() const {
+        return this->bricked;
+    }
+    void  setXCondensation(float x_condensation) {
+        this->x_condensation = x_condensation;
+    }
+    void  setOverlay(OverlayKind kind, glm::vec4 const& bounds) {
+        this->overlay_kind   = kind;
+        this->overlay_bounds = bounds;
+    }
+    void  setHillshade(bool enabled) {
+        this->hillshade_enabled = enabled;
+    }
+    // Podgląd wypełnionych braków danych (zob. fillHoles)
+    void  setFillMaskVisible(bool visible) {
+        this->fill_mask_visible = visible;
+    }
+    HoleFill const& getHoleFill() const {
+        return this->hole_fill;
+    }
+    // Siatka adaptacyjna kafla dla błędu pionowego `error` (m), zob. RtinBuilder. Tylko CPU -
+    // może być wywoływana z dowolnego wątku, wynik przekazywany przez setMesh.
+    AdaptiveMesh buildMesh(float error) const {
+        if (!this->bricked) return RtinBuilder::build(this->height_map.data(), this->samples, error);
 
-    void load(Coordinates const& origin) {
+        Heights blocks = this->toBlocks();
+        return RtinBuilder::build(blocks.data(), this->samples, error);
+    }
+    void  setMesh(AdaptiveMesh&& mesh) {
+        this->mesh = std::move(mesh);
+        this->mesh_dirty = true;
+    }
+    AdaptiveMesh const& getMesh() const {
+        return this->mesh;
+    }
+    // Piramida min/max wysokości na siatce 3" (zob. HeightPyramid), budowana przy pierwszym użyciu.
+    // Tylko CPU - może być wywoływana z dowolnego wątku (np. PolygonAggregator).
+    HeightPyramid const& getHeightPyramid() const {
+        std::call_once(this->pyramid_once, [this]() {
+            int step = (this->samples - 1) / (BLOCK - 1);
+
+            this->pyramid.build([this, step](int i, int j) { return this->getSample(i * step, j * step); }, BLOCK, NO_DATA);
+        });
+        return this->pyramid;
+    }
+    // Tablice różnic sin/cos dla wierszy (szerokość) i kolumn (długość) kafla, zob. TileManager::getTrigTable
+    void  setTrigTables(GLuint lat_table, GLuint lon_table) {
+        this->lat_table = lat_table;
+        this->lon_table = lon_table;
+    }
+    void  setTrigTablesEnabled(bool enabled) {
+        this->trig_tables_enabled = enabled;
+    }
+    // Odczyt pliku .hgt kafla (rozdzielczość 3" lub 1" rozpoznawana po rozmiarze pliku) do tablicy
+    // wysokości w układzie bloków (zob. texel) i wypełnienie braków danych (gdy fill_holes, wynik
+    // w `fill`); zwraca liczbę próbek na bok kafla.
+    // Bez użycia OpenGL - może być wywoływany z dowolnego wątku.
+    static int decode(Coordinates const& origin, Heights& heights, bool fill_holes = false, HoleFill* fill = nullptr) {
         std::string file_name = path + origin.getTileString() + ".hgt";
 
         // Otwieranie pliku w trybie binarnym
-        std::ifstream file(file_name, std::ios::binary);
+        std::ifstream file(file_name, std::ios::binary | std::ios::ate);
         if (!file) {
             throw std::runtime_error("Nie można otworzyć pliku: " + file_name);
         }
 
-        this->origin = Coordinates( origin.latitude.getDegreesSigned(), origin.longitude.getDegreesSigned() );
-
-        // Ładowanie danych do height_map
-        for (short i = 0; i < 1201; ++i) {
-            for (short j = 0; j < 1201; ++j) {
-                unsigned char buffer[2];
-                if (!file.read(reinterpret_cast<char*>(buffer), 2)) {
-                    throw std::runtime_error("Błąd odczytu danych z pliku: " + file_name);
-                }
+        std::streamoff size = file.tellg();
+        int samples;
 
-                // Zamiana kolejności bajtów
-                short value = static_cast<short>((buffer[0] << 8) | buffer[1]);
+        if      (size == (std::streamoff)1201 * 1201 * 2) samples = 1201;
+        else if (size == (std::streamoff)3601 * 3601 * 2) samples = 3601;
+        else throw std::runtime_error("Nieobsługiwany rozmiar pliku: " + file_name);
 
-                // Sprawdzenie zakresu wartości
-                if (value < -500 || value > 9000) {
-                    height_map[1200 - i][j] = NO_DATA; // Brak danych
-                } else {
-                    height_map[1200 - i][j] = value;
-                }
-            }
+        // Odczyt całego pliku naraz
+        std::vector<unsigned char> buffer(size);
+        file.seekg(0);
+        if (!file.read(reinterpret_cast<char*>(buffer.data()), buffer.size())) {
+            throw std::runtime_error("Błąd odczytu danych z pliku: " + file_name);
         }
 
-        file.close();
-        // std::cout << "Pomyślnie załadowano dane z pliku: " << file_name << "\n";
-    }
-};
+        int blocks = (samples - 1) / (BLOCK - 1);
+        heights.resize((size_t)blocks * blocks * BLOCK * BLOCK);
 
+        for (int bi = 0; bi < blocks; ++bi) {
+            for (int bj = 0; bj < blocks; ++bj) {
+                float* block = &heights[(size_t)(bi * blocks + bj) * BLOCK * BLOCK];
 
-// ----------------------------------------
-//  
-//      TILE MANAGER class
-//  
-// ----------------------------------------
-
-class TileManager : public AGLDrawable {
-private:
-    std::unordered_map<std::string, std::unique_ptr<Tile>> tiles;
-    std::vector<std::string> loaded_keys;
-    
-    std::vector<glm::vec2> vertices;
-    std::vector<unsigned int> indices[10];
-    unsigned int ind_offsets[10];
-    unsigned short user_lod = 5;
+                for (int i = 0; i < BLOCK; ++i) {
+                    // Wiersze w pliku od północy
+                    unsigned char const* row = &buffer[((size_t)(samples - 1 - (bi * (BLOCK - 1) + i)) * samples + bj * (BLOCK - 1)) * 2];
+                    float* dst = &block[(size_t)i * BLOCK];
 
-    Coordinates limit_sw = Coordinates((short)0, 0),
-                limit_ne = Coordinates((short)0, 0);
-    bool  unbounded_lat = true,
-          unbounded_lon = true;
-    
-    GLuint v2d, v3d, f;
-    GLuint EBO;
-    bool is3D = false;
+                    for (int j = 0; j < BLOCK; ++j) {
+                        // Zamiana kolejności bajtów
+                        short value = static_cast<short>((row[2 * j] << 8) | row[2 * j + 1]);
 
-    unsigned int tilesRendered = 0;
-    
-    const static std::string NOT_LOADED;
-    const float earthRadius = 637800.0;
-public:
-    TileManager() {
-        // Generowanie wierzchołków
-        int width = 1201, height = 1201;
-        int i0, i1, i2, i3;
-
-        for (int i = 0; i < height; i++) {
-            for (int j = 0; j < width; j++) {
-                vertices.emplace_back((float)i / (height - 1), (float)j / (width - 1));
-            }
-        }
-
-        // Generowanie indeksów
-        for (int i = 0; i < height - 1; i++) {
-            for (int j = 0; j < width - 1; j++) {
-                for (int lod = 1; lod <= 9; lod++) {
-                    if (i % lod || j % lod) continue;
-                    
-                    i0 = i * width + j;
-                    i1 = std::min(i0 + lod,         (i + 1) * width - 1);
-                    i2 = std::min(i0 + width * lod, width * (height - 1) + j);
-                    i3 = std::min(i2 + lod,         ((i2 / width) + 1) * width - 1);
-
-                    indices[lod].push_back(i0);
-                    indices[lod].push_back(i1);
-                    indices[lod].push_back(i2);
-
-                    indices[lod].push_back(i1);
-                    indices[lod].push_back(i3);
-                    indices[lod].push_back(i2);
+                        // Sprawdzenie zakresu wartości
+                        dst[j] = (value < -500 || value > 9000) ? NO_DATA : value;
+                    }
                 }
             }
         }
 
-        setShaders();
-        setBuffers();
+        if (fill_holes) {
+            HoleFill local;
+            fillHoles(origin, heights, samples, fill != nullptr ? *fill : local);
+        }
+
+        return samples;
     }
+    // Wypełnianie braków danych (NO_DATA) metodą wielosiatkową (pull-push): dla każdego obszaru braków
+    // osobno, w oknie wokół niego, wartości i wagi próbek uśredniane są do coraz rzadszych siatek,
+    // a potem braki uzupełniane interpolacją z siatki rzadszej. Ramkę kafla stanowią przyległe wiersze
+    // i kolumny sąsiednich kafli (odczytywane z plików tylko dla kafli z brakami).
+    // Bez użycia OpenGL - wywoływane z decode, także w wątkach TileLoader.
+    static void fillHoles(Coordinates const& origin, Heights& heights, int samples, HoleFill& fill) {
+        auto start = std::chrono::high_resolution_clock::now();
+        fill = HoleFill();
+
+        // Większość kafli nie ma braków - sprawdzenie bez przepisywania do siatki. Kafel bez żadnych
+        // danych zostaje bez zmian (nie jest "wypełniany" z samych krawędzi sąsiadów).
+        if (std::find(heights.begin(), heights.end(), NO_DATA) == heights.end()
+         || std::all_of(heights.begin(), heights.end(), [](float h) { return h == NO_DATA; })) {
+            fill.ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            return;
+        }
 
-    void setShaders() {
-        v2d = glCreateShader(GL_VERTEX_SHADER);
-        v3d = glCreateShader(GL_VERTEX_SHADER);
-        f   = glCreateShader(GL_FRAGMENT_SHADER);
+        // Siatka z ramką jednej próbki, wierszami od południa
+        const int n = samples + 2;
+        std::vector<float> grid((size_t)n * n, NO_DATA);
 
-        getShaderSource(v2d, "shaders/tile.vs");
-        getShaderSource(v3d, "shaders/tile3d.vs");
-        getShaderSource(f,   "shaders/tile.fs");
+        int side   = std::min(samples, (int)BLOCK),
+            blocks = (samples - 1) / (side - 1);
 
-        GLint Result = GL_FALSE;
-        if ( Result = CompileLink(v2d, "VS-2D") ) {
-            if ( Result = CompileLink(v3d, "VS-3D") ) {
-                CompileLink(f, "FS");
+        for (int b = 0; b < blocks * blocks; b++) {
+            int bi = b / blocks, bj = b % blocks;
+            float const* src = &heights[(size_t)b * side * side];
+
+            for (int i = 0; i < side; i++) {
+                std::copy(src + (size_t)i * side, src + (size_t)(i + 1) * side,
+                          &grid[(size_t)(bi * (side - 1) + i + 1) * n + bj * (side - 1) + 1]);
             }
         }
-    }
 
-    void setBuffers() {
-        glGenBuffers(1, &EBO);
+        short lat = origin.latitude.getDegreesSigned(), lon = origin.longitude.getDegreesSigned();
+        std::vector<float> edge;
 
-        std::vector<unsigned int> ind;
-        unsigned int offset = 0;
+        if (readNeighbourEdge(lat - 1, lon, 0, samples, edge)) std::copy(edge.begin(), edge.end(), &grid[1]);
+        if (readNeighbourEdge(lat + 1, lon, 1, samples, edge)) std::copy(edge.begin(), edge.end(), &grid[(size_t)(n - 1) * n + 1]);
+        if (readNeighbourEdge(lat, lon - 1, 2, samples, edge)) for (int i = 0; i < samples; i++) grid[(size_t)(i + 1) * n] = edge[i];
+        if (readNeighbourEdge(lat, lon + 1, 3, samples, edge)) for (int i = 0; i < samples; i++) grid[(size_t)(i + 1) * n + n - 1] = edge[i];
 
-        for (int i = 1; i <= 9; i++) {
-            this->ind_offsets[i] = offset;
+        // Obszary braków (4-spójne) wewnątrz kafla
+        std::vector<uint8_t> visited((size_t)n * n, 0);
+        std::vector<size_t> stack;
 
-            for (int j = 0; j < this->indices[i].size(); j++) {
-                ind.push_back(this->indices[i][j]);
-            }
+        fill.mask.assign(heights.size(), 0);
 
-            offset += this->indices[i].size();
-        }
+        for (int i = 1; i <= samples; i++) {
+            for (int j = 1; j <= samples; j++) {
+                size_t seed = (size_t)i * n + j;
+                if (grid[seed] != NO_DATA || visited[seed]) continue;
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, ind.size() * sizeof(unsigned int), ind.data(), GL_DYNAMIC_DRAW);
-    }
+                int i0 = i, i1 = i, j0 = j, j1 = j;
+                std::vector<size_t> members;
 
-    // Funkcja ładowania kafli
-    std::string loadTile(Coordinates coords) {
-        std::string loaded = loadTileInternal(coords);
+                visited[seed] = 1;
+                stack.push_back(seed);
 
-        if (loaded == this->NOT_LOADED && coords.latitude.getMinutes() == 0 && coords.latitude.getSeconds() == 0) {
-            coords.latitude.offset(-1, 60, 0);
-            loaded = loadTileInternal(coords);
+                while (!stack.empty()) {
+                    size_t k = stack.back();
+                    stack.pop_back();
+                    members.push_back(k);
 
-            if (loaded == this->NOT_LOADED)
-                coords.latitude.offset(1, -60, 0);
-        }
+                    int ki = (int)(k / n), kj = (int)(k % n);
+                    i0 = std::min(i0, ki); i1 = std::max(i1, ki);
+                    j0 = std::min(j0, kj); j1 = std::max(j1, kj);
 
-        if (loaded == this->NOT_LOADED && coords.longitude.getMinutes() == 0 && coords.longitude.getSeconds() == 0) {
-            coords.longitude.offset(-1, 60, 0);
-            loaded = loadTileInternal(coords);
+                    for (size_t next : { k - n, k + n, k - 1, k + 1 }) {
+                        int ni = (int)(next / n), nj = (int)(next % n);
+                        if (ni < 1 || ni > samples || nj < 1 || nj > samples) continue;
+                        if (grid[next] != NO_DATA || visited[next]) continue;
 
-            if (loaded == this->NOT_LOADED)
-                coords.longitude.offset(1, -60, 0);
+                        visited[next] = 1;
+                        stack.push_back(next);
+                    }
+                }
+
+                // Okno z marginesem rosnącym z rozmiarem obszaru
+                int margin = std::max(8, std::max(i1 - i0, j1 - j0) + 1);
+                i0 = std::max(0, i0 - margin); i1 = std::min(n - 1, i1 + margin);
+                j0 = std::max(0, j0 - margin); j1 = std::min(n - 1, j1 + margin);
+
+                std::vector<float> values;
+                if (!pullPush(grid, n, i0, i1, j0, j1, values)) continue;
+
+                int w = j1 - j0 + 1;
+                for (size_t k : members) {
+                    int ki = (int)(k / n), kj = (int)(k % n);
+                    float h = std::round( values[(size_t)(ki - i0) * w + (kj - j0)] );
+
+                    // Próbki na wspólnych krawędziach bloków występują w kilku blokach
+                    forEachTexel(ki - 1, kj - 1, samples, [&](size_t t) {
+                        heights[t]   = h;
+                        fill.mask[t] = 1;
+                    });
+                    fill.filled++;
+                }
+            }
         }
 
-        if (loaded == this->NOT_LOADED && coords.latitude.getMinutes() == 0 && coords.latitude.getSeconds() == 0 && coords.longitude.getMinutes() == 0 && coords.longitude.getSeconds() == 0) {
-            coords.latitude .offset(-1, 60, 0);
-            coords.longitude.offset(-1, 60, 0);
-            loaded = loadTileInternal(coords);
+        if (fill.filled == 0) fill.mask.clear();
 
-            if (loaded == this->NOT_LOADED) {
-                coords.latitude .offset(1, -60, 0);
-                coords.longitude.offset(1, -60, 0);
+        fill.ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+    // Próbka (i, j) we wszystkich blokach, w których występuje (krawędzie bloków są wspólne)
+    template <class F>
+    static void forEachTexel(int i, int j, int samples, F f) {
+        int side   = std::min(samples, (int)BLOCK),
+            blocks = (samples - 1) / (side - 1);
+
+        for (int bi = std::max(0, (i - 1) / (side - 1)); bi <= std::min(blocks - 1, i / (side - 1)); bi++) {
+            for (int bj = std::max(0, (j - 1) / (side - 1)); bj <= std::min(blocks - 1, j / (side - 1)); bj++) {
+                f( ((size_t)(bi * blocks + bj) * side + (i - bi * (side - 1))) * side + (j - bj * (side - 1)) );
             }
         }
-
-        return loaded;
     }
-    void loadAllTiles() {
-        if (this->unbounded_lat || this->unbounded_lon) {
-            int toLoad = std::distance(std::filesystem::directory_iterator(Tile::path), std::filesystem::directory_iterator{});
-            int loaded = 0;
-
-            for (const auto & entry : std::filesystem::directory_iterator(Tile::path)) {
-                try {
-                    Coordinates orig = Tile::decodeTileNameString( entry.path().stem().string() );
-                    
-                    if (
-                        (this->unbounded_lat || (orig.latitude .getDegreesSigned() >= this->limit_sw.latitude .getDegreesSigned() 
-                                              && orig.latitude .getDegreesSigned() <  this->limit_ne.latitude .getDegreesSigned()))
-                     && (this->unbounded_lon || (orig.longitude.getDegreesSigned() >= this->limit_sw.longitude.getDegreesSigned() 
-                                              && orig.longitude.getDegreesSigned() <  this->limit_ne.longitude.getDegreesSigned()))
-                        ) 
-                    {
-                        this->loadTileInternal( orig );
-                        printf("Ładowanie....                    %d / %d\n", loaded++, toLoad);
-                    }
-                }
-                catch (const std::exception& e) {
-                    continue;
-                }
+    // Pull-push w oknie [i0, i1] x [j0, j1] siatki `grid` (bok n); values - wartości okna po wypełnieniu,
+    // false - brak jakichkolwiek danych w oknie
+    static bool pullPush(std::vector<float> const& grid, int n, int i0, int i1, int j0, int j1, std::vector<float>& values) {
+        struct Level {
+            int h, w;
+            std::vector<float> v, weight;
+        };
+        std::vector<Level> levels(1);
+
+        Level& base = levels[0];
+        base.h = i1 - i0 + 1;
+        base.w = j1 - j0 + 1;
+        base.v.resize((size_t)base.h * base.w);
+        base.weight.resize(base.v.size());
+
+        for (int i = 0; i < base.h; i++) {
+            for (int j = 0; j < base.w; j++) {
+                float g = grid[(size_t)(i0 + i) * n + j0 + j];
+                base.v     [(size_t)i * base.w + j] = g != NO_DATA ? g : 0.0f;
+                base.weight[(size_t)i * base.w + j] = g != NO_DATA ? 1.0f : 0.0f;
             }
-        } else {
-            int toLoad = (this->limit_ne.latitude.getDegrees() - this->limit_sw.latitude.getDegrees()) * (this->limit_ne.longitude.getDegrees() - this->limit_sw.longitude.getDegrees());
-            int loaded = 0;
+        }
 
-            for (short lat = this->limit_sw.latitude.getDegreesSigned(); lat < this->limit_ne.latitude.getDegreesSigned(); lat++) {
-                for (short lon = this->limit_sw.longitude.getDegreesSigned(); lon < this->limit_ne.longitude.getDegreesSigned(); lon++) {
-                    this->loadTileInternal( Coordinates( lat, lon ) );
+        // Pull - średnie ważone 2 x 2, aż do jednej próbki
+        while (levels.back().h > 1 || levels.back().w > 1) {
+            Level const& fine = levels.back();
+            Level coarse;
+            coarse.h = (fine.h + 1) / 2;
+            coarse.w = (fine.w + 1) / 2;
+            coarse.v.resize((size_t)coarse.h * coarse.w);
+            coarse.weight.resize(coarse.v.size());
+
+            for (int i = 0; i < coarse.h; i++) {
+                for (int j = 0; j < coarse.w; j++) {
+                    float sw = 0.0f, sv = 0.0f;
+
+                    for (int y = 2 * i; y <= std::min(2 * i + 1, fine.h - 1); y++) {
+                        for (int x = 2 * j; x <= std::min(2 * j + 1, fine.w - 1); x++) {
+                            float w = fine.weight[(size_t)y * fine.w + x];
+                            sw += w;
+                            sv += w * fine.v[(size_t)y * fine.w + x];
+                        }
+                    }
 
-                    printf("Ładowanie....                    %d / %d\n", loaded++, toLoad);
+                    coarse.v     [(size_t)i * coarse.w + j] = sw > 0.0f ? sv / sw : 0.0f;
+                    coarse.weight[(size_t)i * coarse.w + j] = std::min(1.0f, sw);
                 }
             }
+            levels.push_back(std::move(coarse));
         }
 
-        this->propagateXCondensation();
-    }
+        if (levels.back().weight[0] == 0.0f) return false;
 
-    // Funkcja ładowania koordynatów
-    short getHeight(Coordinates const& coords) {
-        std::string key = this->loadTile(coords);
+        // Push - braki uzupełniane dwuliniowo z rzadszej siatki
+        for (int k = (int)levels.size() - 2; k >= 0; k--) {
+            Level& fine = levels[k];
+            Level const& coarse = levels[k + 1];
 
-        return key != this->NOT_LOADED ? 
-            tiles[ key ]->getHeight(coords) :
-            Tile::NO_DATA;
-    }
-    uint64_t getTriangleCount() {
-        return (uint64_t)this->tilesRendered * this->indices[ this->user_lod ].size();
-    }
-    void draw(glm::mat4 const& view, glm::mat4 const& projection, glm::vec3 const& position, float drawDistance = 10000.0f) {
-        drawDistance *= 1.2f;
+            for (int i = 0; i < fine.h; i++) {
+                for (int j = 0; j < fine.w; j++) {
+                    size_t idx = (size_t)i * fine.w + j;
+                    if (fine.weight[idx] >= 1.0f) continue;
 
-        double radius = glm::length(position);
-        double posLon = position.x;
-        double posLat = position.y;
+                    float y = std::clamp((i - 0.5f) / 2.0f, 0.0f, coarse.h - 1.0f),
+                          x = std::clamp((j - 0.5f) / 2.0f, 0.0f, coarse.w - 1.0f);
+                    int y0 = (int)y, x0 = (int)x,
+                        y1 = std::min(y0 + 1, coarse.h - 1), x1 = std::min(x0 + 1, coarse.w - 1);
+                    float fy = y - y0, fx = x - x0;
 
-        glm::vec3 worldPos = this->transformToWorldPosition3D( position );
+                    float c = (coarse.v[(size_t)y0 * coarse.w + x0] * (1.0f - fx) + coarse.v[(size_t)y0 * coarse.w + x1] * fx) * (1.0f - fy)
+                            + (coarse.v[(size_t)y1 * coarse.w + x0] * (1.0f - fx) + coarse.v[(size_t)y1 * coarse.w + x1] * fx) * fy;
 
-        glm::vec2 targetCords;
-        Coordinates target;
+                    fine.v[idx] = fine.weight[idx] * fine.v[idx] + (1.0f - fine.weight[idx]) * c;
+                    fine.weight[idx] = 1.0f;
+                }
+            }
+        }
 
-        this->tilesRendered = 0;
+        values = std::move(levels[0].v);
+        return true;
+    }
+    // Wiersz lub kolumna kafla sąsiedniego przylegająca do krawędzi kafla (odległa o jedną próbkę
+    // kafla, w rozdzielczości `samples`): 0 - sąsiad od południa, 1 - od północy, 2 - od zachodu, 3 - od wschodu
+    static bool readNeighbourEdge(short lat, short lon, int side, int samples, std::vector<float>& edge) {
+        if (lat < -90 || lat > 89) return false;
+        if (lon < -180) lon += 360;
+        if (lon >  179) lon -= 360;
+
+        std::ifstream file(path + Coordinates(lat, lon).getTileString() + ".hgt", std::ios::binary | std::ios::ate);
+        if (!file) return false;
+
+        std::streamoff size = file.tellg();
+        int ns;
+
+        if      (size == (std::streamoff)1201 * 1201 * 2) ns = 1201;
+        else if (size == (std::streamoff)3601 * 3601 * 2) ns = 3601;
+        else return false;
+
+        // Rozdzielczość sąsiada może być inna - najbliższe próbki
+        double ratio = (ns - 1) / (double)(samples - 1);
+        int d = std::max(1, (int)std::lround(ratio));
+        int line = side == 0 || side == 2 ? ns - 1 - d : d;
+
+        auto value = [](unsigned char const* bytes) {
+            short value = static_cast<short>((bytes[0] << 8) | bytes[1]);
+            return (value < -500 || value > 9000) ? (float)NO_DATA : (float)value;
+        };
+
+        edge.resize(samples);
+
+        // Wiersz - jednym odczytem (wiersze w pliku od północy)
+        if (side < 2) {
+            std::vector<unsigned char> row((size_t)ns * 2);
+            file.seekg( (std::streamoff)(ns - 1 - line) * ns * 2 );
+            if (!file.read(reinterpret_cast<char*>(row.data()), row.size())) return false;
+
+            for (int t = 0; t < samples; t++) edge[t] = value( &row[(size_t)std::lround(t * ratio) * 2] );
+            return true;
+        }
 
-        for (int i = 0; i < this->loaded_keys.size(); i++) {
-            target = this->tiles[ this->loaded_keys[i] ]->origin;
+        // Kolumna - pasami po STRIP wierszy pliku, od dołu (południa) kafla
+        const int STRIP = 64;
+        std::vector<unsigned char> strip((size_t)STRIP * ns * 2);
+        int r0 = INT_MAX, r1 = INT_MAX;             // Wiersze pliku [r0, r1] w buforze
 
-            targetCords.x = glm::clamp( posLon, target.longitude.getDegreesSigned() + 0.0, target.longitude.getDegreesSigned() + 1.0 );
-            targetCords.y = glm::clamp( posLat, target.latitude .getDegreesSigned() + 0.0, target.latitude .getDegreesSigned() + 1.0 );
+        for (int t = 0; t < samples; t++) {
+            int r = ns - 1 - (int)std::lround(t * ratio);
 
-            if ((this->is3D && 
-                 glm::length( this->transformToWorldPosition3D(glm::vec3(targetCords, 0.0f)) - worldPos ) <= drawDistance )
-             || (!this->is3D &&
-                 glm::length( targetCords - glm::vec2(position.x, position.y) ) <= drawDistance )) 
-            {
-                this->tiles[ this->loaded_keys[i] ]->draw(view, projection, indices[ this->user_lod ].size(), this->ind_offsets[ this->user_lod ]);
-                this->tilesRendered++;
+            if (r < r0 || r > r1) {
+                r1 = r;
+                r0 = std::max(0, r - STRIP + 1);
+
+                file.seekg( (std::streamoff)r0 * ns * 2 );
+                if (!file.read(reinterpret_cast<char*>(strip.data()), (std::streamsize)(r1 - r0 + 1) * ns * 2)) return false;
             }
+            edge[t] = value( &strip[((size_t)(r - r0) * ns + line) * 2] );
         }
+
+        return true;
     }
-public:
-    float getXCondensation() const {
-        return glm::cos( this->getCenter().latitude.getDegrees() / 90.0f );
-    }
-    void setLod(unsigned short lod) {
-        if (lod < 1 || lod > 9) return;
-        if (lod == this->user_lod) return;
+    // Indeks próbki (wiersz od południa, kolumna) w tablicy wysokości kafla o `samples` próbkach
+    // na bok, zapisanej w układzie bloków zwracanym przez decode
+    static size_t texelIndex(int i, int j, int samples) {
+        if (samples <= BLOCK) return (size_t)i * samples + j;
+
+        int side   = std::min(samples, (int)BLOCK),
+            blocks = (samples - 1) / (side - 1);
+        int bi = std::min(i / (side - 1), blocks - 1),
+            bj = std::min(j / (side - 1), blocks - 1);
+
+        return ((size_t)(bi * blocks + bj) * side + (i - bi * (side - 1))) * side + (j - bj * (side - 1));
+    }
+    // Wersja bez wyjątków - dla nazw spoza schematu (np. innych plików w katalogu) zwraca false
+    static bool tryDecodeTileNameString(std::string const& tileName, short& lat, short& lon) {
+        if (tileName.length() != 7) return false;
+        if (tileName[0] != 'N' && tileName[0] != 'S') return false;
+        if (tileName[3] != 'E' && tileName[3] != 'W') return false;
+
+        for (int i : { 1, 2, 4, 5, 6 }) {
+            if (!std::isdigit( (unsigned char)tileName[i] )) return false;
+        }
+
+        lat = (tileName[1] - '0') * 10  + (tileName[2] - '0');
+        lon = (tileName[4] - '0') * 100 + (tileName[5] - '0') * 10 + (tileName[6] - '0');
+
+        if (lat > 90 || lon > 180) return false;
+
+        if (tileName[0] == 'S') lat = -lat;
+        if (tileName[3] == 'W') lon = -lon;
+
+        return true;
+    }
+    static Coordinates decodeTileNameString(std::string tileName) {
+        if (tileName.length() != 7) throw std::invalid_argument("Tile name must consist of exactly 7 characters: " + tileName);
+        
+        unsigned short deg_lat, deg_lon;
+        Hemisphere h_lat, h_lon;
+
+        if      (tileName[0] == 'N') h_lat = Hemisphere::North;
+        else if (tileName[0] == 'S') h_lat = Hemisphere::South;
+        else throw std::invalid_argument("Invalid hemisphere for latitude in tile name: " + tileName);
+        
+        if      (tileName[3] == 'E') h_lon = Hemisphere::East;
+        else if (tileName[3] == 'W') h_lon = Hemisphere::West;
+        else throw std::invalid_argument("Invalid hemisphere for longitude in tile name: " + tileName);
+
+        if ( !(std::isdigit(tileName[1]) && std::isdigit(tileName[2]) && std::isdigit(tileName[4]) && std::isdigit(tileName[5]) && std::isdigit(tileName[6])) )
+            throw std::invalid_argument("Invalid digits in tile name: " + tileName);
+        
+        deg_lat = (tileName[1] - '0') * 10  + (tileName[2] - '0');
+        deg_lon = (tileName[4] - '0') * 100 + (tileName[5] - '0') * 10 + (tileName[6] - '0');
+
+        return Coordinates(deg_lat, h_lat, deg_lon, h_lon);
+    }
+public:
+    const static short NO_DATA = -1000;
+    constexpr static int BLOCK = 1201;                                          // Próbek na bok bloku (kafla 3")
+    constexpr static size_t BLOCK_BYTES = (size_t)BLOCK * BLOCK * sizeof(float);
+    constexpr static int BRICK = 32;                                            // Próbek na bok cegiełki (zob. brick_layout)
+    static std::string path;
+    static bool brick_layout;
+    static float mesh_error;                                                    // Błąd siatki adaptacyjnej (m), 0 - siatka regularna
+    Coordinates origin;
+
+    unsigned int last_drawn_frame = 0;
+private:
+    // Wysokości w blokach 1201 x 1201 (wierszami od południa), kafel 1" to 3 x 3 bloki
+    // dzielące krawędzie - każdy blok rysowany jest tymi samymi indeksami co kafel 3".
+    // Z brick_layout w pamięci CPU cegiełki BRICK x BRICK (zob. brickIndex), blokami tylko na GPU.
+    Heights height_map;
+    bool bricked = false;
+    int bricks = 0;                         // Cegiełek na bok kafla
+    int samples = BLOCK, blocks = 1, side = BLOCK;
+    short span = 1;
+
+    // Sąsiedzi (3 x 3, wierszami od południa, środek - ten kafel), aktualizowani przy ładowaniu i usuwaniu kafli
+    Tile* neighbours[9] = { nullptr, nullptr, nullptr, nullptr, this, nullptr, nullptr, nullptr, nullptr };
+
+    GLuint v2d, v3d, f;
+    bool is3D = false;
+    
+    GLuint VBO, EBO;
+    float x_condensation = 1.0f;
+
+    OverlayKind overlay_kind = OverlayKind::None;
+    glm::vec4 overlay_bounds = glm::vec4(0.0f);
+
+    bool hillshade_enabled = true;
+    GLuint heightTexture = 0;
+
+    HoleFill hole_fill;
+    bool fill_mask_visible = false;
+    GLuint maskBuffer = 0, maskTexture = 0;
+
+    AdaptiveMesh mesh;
+    GLuint meshBuffer = 0;
+    bool mesh_dirty = true;
+
+    mutable HeightPyramid pyramid;
+    mutable std::once_flag pyramid_once;
+
+    bool uploaded = false;
+
+    // (cos lat, sin lat, cos lon, sin lon) narożnika kafla, liczone w podwójnej precyzji
+    glm::vec4 origin_trig = glm::vec4(0.0f);
+
+    GLuint lat_table = 0, lon_table = 0;
+    bool trig_tables_enabled = true;
+
+    void setSamples(int samples) {
+        this->samples = samples;
+        this->side    = std::min(samples, (int)BLOCK);
+        this->blocks  = (samples - 1) / (this->side - 1);
+    }
+    size_t texel(int i, int j) const {
+        return this->bricked ? brickIndex(i, j, this->bricks) : texelIndex(i, j, this->samples);
+    }
+    // Indeks próbki w układzie cegiełek: cegiełki wierszami od południa, próbki w cegiełce wierszami -
+    // sąsiednie wiersze i kolumny najczęściej w tych samych liniach pamięci podręcznej
+    static size_t brickIndex(int i, int j, int bricks) {
+        return ((size_t)(i / BRICK) * bricks + (j / BRICK)) * (BRICK * BRICK) + (i % BRICK) * BRICK + (j % BRICK);
+    }
+    void toBricks() {
+        int bricks = (this->samples + BRICK - 1) / BRICK;
+        Heights result((size_t)bricks * bricks * BRICK * BRICK, NO_DATA);
+
+        for (int i = 0; i < this->samples; i++) {
+            for (int j = 0; j < this->samples; j++) {
+                result[ brickIndex(i, j, bricks) ] = this->height_map[ texelIndex(i, j, this->samples) ];
+            }
+        }
+
+        this->height_map = std::move(result);
+        this->bricks  = bricks;
+        this->bricked = true;
+    }
+    Heights toBlocks() const {
+        Heights result( this->getGpuBytes() / sizeof(float) );
+
+        for (int i = 0; i < this->samples; i++) {
+            for (int j = 0; j < this->samples; j++) {
+                float h = this->height_map[ brickIndex(i, j, this->bricks) ];
+                forEachTexel(i, j, this->samples, [&result, h](size_t t) { result[t] = h; });
+            }
+        }
+        return result;
+    }
+    void setOrigin(Coordinates const& origin) {
+        this->origin = Coordinates( origin.latitude.getDegreesSigned(), origin.longitude.getDegreesSigned() );
+
+        double lat = glm::radians( (double)this->origin.latitude .getDegreesSigned() ),
+               lon = glm::radians( (double)this->origin.longitude.getDegreesSigned() );
+        this->origin_trig = glm::vec4( std::cos(lat), std::sin(lat), std::cos(lon), std::sin(lon) );
+    }
+};
+
+
+// ----------------------------------------
+//  
+//      PROFILE utilities
+//  
+// ----------------------------------------
+
+struct ProfileSample {
+    double distance;                // Odległość od początku łamanej w metrach
+    double longitude, latitude;
+    float  height;
+};
+
+// Stan strumieniowego wyznaczania profilu wysokości wzdłuż łamanej (zob. TileManager::getProfile).
+// Wierzchołki łamanej to (lon, lat) w stopniach, łączone ortodromami.
+struct ProfileCursor {
+    ProfileCursor(std::vector<glm::dvec2> const& polyline, double step) : polyline(polyline), step(step) {
+        if (step <= 0.0) throw std::invalid_argument("Profile step must be greater than 0.");
+    }
+
+    std::vector<glm::dvec2> polyline;
+    double step;
+
+    size_t segment = 0;             // Bieżący odcinek łamanej
+    double offset  = 0.0;           // Odległość następnej próbki od początku odcinka
+    double base    = 0.0;           // Odległość początku odcinka od początku łamanej
+    bool   finished = false;
+
+    // Odcinek w postaci wektorów jednostkowych (liczony raz na odcinek)
+    bool      segment_ready = false;
+    glm::dvec3 a, b;
+    double    angle = 0.0, length = 0.0;
+
+    // Ostatnio użyty kafel - wyszukiwany ponownie tylko po przekroczeniu jego granicy
+    Tile const* tile = nullptr;
+    int tile_lat = INT_MIN, tile_lon = INT_MIN;
+    unsigned int tile_lookups = 0;
+};
+
+
+// ----------------------------------------
+//  
+//      TILE INDEX class
+//  
+// ----------------------------------------
+
+struct TileIndexEntry {
+    short latitude, longitude;      // Narożnik południowo-zachodni
+    int64_t mtime;                  // Czas modyfikacji pliku
+    uintmax_t size;                 // Rozmiar pliku w bajtach
+};
+
+// Indeks dostępnych kafli w katalogu danych, zapisywany w pliku .tileindex w tym katalogu.
+// Jeśli czas modyfikacji katalogu (zmienia się przy dodaniu/usunięciu pliku) jest taki sam
+// jak zapisany, indeks jest wczytywany bez przeglądania katalogu. Nadpisanie pliku kafla nie
+// zmienia katalogu, więc wpisy wczytane z pliku są raz sprawdzane w open (validate: czas
+// modyfikacji i rozmiar pliku) - zmienione są poprawiane, usunięte znikają z indeksu, plik
+// indeksu zapisywany raz na końcu. find to samo wyszukiwanie, bez dostępu do plików.
+class TileIndex {
+public:
+    const static std::string FILE_NAME;
+public:
+    // rebuild - wymuś przeglądanie katalogu; zwraca true, jeśli indeks wczytano z pliku
+    bool open(std::string const& path, bool rebuild = false) {
+        this->entries.clear();
+        this->opened = false;
+        this->path = path;
+
+        std::error_code error;
+        int64_t dir_mtime = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+        if (error) return false;
+
+        this->opened = true;
+        this->dir_mtime = dir_mtime;
+        if (!rebuild && this->load(path, dir_mtime)) {
+            this->validate();
+            return true;
+        }
+
+        this->scan(path);
+
+        // Utworzenie pliku zmienia czas modyfikacji katalogu - zapisywany jest czas po jego utworzeniu
+        // (nadpisanie istniejącego pliku nie zmienia już katalogu)
+        this->save(path, dir_mtime);
+        dir_mtime = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+        if (!error) this->save(path, this->dir_mtime = dir_mtime);
+
+        return false;
+    }
+    bool isOpen() const {
+        return this->opened;
+    }
+    TileIndexEntry const* find(short lat, short lon) const {
+        auto it = this->entries.find( key(lat, lon) );
+        return it != this->entries.end() ? &it->second : nullptr;
+    }
+    // Porównanie wpisów z plikami kafli: zmieniony czas lub rozmiar są poprawiane, wpisy plików, których
+    // już nie ma, usuwane; plik indeksu zapisywany raz, jeśli coś się zmieniło. Zwraca liczbę zmian.
+    size_t validate() {
+        size_t changed = 0;
+
+        for (auto it = this->entries.begin(); it != this->entries.end(); ) {
+            TileIndexEntry& e = it->second;
+            std::error_code error;
+            std::filesystem::path file = std::filesystem::path(this->path) / (Coordinates(e.latitude, e.longitude).getTileString() + ".hgt");
+
+            int64_t mtime = std::filesystem::last_write_time(file, error).time_since_epoch().count();
+            uintmax_t size = error ? 0 : std::filesystem::file_size(file, error);
+
+            if (error) {
+                it = this->entries.erase(it);
+                changed++;
+                continue;
+            }
+            if (mtime != e.mtime || size != e.size) {
+                e.mtime = mtime;
+                e.size  = size;
+                changed++;
+            }
+            ++it;
+        }
+
+        if (changed > 0) this->save(this->path, this->dir_mtime);
+        return changed;
+    }
+    std::unordered_map<int, TileIndexEntry> const& getEntries() const {
+        return this->entries;
+    }
+    size_t size() const {
+        return this->entries.size();
+    }
+private:
+    std::unordered_map<int, TileIndexEntry> entries;
+    bool opened = false;
+    std::string path;
+    int64_t dir_mtime = 0;
+
+    static int key(short lat, short lon) {
+        return (lat + 90) * 361 + (lon + 180);
+    }
+
+    void scan(std::string const& path) {
+        std::error_code error;
+
+        for (auto const& entry : std::filesystem::directory_iterator(path, error)) {
+            if (entry.path().extension() != ".hgt") continue;
+
+            short lat, lon;
+            if (!Tile::tryDecodeTileNameString( entry.path().stem().string(), lat, lon )) continue;
+
+            TileIndexEntry e{ lat, lon, entry.last_write_time(error).time_since_epoch().count(), entry.file_size(error) };
+            if (error) continue;
+
+            this->entries[ key(lat, lon) ] = e;
+        }
+    }
+    bool load(std::string const& path, int64_t dir_mtime) {
+        std::ifstream file( std::filesystem::path(path) / FILE_NAME );
+        if (!file) return false;
+
+        std::string header;
+        int64_t saved_mtime;
+        size_t count;
+
+        if (!(file >> header >> saved_mtime >> count) || header != "tileindex1" || saved_mtime != dir_mtime) return false;
+
+        TileIndexEntry e;
+        for (size_t i = 0; i < count; i++) {
+            if (!(file >> e.latitude >> e.longitude >> e.mtime >> e.size)) {
+                this->entries.clear();
+                return false;
+            }
+            this->entries[ key(e.latitude, e.longitude) ] = e;
+        }
+
+        return true;
+    }
+    void save(std::string const& path, int64_t dir_mtime) const {
+        std::ofstream file( std::filesystem::path(path) / FILE_NAME, std::ios::trunc );
+        if (!file) return;
+
+        file << "tileindex1 " << dir_mtime << " " << this->entries.size() << "\n";
+        for (auto const& [k, e] : this->entries) {
+            file << e.latitude << " " << e.longitude << " " << e.mtime << " " << e.size << "\n";
+        }
+    }
+};
+
+
+// ----------------------------------------
+//  
+//      TILE LOADER class
+//  
+// ----------------------------------------
+
+struct TileRequest {
+    std::string key;
+    Coordinates origin;
+    float arrival;                  // Przewidywany czas wejścia w zasięg rysowania (s)
+    float mesh_error = -1.0f;       // Błąd siatki adaptacyjnej (m), < 0 - Tile::mesh_error (0 - bez siatki)
+    bool fill_holes = true;         // Wypełnianie braków danych (zob. Tile::fillHoles)
+};
+
+struct DecodedTile {
+    std::string key;
+    Coordinates origin;
+    Heights heights;
+    int samples = 0;                // 0 - błąd odczytu
+    HoleFill fill;
+    AdaptiveMesh mesh;              // Tylko z błędem siatki (zob. TileRequest::mesh_error)
+};
+
+// Pula wątków dekodujących pliki .hgt w tle. Kolejka żądań jest w całości zastępowana
+// przy każdym wywołaniu request(), co anuluje żądania nieaktualne po zmianie kierunku lotu.
+// Gotowe wysokości odbiera wątek OpenGL przez collect() i dopiero on tworzy kafle.
+// Te same wątki przebudowują siatki adaptacyjne wczytanych już kafli (requestMesh / collectMeshes),
+// po żądaniach wczytania kafli.
+class TileLoader {
+public:
+    TileLoader(unsigned int threads = std::max(1u, std::thread::hardware_concurrency() / 2)) {
+        for (unsigned int i = 0; i < threads; i++) {
+            this->workers.emplace_back(&TileLoader::work, this);
+        }
+    }
+    ~TileLoader() {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->stopping = true;
+        }
+        this->condition.notify_all();
+
+        for (auto& w : this->workers) w.join();
+    }
+public:
+    // requests - posortowane rosnąco wg czasu wejścia w zasięg
+    void request(std::vector<TileRequest> requests) {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        std::unordered_set<std::string> keys;
+        for (auto const& r : requests) keys.insert(r.key);
+
+        for (auto const& r : this->queue) {
+            if (keys.find(r.key) == keys.end()) this->cancelled++;
+        }
+
+        // Kolejka trzymana od końca - najpilniejsze żądanie zdejmowane przez pop_back()
+        this->queue.clear();
+        for (auto const& d : this->ready) keys.erase(d.key);
+
+        for (auto it = requests.rbegin(); it != requests.rend(); ++it) {
+            if (this->in_flight.find(it->key) == this->in_flight.end() && keys.find(it->key) != keys.end())
+                this->queue.push_back(std::move(*it));
+        }
+
+        this->condition.notify_all();
+    }
+    // wait - czekaj na co najmniej jeden kafel (tylko gdy jakieś żądanie jest w kolejce lub w toku)
+    std::vector<DecodedTile> collect(bool wait = false) {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        if (wait) this->done.wait(lock, [this]() { return !this->ready.empty() || (this->queue.empty() && this->in_flight.empty()); });
+
+        std::vector<DecodedTile> result;
+        result.swap(this->ready);
+        return result;
+    }
+    // Przejęcie kafla potrzebnego od razu: żądanie jeszcze w kolejce jest z niej usuwane (false - wczytuje
+    // wywołujący), na dekodowany właśnie kafel czeka do końca pracy wątku i zwraca go w out (true)
+    bool claim(std::string const& key, DecodedTile& out) {
+        std::unique_lock<std::mutex> lock(this->mutex);
+
+        this->queue.erase(std::remove_if(this->queue.begin(), this->queue.end(), [&key](TileRequest const& r) { return r.key == key; }), this->queue.end());
+        this->done.wait(lock, [this, &key]() { return this->in_flight.find(key) == this->in_flight.end(); });
+
+        auto it = std::find_if(this->ready.begin(), this->ready.end(), [&key](DecodedTile const& d) { return d.key == key; });
+        if (it == this->ready.end()) return false;
+
+        out = std::move(*it);
+        this->ready.erase(it);
+        return true;
+    }
+    unsigned int getCancelled() {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        return this->cancelled;
+    }
+    // Siatka adaptacyjna wczytanego kafla dla błędu `error` (zob. Tile::buildMesh); żądanie kafla,
+    // którego siatka jest już w kolejce lub w budowie, jest pomijane. Kafel musi istnieć do zakończenia
+    // budowy - przed usunięciem kafla wywoływane jest cancelMesh (zob. TileManager::evictTile).
+    void requestMesh(std::string const& key, Tile const* tile, float error) {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if (!this->mesh_pending.insert(key).second) return;
+
+            this->mesh_queue.push_back( MeshRequest{ key, tile, error } );
+        }
+        this->condition.notify_one();
+    }
+    // Usuwa żądanie siatki kafla z kolejki i gotowych wyników, na budowaną właśnie siatkę czeka
+    void cancelMesh(std::string const& key) {
+        std::unique_lock<std::mutex> lock(this->mutex);
+
+        auto queued = std::find_if(this->mesh_queue.begin(), this->mesh_queue.end(), [&key](MeshRequest const& r) { return r.key == key; });
+        if (queued != this->mesh_queue.end()) {
+            this->mesh_queue.erase(queued);
+            this->mesh_pending.erase(key);
+        }
+        this->done.wait(lock, [this, &key]() { return this->mesh_pending.find(key) == this->mesh_pending.end(); });
+
+        this->mesh_ready.erase(std::remove_if(this->mesh_ready.begin(), this->mesh_ready.end(), [&key](auto const& m) { return m.first == key; }), this->mesh_ready.end());
+    }
+    std::vector<std::pair<std::string, AdaptiveMesh>> collectMeshes() {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        std::vector<std::pair<std::string, AdaptiveMesh>> result;
+        result.swap(this->mesh_ready);
+        return result;
+    }
+private:
+    struct MeshRequest {
+        std::string key;
+        Tile const* tile;
+        float error;
+    };
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable condition, done;
+    bool stopping = false;
+
+    std::vector<TileRequest> queue;
+    std::unordered_set<std::string> in_flight;
+    std::vector<DecodedTile> ready;
+    unsigned int cancelled = 0;
+
+    std::deque<MeshRequest> mesh_queue;
+    std::unordered_set<std::string> mesh_pending;               // W kolejce lub w budowie
+    std::vector<std::pair<std::string, AdaptiveMesh>> mesh_ready;
+
+    void work() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+
+        while (true) {
+            this->condition.wait(lock, [this]() { return this->stopping || !this->queue.empty() || !this->mesh_queue.empty(); });
+            if (this->stopping) return;
+
+            if (this->queue.empty()) {
+                MeshRequest job = std::move(this->mesh_queue.front());
+                this->mesh_queue.pop_front();
+
+                lock.unlock();
+                AdaptiveMesh mesh = job.tile->buildMesh(job.error);
+                lock.lock();
+
+                this->mesh_pending.erase(job.key);
+                this->mesh_ready.emplace_back(job.key, std::move(mesh));
+                this->done.notify_all();
+                continue;
+            }
+
+            TileRequest request = std::move(this->queue.back());
+            this->queue.pop_back();
+            this->in_flight.insert(request.key);
+
+            lock.unlock();
+
+            DecodedTile decoded;
+            decoded.key    = request.key;
+            decoded.origin = request.origin;
+            try {
+                decoded.samples = Tile::decode(request.origin, decoded.heights, request.fill_holes, &decoded.fill);
+
+                float mesh_error = request.mesh_error >= 0.0f ? request.mesh_error : (Tile::mesh_error > 0.0f ? Tile::mesh_error : -1.0f);
+                if (mesh_error >= 0.0f) decoded.mesh = RtinBuilder::build(decoded.heights.data(), decoded.samples, mesh_error);
+            } catch (const std::exception& e) {
+                std::cerr << "Błąd wczytywania kafla (" + request.key + "): " + e.what() << "\n";
+                decoded.samples = 0;
+            }
+
+            lock.lock();
+
+            this->in_flight.erase(request.key);
+            this->ready.push_back(std::move(decoded));
+            this->done.notify_all();
+        }
+    }
+};
+
+
+// ----------------------------------------
+//  
+//      OVERVIEW PYRAMID class
+//  
+// ----------------------------------------
+
+// Węzeł piramidy: SAMPLES x SAMPLES wysokości (wierszami od południa) obszaru 2^poziom stopni,
+// kafel do rysowania tworzony jest przy pierwszym użyciu (zob. TileManager::drawOverview)
+struct OverviewNode {
+    short latitude, longitude;      // Narożnik południowo-zachodni
+    std::vector<short> heights;
+    std::unique_ptr<Tile> tile;
+};
+
+// Piramida przeglądowa do rysowania z daleka. Poziom 0 to kafle zmniejszone do 241 x 241 próbek
+// (uśrednianie), każdy kolejny poziom łączy 2 x 2 węzły poprzedniego w połowie rozdzielczości,
+// więc węzeł ma zawsze tyle samo próbek. Poziom 0 zapisywany jest w pliku .overview w katalogu
+// danych razem z rozmiarem i czasem modyfikacji pliku kafla - kolejne uruchomienia liczą tylko
+// kafle nowe lub zmienione. Obszar bez kafli ma wartość EMPTY i nie jest rysowany (tile.fs).
+class OverviewPyramid {
+public:
+    constexpr static int SAMPLES = 241;
+    constexpr static short EMPTY = SHRT_MIN;
+    constexpr static int MAX_LEVEL = 7;                 // Węzły do 128 x 128 stopni
+    const static std::string FILE_NAME;
+public:
+    // tiles - kafle do uwzględnienia (z indeksu), loaded(lat, lon) - wczytany kafel lub nullptr;
+    // brakujące w pliku kafle niewczytane są dekodowane równolegle (z wypełnianiem braków, gdy fill_holes)
+    template <class Lookup>
+    void build(std::string const& path, TileIndex const& index, std::vector<Coordinates> const& tiles, Lookup loaded, bool fill_holes = true) {
+        for (auto& level : this->levels) level.clear();
+        this->level_count = 1;
+        this->computed = 0;
+
+        std::unordered_map<int, std::vector<short>> cache;
+        this->load(path, index, cache);
+
+        std::vector<OverviewNode*> missing;
+        for (Coordinates const& origin : tiles) {
+            short lat = origin.latitude.getDegreesSigned(), lon = origin.longitude.getDegreesSigned();
+
+            OverviewNode& node = this->levels[0][ key(row(lat, 0), col(lon, 0)) ];
+            node.latitude  = lat;
+            node.longitude = lon;
+
+            auto it = cache.find( key(row(lat, 0), col(lon, 0)) );
+            if (it != cache.end()) {
+                node.heights = it->second;
+                continue;
+            }
+
+            Tile const* tile = loaded(lat, lon);
+            if (tile != nullptr) {
+                downsample(node.heights, tile->getSamples(), [tile](int i, int j) { return (float)tile->getHeight(i, j); });
+            } else {
+                missing.push_back(&node);
+            }
+            this->computed++;
+        }
+
+        // Kafle niewczytane (tryb strumieniowy) - odczyt tylko na potrzeby piramidy
+        unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<std::thread> workers;
+
+        for (unsigned int t = 0; t < threads; t++) {
+            workers.emplace_back([&missing, t, threads, fill_holes]() {
+                Heights heights;
+
+                for (size_t n = t; n < missing.size(); n += threads) {
+                    OverviewNode& node = *missing[n];
+                    try {
+                        int samples = Tile::decode( Coordinates(node.latitude, node.longitude), heights, fill_holes );
+                        downsample(node.heights, samples, [&heights, samples](int i, int j) { return heights[ Tile::texelIndex(i, j, samples) ]; });
+                    } catch (const std::exception& e) {
+                        std::cerr << "Błąd wczytywania kafla (" + Coordinates(node.latitude, node.longitude).getTileString() + "): " + e.what() << "\n";
+                        node.heights.assign(SAMPLES * SAMPLES, Tile::NO_DATA);
+                    }
+                }
+            });
+        }
+        for (auto& w : workers) w.join();
+
+        if (this->computed > 0) {
+            for (auto const& [k, node] : this->levels[0]) cache[k] = node.heights;
+            this->save(path, index, cache);
+        }
+
+        // Kolejne poziomy, aż cały obszar zmieści się w jednym węźle
+        for (int level = 1; level <= MAX_LEVEL && this->levels[level - 1].size() > 1; level++) {
+            this->level_count++;
+            auto const& children = this->levels[level - 1];
+
+            for (auto const& [k, child] : children) {
+                int r = row(child.latitude, level), c = col(child.longitude, level);
+
+                OverviewNode& node = this->levels[level][ key(r, c) ];
+                if (!node.heights.empty()) continue;
+
+                node.latitude  = -90  + (r << level);
+                node.longitude = -180 + (c << level);
+                this->merge(node, level);
+            }
+        }
+    }
+    int getLevels() const {
+        return this->level_count;
+    }
+    std::unordered_map<int, OverviewNode>& getLevel(int level) {
+        return this->levels[level];
+    }
+    // Liczba kafli przeliczonych przy ostatniej budowie (pozostałe wczytane z pliku)
+    unsigned int getComputed() const {
+        return this->computed;
+    }
+    size_t getBytes() const {
+        size_t bytes = 0;
+        for (int level = 0; level < this->level_count; level++) bytes += this->levels[level].size() * SAMPLES * SAMPLES * sizeof(short);
+
+        return bytes;
+    }
+    template <class F>
+    void forEachTile(F f) {
+        for (auto& level : this->levels) {
+            for (auto& [k, node] : level) {
+                if (node.tile) f(node.tile.get());
+            }
+        }
+    }
+public:
+    // Wiersz/kolumna węzła poziomu `level` zawierającego dany stopień (od -90 / -180)
+    static int row(int lat, int level) {
+        return (lat + 90) >> level;
+    }
+    static int col(int lon, int level) {
+        return (lon + 180) >> level;
+    }
+    static int key(int row, int col) {
+        return row * 512 + col;
+    }
+private:
+    std::unordered_map<int, OverviewNode> levels[MAX_LEVEL + 1];
+    int level_count = 0;
+    unsigned int computed = 0;
+
+    // Średnia z okna wokół co (samples - 1) / 240 próbki kafla, z pominięciem braków danych
+    template <class Get>
+    static void downsample(std::vector<short>& out, int samples, Get get) {
+        int step = (samples - 1) / (SAMPLES - 1), r = step / 2;
+        out.resize(SAMPLES * SAMPLES);
+
+        for (int i = 0; i < SAMPLES; i++) {
+            for (int j = 0; j < SAMPLES; j++) {
+                float sum = 0.0f;
+                int count = 0;
+
+                for (int y = std::max(i * step - r, 0); y <= std::min(i * step + r, samples - 1); y++) {
+                    for (int x = std::max(j * step - r, 0); x <= std::min(j * step + r, samples - 1); x++) {
+                        float h = get(y, x);
+                        if (h == Tile::NO_DATA) continue;
+
+                        sum += h;
+                        count++;
+                    }
+                }
+
+                out[i * SAMPLES + j] = count > 0 ? (short)std::lround(sum / count) : Tile::NO_DATA;
+            }
+        }
+    }
+    // Węzeł z 2 x 2 węzłów poprzedniego poziomu: siatka (2 * SAMPLES - 1)^2 z dzielonymi krawędziami,
+    // filtrowana [1 2 1] w obu kierunkach w co drugiej próbce
+    void merge(OverviewNode& node, int level) {
+        const int half = SAMPLES - 1, side = 2 * half + 1;
+        std::vector<short> grid((size_t)side * side, EMPTY);
+
+        int r0 = row(node.latitude, level - 1), c0 = col(node.longitude, level - 1);
+
+        for (int ci = 0; ci < 2; ci++) {
+            for (int cj = 0; cj < 2; cj++) {
+                auto it = this->levels[level - 1].find( key(r0 + ci, c0 + cj) );
+                if (it == this->levels[level - 1].end()) continue;
+
+                for (int i = 0; i < SAMPLES; i++) {
+                    std::copy_n( &it->second.heights[i * SAMPLES], SAMPLES, &grid[(size_t)(ci * half + i) * side + cj * half] );
+                }
+            }
+        }
+
+        const int weights[3] = { 1, 2, 1 };
+        node.heights.resize(SAMPLES * SAMPLES);
+
+        for (int i = 0; i < SAMPLES; i++) {
+            for (int j = 0; j < SAMPLES; j++) {
+                int sum = 0, weight = 0;
+                bool empty = true;
+
+                for (int dy = -1; dy <= 1; dy++) {
+                    int y = 2 * i + dy;
+                    if (y < 0 || y >= side) continue;
+
+                    for (int dx = -1; dx <= 1; dx++) {
+                        int x = 2 * j + dx;
+                        if (x < 0 || x >= side) continue;
+
+                        short h = grid[(size_t)y * side + x];
+                        if (h == EMPTY) continue;
+                        empty = false;
+                        if (h == Tile::NO_DATA) continue;
+
+                        int w = weights[dy + 1] * weights[dx + 1];
+                        sum += h * w;
+                        weight += w;
+                    }
+                }
+
+                node.heights[i * SAMPLES + j] = weight > 0 ? (short)std::lround((float)sum / weight) : (empty ? EMPTY : Tile::NO_DATA);
+            }
+        }
+    }
+    // Plik binarny: nagłówek, liczba rekordów, dla każdego kafla narożnik, czas modyfikacji i rozmiar
+    // pliku .hgt oraz SAMPLES^2 wysokości. Rekordy niezgodne z indeksem są pomijane.
+    void load(std::string const& path, TileIndex const& index, std::unordered_map<int, std::vector<short>>& cache) const {
+        std::ifstream file( std::filesystem::path(path) / FILE_NAME, std::ios::binary );
+        if (!file) return;
+
+        char header[9] = {};
+        uint32_t count = 0;
+        if (!file.read(header, 8) || std::string(header) != "overvw01" || !file.read(reinterpret_cast<char*>(&count), sizeof(count))) return;
+
+        std::vector<short> heights(SAMPLES * SAMPLES);
+
+        for (uint32_t n = 0; n < count; n++) {
+            TileIndexEntry e;
+            if (!file.read(reinterpret_cast<char*>(&e.latitude),  sizeof(e.latitude))
+             || !file.read(reinterpret_cast<char*>(&e.longitude), sizeof(e.longitude))
+             || !file.read(reinterpret_cast<char*>(&e.mtime),     sizeof(e.mtime))
+             || !file.read(reinterpret_cast<char*>(&e.size),      sizeof(e.size))
+             || !file.read(reinterpret_cast<char*>(heights.data()), heights.size() * sizeof(short))) return;
+
+            TileIndexEntry const* current = index.find(e.latitude, e.longitude);
+            if (current == nullptr || current->mtime != e.mtime || current->size != e.size) continue;
+
+            cache[ key(row(e.latitude, 0), col(e.longitude, 0)) ] = heights;
+        }
+    }
+    void save(std::string const& path, TileIndex const& index, std::unordered_map<int, std::vector<short>> const& cache) const {
+        std::ofstream file( std::filesystem::path(path) / FILE_NAME, std::ios::binary | std::ios::trunc );
+        if (!file) return;
+
+        std::vector<std::pair<TileIndexEntry const*, std::vector<short> const*>> records;
+        for (auto const& [k, heights] : cache) {
+            TileIndexEntry const* e = index.find( k / 512 - 90, k % 512 - 180 );
+            if (e != nullptr) records.emplace_back(e, &heights);
+        }
+
+        uint32_t count = records.size();
+        file.write("overvw01", 8);
+        file.write(reinterpret_cast<char const*>(&count), sizeof(count));
+
+        for (auto const& [e, heights] : records) {
+            file.write(reinterpret_cast<char const*>(&e->latitude),  sizeof(e->latitude));
+            file.write(reinterpret_cast<char const*>(&e->longitude), sizeof(e->longitude));
+            file.write(reinterpret_cast<char const*>(&e->mtime),     sizeof(e->mtime));
+            file.write(reinterpret_cast<char const*>(&e->size),      sizeof(e->size));
+            file.write(reinterpret_cast<char const*>(heights->data()), heights->size() * sizeof(short));
+        }
+    }
+};
+
+
+// ----------------------------------------
+//  
+//      TILE MANAGER class
+//  
+// ----------------------------------------
+
+class TileManager : public AGLDrawable {
+private:
+    std::unordered_map<std::string, std::unique_ptr<Tile>> tiles;
+    std::vector<std::string> loaded_keys;
+    TileIndex index;
+    
+    // Indeksy siatek regularnych LOD 1-9 tylko w buforze EBO (zob. uploadGridIndices)
+    unsigned int ind_offsets[10], ind_counts[10];
+    GridOrder grid_order = GridOrder::Strips;
+    unsigned int index_threads = std::max(1u, std::thread::hardware_concurrency());
+    float init_ms = 0.0f, index_ms = 0.0f;
+    unsigned short user_lod = 5;
+
+    // Piramida przeglądowa (tylko 2D) - rysowana zamiast kafli, gdy kafel zajmuje mniej niż
+    // overview_pixels pikseli wysokości ekranu
+    OverviewPyramid overview;
+    unsigned int overview_offset = 0, overview_count = 0;
+    bool overview_enabled = true;
+    float overview_pixels = 64.0f;
+    int overview_level = -1;
+
+    Coordinates limit_sw = Coordinates((short)0, 0),
+                limit_ne = Coordinates((short)0, 0);
+    bool  unbounded_lat = true,
+          unbounded_lon = true;
+    bool  limits_extended = false;
+    
+    GLuint v2d, v3d, f;
+    GLuint EBO = 0;
+    bool is3D = false;
+
+    unsigned int tilesRendered = 0;
+
+    // Nakładka (np. maska widoczności) rysowana w tile.fs
+    GLuint overlay_texture = 0;
+    OverlayKind overlay_kind = OverlayKind::None;
+    glm::vec4 overlay_bounds = glm::vec4(0.0f);
+
+    bool hillshade_enabled = true;
+
+    // Wypełnione braki danych: wypełnianie przy odczycie, podgląd maski i statystyki kafli z brakami
+    bool fill_holes = true;
+    bool fill_mask_visible = false;
+    unsigned int fill_tiles = 0, fill_samples = 0;
+    double fill_ms = 0.0;
+
+    // Siatki adaptacyjne (zob. Tile::mesh_error): część zasięgu rysowania z siatką, statystyki kafli z siatką
+    float mesh_range = 1.0f / 3.0f;
+    unsigned int mesh_tiles = 0;
+    uint64_t mesh_triangles = 0, mesh_grid_triangles = 0;
+    double mesh_ms = 0.0;
+
+    // Tablice różnic sin/cos dla kafli 3D, wspólne dla kafli o tej samej szerokości/długości
+    // i rozdzielczości (klucz: stopnie * 4 + liczba bloków na bok)
+    struct TrigTable {
+        GLuint buffer, texture;
+    };
+    std::unordered_map<int, TrigTable> lat_tables, lon_tables;
+    bool trig_tables_enabled = true;
+
+    // Tryb strumieniowy: kafle ładowane w miarę zbliżania się kamery (zob. update)
+    bool streaming = false, stream_started = false;
+    bool prefetch_enabled = true;
+    float prefetch_horizon = 3.0f;              // Horyzont przewidywania w sekundach
+    std::unordered_map<std::string, Coordinates> available_tiles;
+    std::unique_ptr<TileLoader> loader;
+    unsigned int load_stalls = 0, tiles_prefetched = 0;
+
+    // Wysyłanie wysokości na GPU: limit bajtów na klatkę i zwalnianie buforów kafli niewidocznych
+    // przez release_frames klatek
+    size_t upload_budget = 2 * Tile::BLOCK_BYTES;
+    unsigned int release_frames = 300;
+    unsigned int frame_index = 0;
+    unsigned int gpu_resident = 0, uploads_deferred = 0;
+    size_t gpu_resident_bytes = 0;
+    std::vector<Tile*> resident;                // Kafle i węzły piramidy z buforem na GPU
+    uint64_t triangles_rendered = 0;
+
+    // Wysyłanie przez trwale zmapowany bufor pośredni (gdy dostępne), pomiar przepustowości
+    std::unique_ptr<UploadRing> upload_ring;
+    bool upload_ring_enabled = true;
+    double upload_bytes = 0.0, upload_ms = 0.0;
+
+    
+    const static std::string NOT_LOADED;
+    const float earthRadius = 637800.0;
+public:
+    TileManager() {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        // Wierzchołki nie mają atrybutów położenia - shadery wyznaczają je z gl_VertexID
+        setShaders();
+        this->index_ms = this->uploadGridIndices();
+
+        this->upload_ring = std::make_unique<UploadRing>(Tile::BLOCK_BYTES, 4);
+        this->init_ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+    ~TileManager() {
+        // Tablice różnic sin/cos współdzielone przez kafle 3D (zob. getTrigTable)
+        for (auto* tables : { &this->lat_tables, &this->lon_tables }) {
+            for (auto& [key, table] : *tables) {
+                glDeleteTextures(1, &table.texture);
+                glDeleteBuffers(1, &table.buffer);
+            }
+            tables->clear();
+        }
+
+        // Indeksy siatek, shadery wspólne dla kafli (usuwane przez GL po usunięciu programów kafli)
+        // i tekstura nakładki
+        if (this->EBO != 0) glDeleteBuffers(1, &this->EBO);
+        glDeleteShader(this->v2d);
+        glDeleteShader(this->v3d);
+        glDeleteShader(this->f);
+        if (this->overlay_texture != 0) glDeleteTextures(1, &this->overlay_texture);
+    }
+
+    void setShaders() {
+        v2d = glCreateShader(GL_VERTEX_SHADER);
+        v3d = glCreateShader(GL_VERTEX_SHADER);
+        f   = glCreateShader(GL_FRAGMENT_SHADER);
+
+        getShaderSource(v2d, "shaders/tile.vs");
+        getShaderSource(v3d, "shaders/tile3d.vs");
+        getShaderSource(f,   "shaders/tile.fs");
+
+        GLint Result = GL_FALSE;
+        if ( Result = CompileLink(v2d, "VS-2D") ) {
+            if ( Result = CompileLink(v3d, "VS-3D") ) {
+                CompileLink(f, "FS");
+            }
+        }
+    }
+
+    // Indeksy siatek regularnych LOD 1-9 i węzła piramidy przeglądowej (pełna rozdzielczość) w kolejności
+    // grid_order, zapisywane wprost do zmapowanego bufora EBO - rozmiary znane z góry (GridIndices::getCount),
+    // bez kopii na CPU. Pasy (lub grupy wierszy) wszystkich LOD rozdzielane między wątki. Zwraca czas (ms).
+    float uploadGridIndices() {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        // Część: pas od kolumny b0, wiersze [row0, row1) siatki lod (0 - węzeł piramidy)
+        struct Part {
+            size_t offset;
+            int side, lod, band, b0, row0, row1;
+        };
+        std::vector<Part> parts;
+        size_t total = 0;
+
+        for (int lod = 0; lod <= 9; lod++) {
+            int side = lod == 0 ? OverviewPyramid::SAMPLES : Tile::BLOCK, step = std::max(lod, 1);
+            int quads = GridIndices::getQuads(side, step), band = GridIndices::getBand(side, step, this->grid_order);
+            int rows  = std::max(16384 / band, 1);      // Ok. 16 tys. czworokątów na część
+
+            for (int b0 = 0; b0 < quads; b0 += band) {
+                for (int row0 = 0; row0 < quads; row0 += rows) parts.push_back(Part{ total, side, step, band, b0, row0, std::min(row0 + rows, quads) });
+            }
+
+            unsigned int count = (unsigned int)GridIndices::getCount(side, step);
+            if (lod == 0) { this->overview_offset = (unsigned int)total; this->overview_count = count; }
+            else          { this->ind_offsets[lod]  = (unsigned int)total; this->ind_counts[lod]  = count; }
+            total += count;
+        }
+
+        if (EBO == 0) glGenBuffers(1, &EBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, total * sizeof(unsigned int), nullptr, GL_STATIC_DRAW);
+
+        // Bez mapowania - przez bufor na CPU (bez zerowania) i glBufferSubData
+        std::unique_ptr<unsigned int[]> staging;
+        unsigned int* out = (unsigned int*)glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, 0, total * sizeof(unsigned int), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (out == nullptr) {
+            staging.reset(new unsigned int[total]);
+            out = staging.get();
+        }
+
+        std::atomic<size_t> next{ 0 };
+        auto work = [&]() {
+            for (size_t k; (k = next++) < parts.size(); ) {
+                Part const& p = parts[k];
+                GridIndices::buildPart(out + p.offset, p.side, p.lod, p.band, p.b0, p.row0, p.row1);
+            }
+        };
+
+        unsigned int n = (unsigned int)std::min<size_t>(this->index_threads, parts.size());
+        std::vector<std::thread> workers;
+        for (unsigned int t = 1; t < n; t++) workers.emplace_back(work);
+        work();
+        for (auto& worker : workers) worker.join();
+
+        if (!staging) glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+        else glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, total * sizeof(unsigned int), staging.get());
+
+        return std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    // Funkcja ładowania kafli
+    std::string loadTile(Coordinates coords) {
+        std::string loaded = loadTileInternal(coords);
+
+        if (loaded == this->NOT_LOADED && coords.latitude.getMinutes() == 0 && coords.latitude.getSeconds() == 0) {
+            coords.latitude.offset(-1, 60, 0);
+            loaded = loadTileInternal(coords);
+
+            if (loaded == this->NOT_LOADED)
+                coords.latitude.offset(1, -60, 0);
+        }
+
+        if (loaded == this->NOT_LOADED && coords.longitude.getMinutes() == 0 && coords.longitude.getSeconds() == 0) {
+            coords.longitude.offset(-1, 60, 0);
+            loaded = loadTileInternal(coords);
+
+            if (loaded == this->NOT_LOADED)
+                coords.longitude.offset(1, -60, 0);
+        }
+
+        if (loaded == this->NOT_LOADED && coords.latitude.getMinutes() == 0 && coords.latitude.getSeconds() == 0 && coords.longitude.getMinutes() == 0 && coords.longitude.getSeconds() == 0) {
+            coords.latitude .offset(-1, 60, 0);
+            coords.longitude.offset(-1, 60, 0);
+            loaded = loadTileInternal(coords);
+
+            if (loaded == this->NOT_LOADED) {
+                coords.latitude .offset(1, -60, 0);
+                coords.longitude.offset(1, -60, 0);
+            }
+        }
+
+        return loaded;
+    }
+    // Kafle w granicach (setLimits) wyszukiwane w indeksie katalogu (zob. TileIndex), bez przeglądania
+    // katalogu i bez wczytywania; granice bez ograniczeń rozszerzane są do znalezionych kafli
+    std::vector<Coordinates> findTiles() {
+        std::vector<Coordinates> found;
+
+        if (this->unbounded_lat || this->unbounded_lon) {
+            for (auto const& [key, entry] : this->index.getEntries()) {
+                if (
+                    (this->unbounded_lat || (entry.latitude  >= this->limit_sw.latitude .getDegreesSigned() 
+                                          && entry.latitude  <  this->limit_ne.latitude .getDegreesSigned()))
+                 && (this->unbounded_lon || (entry.longitude >= this->limit_sw.longitude.getDegreesSigned() 
+                                          && entry.longitude <  this->limit_ne.longitude.getDegreesSigned()))
+                    ) 
+                {
+                    found.push_back( Coordinates( entry.latitude, entry.longitude ) );
+                }
+            }
+        } else {
+            for (short lat = this->limit_sw.latitude.getDegreesSigned(); lat < this->limit_ne.latitude.getDegreesSigned(); lat++) {
+                for (short lon = this->limit_sw.longitude.getDegreesSigned(); lon < this->limit_ne.longitude.getDegreesSigned(); lon++) {
+                    if (this->index.find(lat, lon) != nullptr) found.push_back( Coordinates( lat, lon ) );
+                }
+            }
+        }
+
+        for (Coordinates const& orig : found) this->extendLimits( orig );
+        return found;
+    }
+    void loadAllTiles() {
+        std::vector<Coordinates> found = this->findTiles();
+
+        if (this->streaming) {
+            for (Coordinates const& orig : found) {
+                this->available_tiles[ orig.getTileString() ] = orig;
+            }
+        } else {
+            // Odczyt i wypełnianie braków równolegle w puli TileLoader, kafle tworzone w tym wątku (OpenGL)
+            TileLoader pool( std::max(1u, std::thread::hardware_concurrency()) );
+            std::vector<TileRequest> requests;
+
+            for (Coordinates const& orig : found) {
+                if (this->tiles.find( orig.getTileString() ) == this->tiles.end())
+                    requests.push_back( TileRequest{ orig.getTileString(), orig, (float)requests.size(), -1.0f, this->fill_holes } );
+            }
+            pool.request(requests);
+
+            size_t loaded = 0;
+            while (loaded < requests.size()) {
+                for (auto& decoded : pool.collect(true)) {
+                    loaded++;
+                    if (decoded.samples == 0) continue;
+
+                    this->addTile( decoded.key, std::make_unique<Tile>(decoded.origin, std::move(decoded.heights), decoded.samples, v2d, v3d, f, EBO, std::move(decoded.fill), std::move(decoded.mesh)) );
+                    printf("Ładowanie....                    %zu / %zu\n", loaded, requests.size());
+                }
+            }
+        }
+
+        if (this->fill_tiles > 0)
+            printf("Wypełnianie braków danych:       %u kafli, %u próbek, %.2f ms/kafel\n", this->fill_tiles, this->fill_samples, this->fill_ms / this->fill_tiles);
+        if (this->mesh_tiles > 0)
+            printf("Siatki adaptacyjne (%.1f m):      %u kafli, %.1fx mniej trójkątów niż pełna siatka, %.2f ms/kafel\n", Tile::mesh_error, this->mesh_tiles, (double)this->mesh_grid_triangles / std::max<uint64_t>(this->mesh_triangles, 1), this->mesh_ms / this->mesh_tiles);
+
+        // Węzły poprzedniej piramidy nie mogą pozostać na liście buforów na GPU
+        this->overview.forEachTile([this](Tile* tile) {
+            if (tile->isUploaded()) {
+                this->gpu_resident--;
+                this->gpu_resident_bytes -= tile->getGpuBytes();
+                this->resident.erase( std::remove(this->resident.begin(), this->resident.end(), tile), this->resident.end() );
+            }
+        });
+
+        this->overview.build(Tile::path, this->index, found, [this](short lat, short lon) { return this->findTile(lat, lon); }, this->fill_holes);
+        printf("Piramida przeglądowa:            %d poziomów, %u kafli przeliczonych\n", this->overview.getLevels(), this->overview.getComputed());
+
+        HeightPoolStats pool = HeightPool::instance().getStats();
+        printf("Pula wysokości:                  %.1f MB w użyciu, szczyt %.1f MB, %.1f MB zarezerwowane\n", pool.in_use / 1048576.0, pool.peak / 1048576.0, pool.reserved / 1048576.0);
+
+        this->propagateXCondensation();
+    }
+    TileIndex const& getIndex() const {
+        return this->index;
+    }
+
+    // Funkcja ładowania koordynatów
+    short getHeight(Coordinates const& coords) {
+        std::string key = this->loadTile(coords);
+
+        return key != this->NOT_LOADED ? 
+            tiles[ key ]->getHeight(coords) :
+            Tile::NO_DATA;
+    }
+    // Strumieniowy profil wysokości: zapisuje do `capacity` próbek w `out` i zwraca ich liczbę,
+    // kolejne wywołania z tym samym kursorem kontynuują profil (0 - profil zakończony)
+    size_t getProfile(ProfileCursor& cursor, ProfileSample* out, size_t capacity) {
+        double radius = this->getEarthRadiusMeters();
+        size_t n = 0;
+
+        if (cursor.polyline.size() < 2) {
+            if (!cursor.finished && cursor.polyline.size() == 1 && capacity > 0) {
+                out[n++] = this->profileSample(cursor, 0.0, cursor.polyline[0].x, cursor.polyline[0].y);
+            }
+            cursor.finished = true;
+        }
+
+        while (n < capacity && !cursor.finished) {
+            if (!cursor.segment_ready) {
+                cursor.a = this->toUnitVector( cursor.polyline[cursor.segment] );
+                cursor.b = this->toUnitVector( cursor.polyline[cursor.segment + 1] );
+                cursor.angle  = std::atan2( glm::length(glm::cross(cursor.a, cursor.b)), glm::dot(cursor.a, cursor.b) );
+                cursor.length = cursor.angle * radius;
+                cursor.segment_ready = true;
+            }
+
+            if (cursor.offset < cursor.length) {
+                // Interpolacja sferyczna wzdłuż ortodromy
+                double t = cursor.offset / cursor.length;
+                double sa = std::sin( (1.0 - t) * cursor.angle ), sb = std::sin( t * cursor.angle ), s = std::sin( cursor.angle );
+                glm::dvec3 p = (cursor.a * sa + cursor.b * sb) / s;
+
+                out[n++] = this->profileSample(cursor, cursor.base + cursor.offset, 
+                    glm::degrees( std::atan2(p.z, p.x) ), glm::degrees( std::asin( glm::clamp(p.y, -1.0, 1.0) ) ));
+                cursor.offset += cursor.step;
+            }
+            else if (cursor.segment + 2 < cursor.polyline.size()) {
+                // Następny odcinek, z zachowaniem odstępu między próbkami
+                cursor.offset -= cursor.length;
+                cursor.base   += cursor.length;
+                cursor.segment++;
+                cursor.segment_ready = false;
+            }
+            else {
+                // Ostatni wierzchołek łamanej zawsze jest próbką
+                glm::dvec2 const& end = cursor.polyline.back();
+
+                out[n++] = this->profileSample(cursor, cursor.base + cursor.length, end.x, end.y);
+                cursor.finished = true;
+            }
+        }
+
+        return n;
+    }
+    unsigned int getTilesRendered() const {
+        return this->tilesRendered;
+    }
+    // Trójkąty narysowane w ostatnim wywołaniu draw (nie indeksy)
+    uint64_t getTriangleCount() {
+        return this->triangles_rendered;
+    }
+    // eye - pozycja kamery w świecie (3D), widok musi być wtedy liczony względem kamery
+    void draw(glm::mat4 const& view, glm::mat4 const& projection, glm::vec3 const& position, glm::dvec3 const& eye, float drawDistance = 10000.0f) {
+        drawDistance *= 1.2f;
+
+        Coordinates target;
+        size_t uploaded_bytes = 0;
+
+        this->tilesRendered = 0;
+        this->triangles_rendered = 0;
+        this->frame_index++;
+
+        // Siatki adaptacyjne przebudowane w tle od poprzedniej klatki (pominięte, jeśli próg błędu się zmienił)
+        if (this->loader) {
+            for (auto& [key, mesh] : this->loader->collectMeshes()) {
+                auto it = this->tiles.find(key);
+                if (it == this->tiles.end() || mesh.error != Tile::mesh_error) continue;
+
+                it->second->setMesh( std::move(mesh) );
+                if (!it->second->getMesh().indices.empty()) this->countMesh(it->second.get());
+            }
+        }
+
+        if (this->overlay_kind != OverlayKind::None) {
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, this->overlay_texture);
+        }
+
+        // Przy dużym oddaleniu (2D) węzły piramidy przeglądowej zamiast kafli - liczba rysowanych
+        // węzłów zależy tylko od rozmiaru widoku, nie od liczby kafli
+        this->overview_level = this->selectOverviewLevel(projection);
+
+        if (this->overview_level >= 0)
+            this->drawOverview(this->overview_level, view, projection, position, drawDistance, uploaded_bytes);
+
+        for (int i = 0; i < this->loaded_keys.size() && this->overview_level < 0; i++) {
+            Tile* tile = this->tiles[ this->loaded_keys[i] ].get();
+            target = tile->origin;
+
+            if (this->inDrawRange( target.latitude.getDegreesSigned(), target.longitude.getDegreesSigned(), position, drawDistance )) {
+                if (!this->prepareUpload(tile, uploaded_bytes)) continue;
+
+                glm::vec3 origin_offset = this->is3D ? 
+                    glm::vec3( this->toUnitVector( glm::dvec2(target.longitude.getDegreesSigned(), target.latitude.getDegreesSigned()) ) * (double)this->earthRadius - eye ) :
+                    glm::vec3( 0.0f );
+
+                // Siatka adaptacyjna zamiast LOD tylko w bliższej części zasięgu (mesh_range) - dalej siatka
+                // LOD ma mniej trójkątów niż siatka pełnej rozdzielczości z tym samym błędem. Siatka dla innego
+                // progu błędu (lub jej brak) przebudowywana jest w tle, do tego czasu rysowana jest dotychczasowa.
+                if (Tile::mesh_error > 0.0f && this->inDrawRange( target.latitude.getDegreesSigned(), target.longitude.getDegreesSigned(), position, drawDistance * this->mesh_range )) {
+                    if (tile->getMesh().error != Tile::mesh_error) this->getLoader().requestMesh(this->loaded_keys[i], tile, Tile::mesh_error);
+
+                    if (!tile->getMesh().indices.empty()) {
+                        tile->drawMesh(view, projection, origin_offset);
+                        this->tilesRendered++;
+                        this->triangles_rendered += tile->getMesh().getTriangles();
+                        continue;
+                    }
+                }
+
+                // Kafle 1" z pełną szczegółowością tylko w bliższej części zasięgu, dalej z krokiem
+                // dającym podobny rozstaw próbek jak kafle 3"
+                unsigned short lod = this->user_lod;
+                int blocks = (tile->getSamples() - 1) / (Tile::BLOCK - 1);
+
+                if (blocks > 1 && !this->inDrawRange( target.latitude.getDegreesSigned(), target.longitude.getDegreesSigned(), position, drawDistance / 3.0f ))
+                    lod = std::min(9, lod * blocks);
+
+                tile->draw(view, projection, this->ind_counts[lod], this->ind_offsets[lod], origin_offset);
+                this->tilesRendered++;
+                this->triangles_rendered += (uint64_t)this->ind_counts[lod] / 3 * blocks * blocks;
+            }
+        }
+
+        // Zwalnianie buforów kafli i węzłów niewidocznych przez release_frames klatek
+        for (size_t i = 0; i < this->resident.size(); ) {
+            Tile* tile = this->resident[i];
+
+            if (this->frame_index - tile->last_drawn_frame > this->release_frames) {
+                tile->release();
+                this->gpu_resident--;
+                this->gpu_resident_bytes -= tile->getGpuBytes();
+
+                this->resident[i] = this->resident.back();
+                this->resident.pop_back();
+            } else i++;
+        }
+    }
+public:
+    float getXCondensation() const {
+        return glm::cos( this->getCenter().latitude.getDegrees() / 90.0f );
+    }
+    void setLod(unsigned short lod) {
+        if (lod < 1 || lod > 9) return;
+        if (lod == this->user_lod) return;
 
         this->user_lod = lod;
     }
     unsigned short getLod() const {
         return this->user_lod;
     }
-    void setPath(std::string path) {
+    // Indeksy siatki regularnej jednego bloku dla LOD 1-9 (wierzchołki 1201 x 1201) - generowane
+    // przy każdym wywołaniu, na GPU są tylko w buforze EBO
+    std::vector<unsigned int> getGridIndices(unsigned short lod) const {
+        return GridIndices::build(Tile::BLOCK, lod, this->grid_order);
+    }
+    // Czas konstruktora i samego generowania indeksów (ms), zob. -bench startup
+    float getInitTimeMs() const {
+        return this->init_ms;
+    }
+    float getIndexTimeMs() const {
+        return this->index_ms;
+    }
+    void setIndexThreads(unsigned int n) {
+        this->index_threads = std::max(1u, n);
+    }
+    unsigned int getIndexThreads() const {
+        return this->index_threads;
+    }
+    // Kolejność trójkątów siatek regularnych - zmiana przelicza i wysyła bufor indeksów (zob. -bench vcache)
+    void setGridOrder(GridOrder order) {
+        if (order == this->grid_order) return;
+
+        this->grid_order = order;
+        this->uploadGridIndices();
+    }
+    GridOrder getGridOrder() const {
+        return this->grid_order;
+    }
+    // Promień Ziemi w metrach (scena 3D jest pomniejszona 10-krotnie, zob. tile3d.vs)
+    double getEarthRadiusMeters() const {
+        return this->earthRadius * 10.0;
+    }
+    // Kafel o danym narożniku południowo-zachodnim, jeśli jest załadowany
+    Tile* findTile(short lat, short lon) const {
+        if (lat < -90 || lat > 89) return nullptr;
+
+        auto it = this->tiles.find( Coordinates(lat, lon).getTileString() );
+
+        return it != this->tiles.end() ? it->second.get() : nullptr;
+    }
+    // Usunięcie załadowanego kafla: rozłączenie z sąsiadami, anulowanie budowy siatki w tle
+    // i zwolnienie buforów na GPU (false - kafel nie był załadowany)
+    bool evictTile(std::string const& key) {
+        auto it = this->tiles.find(key);
+        if (it == this->tiles.end()) return false;
+
+        Tile* tile = it->second.get();
+        if (this->loader) this->loader->cancelMesh(key);
+
+        tile->unlink();
+        if (tile->isUploaded()) {
+            this->gpu_resident--;
+            this->gpu_resident_bytes -= tile->getGpuBytes();
+            this->resident.erase( std::remove(this->resident.begin(), this->resident.end(), tile), this->resident.end() );
+        }
+
+        // it->first zamiast key - key może być elementem loaded_keys
+        this->loaded_keys.erase( std::remove(this->loaded_keys.begin(), this->loaded_keys.end(), it->first), this->loaded_keys.end() );
+        this->tiles.erase(it);
+        return true;
+    }
+    // Załadowane kafle w zasięgu rysowania (bez mnożnika z draw), w kolejności wczytania
+    std::vector<Tile*> getTilesInRange(glm::vec3 const& position, float drawDistance) {
+        std::vector<Tile*> found;
+
+        for (int i = 0; i < this->loaded_keys.size(); i++) {
+            Tile* tile = this->tiles[ this->loaded_keys[i] ].get();
+
+            if (this->inDrawRange( tile->origin.latitude.getDegreesSigned(), tile->origin.longitude.getDegreesSigned(), position, drawDistance ))
+                found.push_back(tile);
+        }
+        return found;
+    }
+    // Nakładka w formacie (lon, lat, szerokość, wysokość) w stopniach, wartości wierszami od południa;
+    // kind - sposób kolorowania w tile.fs
+    void setOverlay(std::vector<uint8_t> const& values, int cols, int rows, glm::vec4 const& bounds, OverlayKind kind = OverlayKind::Visibility) {
+        if (this->overlay_texture == 0) {
+            glGenTextures(1, &this->overlay_texture);
+            glBindTexture(GL_TEXTURE_2D, this->overlay_texture);
+
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+
+        glBindTexture(GL_TEXTURE_2D, this->overlay_texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, cols, rows, 0, GL_RED, GL_UNSIGNED_BYTE, values.data());
+
+        this->overlay_kind   = kind;
+        this->overlay_bounds = bounds;
+        this->propagateOverlay();
+    }
+    void clearOverlay() {
+        this->overlay_kind = OverlayKind::None;
+        this->propagateOverlay();
+    }
+    OverlayKind getOverlayKind() const {
+        return this->overlay_kind;
+    }
+    void setHillshade(bool enabled) {
+        if (this->hillshade_enabled == enabled) return;
+
+        this->hillshade_enabled = enabled;
+
+        for (int i = 0; i < this->loaded_keys.size(); i++) {
+            this->tiles[ this->loaded_keys[i] ]->setHillshade( this->hillshade_enabled );
+        }
+        this->overview.forEachTile([this](Tile* tile) { tile->setHillshade( this->hillshade_enabled ); });
+    }
+    bool getHillshade() const {
+        return this->hillshade_enabled;
+    }
+    // Wypełnianie braków danych przy odczycie kafli (zob. Tile::fillHoles) - przed loadAllTiles()
+    void setHoleFilling(bool enabled) {
+        this->fill_holes = enabled;
+    }
+    bool getHoleFilling() const {
+        return this->fill_holes;
+    }
+    // Siatki adaptacyjne kafli dla błędu pionowego `error` (m), zob. RtinBuilder; 0 - siatka regularna
+    // z LOD. Kafle wczytywane później dostają siatki w wątkach wczytujących, już załadowane są
+    // przeliczane tu równolegle.
+    void setMeshError(float error) {
+        error = std::max(error, 0.0f);
+        if (error == Tile::mesh_error) return;
+
+        Tile::mesh_error = error;
+        this->mesh_tiles = 0;
+        this->mesh_triangles = this->mesh_grid_triangles = 0;
+        this->mesh_ms = 0.0;
+
+        std::vector<Tile*> loaded;
+        for (auto const& key : this->loaded_keys) loaded.push_back(this->tiles[key].get());
+
+        std::atomic<size_t> next(0);
+        std::vector<std::thread> workers;
+        for (unsigned int w = 0; w < std::max(1u, std::thread::hardware_concurrency()); w++) {
+            workers.emplace_back([&]() {
+                for (size_t k; (k = next++) < loaded.size(); ) {
+                    loaded[k]->setMesh( error > 0.0f ? loaded[k]->buildMesh(error) : AdaptiveMesh() );
+                }
+            });
+        }
+        for (auto& w : workers) w.join();
+
+        for (Tile* tile : loaded) {
+            if (!tile->getMesh().indices.empty()) this->countMesh(tile);
+        }
+    }
+    float getMeshError() const {
+        return Tile::mesh_error;
+    }
+    // Część zasięgu rysowania (0-1), w której kafle rysowane są siatką adaptacyjną, dalej - siatką LOD
+    void  setMeshRange(float fraction) {
+        this->mesh_range = std::clamp(fraction, 0.0f, 1.0f);
+    }
+    float getMeshRange() const {
+        return this->mesh_range;
+    }
+    // Układ cegiełek w pamięci CPU dla kafli wczytywanych od tej chwili (zob. Tile::brick_layout)
+    void setBrickLayout(bool enabled) {
+        Tile::brick_layout = enabled;
+    }
+    // Duże strony dla pamięci wysokości kafli (zob. HeightPool)
+    void setHugePages(bool enabled) {
+        HeightPool::instance().setHugePages(enabled);
+    }
+    // Podgląd wypełnionych braków (zaznaczone w tile.fs)
+    void setFillMaskVisible(bool visible) {
+        this->fill_mask_visible = visible;
+
+        for (int i = 0; i < this->loaded_keys.size(); i++) {
+            this->tiles[ this->loaded_keys[i] ]->setFillMaskVisible( this->fill_mask_visible );
+        }
+    }
+    bool getFillMaskVisible() const {
+        return this->fill_mask_visible;
+    }
+    // Kafle z wypełnionymi brakami, wypełnione próbki i łączny czas wypełniania tych kafli
+    unsigned int getFilledTiles() const {
+        return this->fill_tiles;
+    }
+    unsigned int getFilledSamples() const {
+        return this->fill_samples;
+    }
+    double getFillMs() const {
+        return this->fill_ms;
+    }
+    // Piramida przeglądowa przy dużym oddaleniu w 2D (wyłączona - zawsze rysowane są kafle)
+    void setOverview(bool enabled) {
+        this->overview_enabled = enabled;
+    }
+    bool getOverview() const {
+        return this->overview_enabled;
+    }
+    // Poziom piramidy użyty w ostatniej klatce (węzły 2^poziom stopni) lub -1 - rysowane kafle
+    int getOverviewLevel() const {
+        return this->overview_level;
+    }
+    OverviewPyramid const& getOverviewPyramid() const {
+        return this->overview;
+    }
+    // Tablice sin/cos w tile3d.vs (wyłączone - funkcje trygonometryczne liczone dla każdego wierzchołka)
+    void setTrigTablesEnabled(bool enabled) {
+        this->trig_tables_enabled = enabled;
+
+        for (int i = 0; i < this->loaded_keys.size(); i++) {
+            this->tiles[ this->loaded_keys[i] ]->setTrigTablesEnabled( this->trig_tables_enabled );
+        }
+    }
+    // bytes - limit danych wysyłanych na GPU w jednej klatce, frames - po ilu klatkach niewidoczności
+    // kafel zwalnia bufor na karcie (wysokości zostają w pamięci)
+    void setUploadBudget(size_t bytes, unsigned int frames = 300) {
+        this->upload_budget  = bytes;
+        this->release_frames = frames;
+    }
+    size_t getUploadBudget() const {
+        return this->upload_budget;
+    }
+    unsigned int getReleaseFrames() const {
+        return this->release_frames;
+    }
+    unsigned int getGpuResidentTiles() const {
+        return this->gpu_resident;
+    }
+    size_t getGpuResidentBytes() const {
+        return this->gpu_resident_bytes;
+    }
+    unsigned int getLoadedTiles() const {
+        return this->loaded_keys.size();
+    }
+    unsigned int getUploadsDeferred() const {
+        return this->uploads_deferred;
+    }
+    void setUploadRing(bool enabled) {
+        this->upload_ring_enabled = enabled;
+    }
+    bool isUploadRingAvailable() const {
+        return this->upload_ring->isAvailable();
+    }
+    unsigned int getUploadRingWaits() const {
+        return this->upload_ring->getWaits();
+    }
+    // Przepustowość wysyłania wysokości (MB/s czasu CPU spędzonego na wywołaniach) od ostatniego resetu
+    double getUploadThroughput() const {
+        return this->upload_ms > 0.0 ? this->upload_bytes / 1048576.0 / (this->upload_ms / 1000.0) : 0.0;
+    }
+    void resetUploadStats() {
+        this->upload_bytes = 0.0;
+        this->upload_ms    = 0.0;
+    }
+    // Tryb strumieniowy - wywoływać przed loadAllTiles(), które wtedy tylko indeksuje dostępne kafle
+    void setStreaming(bool enabled) {
+        this->streaming = enabled;
+
+        if (this->streaming && !this->loader) this->loader = std::make_unique<TileLoader>();
+    }
+    bool isStreaming() const {
+        return this->streaming;
+    }
+    void setPrefetch(bool enabled, float horizon = 3.0f) {
+        this->prefetch_enabled = enabled;
+        this->prefetch_horizon = horizon;
+    }
+    // Aktualizacja kafli w trybie strumieniowym (raz na klatkę, przed draw).
+    // Kafle w zasięgu rysowania, których nie ma w pamięci, ładowane są od razu (przestój klatki) -
+    // dekodowany już w tle kafel jest przejmowany od TileLoader zamiast wczytywania drugi raz.
+    // Kafle, które przy bieżącej prędkości (stopnie/s) wejdą w zasięg w ciągu prefetch_horizon sekund,
+    // zlecane są do wczytania w tle w kolejności przewidywanego czasu wejścia.
+    void update(glm::vec3 const& position, glm::vec2 const& velocity, float drawDistance = 10000.0f) {
+        if (!this->streaming) return;
+
+        drawDistance *= 1.2f;
+
+        for (auto& decoded : this->loader->collect()) {
+            if (decoded.samples == 0 || this->tiles.find(decoded.key) != this->tiles.end()) continue;
+
+            this->addDecodedTile(decoded);
+            this->tiles_prefetched++;
+        }
+
+        const int steps = 12;
+        bool moving = glm::length(velocity) > 0.0f;
+        std::vector<TileRequest> requests;
+
+        for (auto const& [key, origin] : this->available_tiles) {
+            if (this->tiles.find(key) != this->tiles.end()) continue;
+
+            short lat = origin.latitude.getDegreesSigned(), lon = origin.longitude.getDegreesSigned();
+
+            if (this->inDrawRange(lat, lon, position, drawDistance)) {
+                // Pierwsze ładowanie wokół pozycji startowej nie jest liczone jako przestój
+                DecodedTile decoded;
+                if (this->loader->claim(key, decoded) && decoded.samples > 0) this->addDecodedTile(decoded);
+                else this->loadTileInternal(origin);
+                if (this->stream_started) this->load_stalls++;
+                continue;
+            }
+            if (!this->prefetch_enabled) continue;
+
+            bool requested = false;
+            for (int k = 1; moving && k <= steps; k++) {
+                float t = this->prefetch_horizon * k / steps;
+
+                if (this->inDrawRange(lat, lon, position + glm::vec3(velocity * t, 0.0f), drawDistance)) {
+                    requests.push_back( TileRequest{ key, origin, t, -1.0f, this->fill_holes } );
+                    requested = true;
+                    break;
+                }
+            }
+
+            // Pas wokół zasięgu z najniższym priorytetem - na ruszenie z miejsca i nagłe zmiany kierunku
+            if (!requested && this->inDrawRange(lat, lon, position, drawDistance * 1.25f))
+                requests.push_back( TileRequest{ key, origin, this->prefetch_horizon, -1.0f, this->fill_holes } );
+        }
+
+        std::sort(requests.begin(), requests.end(), [](TileRequest const& a, TileRequest const& b) { return a.arrival < b.arrival; });
+        this->loader->request( std::move(requests) );
+
+        this->stream_started = true;
+    }
+    void addDecodedTile(DecodedTile& decoded) {
+        this->addTile( decoded.key, std::make_unique<Tile>(decoded.origin, std::move(decoded.heights), decoded.samples, v2d, v3d, f, EBO, std::move(decoded.fill), std::move(decoded.mesh)) );
+    }
+    // Liczba kafli wczytanych synchronicznie w trakcie ruchu (przestojów klatki)
+    unsigned int getLoadStalls() const {
+        return this->load_stalls;
+    }
+    unsigned int getTilesPrefetched() const {
+        return this->tiles_prefetched;
+    }
+    unsigned int getPrefetchCancelled() {
+        return this->loader ? this->loader->getCancelled() : 0;
+    }
+    void setPath(std::string path, bool rebuildIndex = false) {
         Tile::path = path;
+
+        this->index.open(path, rebuildIndex);
     }
     void setLimits(Coordinates south_west, Coordinates north_east) {
         this->limit_sw = south_west;
@@ -653,6 +2714,9 @@ public:
             tiles[ loaded_keys[i] ]->set3DProjection( this->is3D );
         }
     }
+    bool get3DProjection() const {
+        return this->is3D;
+    }
     Coordinates getCenter() const {
         float lat = this->limit_sw.latitude .getDegreesSigned() + (this->limit_ne.latitude .getDegreesSigned() - this->limit_sw.latitude .getDegreesSigned()) / 2.0f,
               lon = this->limit_sw.longitude.getDegreesSigned() + (this->limit_ne.longitude.getDegreesSigned() - this->limit_sw.longitude.getDegreesSigned()) / 2.0f;
@@ -664,55 +2728,14 @@ private:
         std::string key = origin.getTileString();
 
         if (tiles.find(key) == tiles.end()) {
+            // Brak pliku w indeksie katalogu
+            short lat, lon;
+            if (this->index.isOpen() && !(Tile::tryDecodeTileNameString(key, lat, lon) && this->index.find(lat, lon) != nullptr))
+                return this->NOT_LOADED;
+
             // Kafel nie jest załadowany, ładowanie z pliku
             try {
-                auto tile = std::make_unique<Tile>(origin, vertices, v2d, v3d, f, EBO);
-                tiles[key] = std::move( tile );
-                
-                this->loaded_keys.push_back(key);
-
-                if (this->unbounded_lat || this->unbounded_lon) {
-                    // Pierwszy załadowany, ustaw wirtualne granice
-                    if (this->loaded_keys.size() == 1) {
-                        short min_lat = origin.latitude .getDegreesSigned(),
-                              min_lon = origin.longitude.getDegreesSigned(),
-                              max_lat = origin.latitude. getDegreesSigned() + 1,
-                              max_lon = origin.longitude.getDegreesSigned() + 1;
-
-                        if (!this->unbounded_lat) {
-                            min_lat = this->limit_sw.latitude .getDegreesSigned();
-                            max_lat = this->limit_ne.latitude .getDegreesSigned();
-                        }
-                        if (!this->unbounded_lon) {
-                            min_lon = this->limit_sw.longitude.getDegreesSigned();
-                            max_lon = this->limit_ne.longitude.getDegreesSigned();
-                        }
-
-                        this->limit_sw = Coordinates( min_lat, min_lon );
-                        this->limit_ne = Coordinates( max_lat, max_lon );
-                    }
-                    // Kolejny załadowany, zaktualizuj wirtualne granice
-                    else {
-                        short min_lat = std::min( this->limit_sw.latitude .getDegreesSigned(),         origin.latitude .getDegreesSigned()      ),
-                              min_lon = std::min( this->limit_sw.longitude.getDegreesSigned(),         origin.longitude.getDegreesSigned()      ),
-                              max_lat = std::max( this->limit_ne.latitude .getDegreesSigned(), (short)(origin.latitude .getDegreesSigned() + 1) ),
-                              max_lon = std::max( this->limit_ne.longitude.getDegreesSigned(), (short)(origin.longitude.getDegreesSigned() + 1) );
-
-                        if (!this->unbounded_lat) {
-                            min_lat = this->limit_sw.latitude .getDegreesSigned();
-                            max_lat = this->limit_ne.latitude .getDegreesSigned();
-                        }
-                        if (!this->unbounded_lon) {
-                            min_lon = this->limit_sw.longitude.getDegreesSigned();
-                            max_lon = this->limit_ne.longitude.getDegreesSigned();
-                        }
-
-                        this->limit_sw.latitude .setDegrees( min_lat );
-                        this->limit_sw.longitude.setDegrees( min_lon );
-                        this->limit_ne.latitude .setDegrees( max_lat );
-                        this->limit_ne.longitude.setDegrees( max_lon );
-                    }
-                }
+                this->addTile( key, std::make_unique<Tile>(origin, v2d, v3d, f, EBO, this->fill_holes) );
             } catch (const std::exception& e) {
                 std::cerr << "Błąd wczytywania kafla (" + key + "): " + e.what() << "\n";
                 
@@ -722,13 +2745,264 @@ private:
 
         return key;
     }
+    void addTile(std::string const& key, std::unique_ptr<Tile> tile) {
+        Coordinates origin = tile->origin;
+
+        // Podmiana kafla - destruktor starego rozłączyłby sąsiadów już połączonych z nowym
+        this->evictTile(key);
+
+        tile->setOverlay(this->overlay_kind, this->overlay_bounds);
+        tile->setHillshade(this->hillshade_enabled);
+        tile->setFillMaskVisible(this->fill_mask_visible);
+        tile->setTrigTables( this->getTrigTable(origin.latitude.getDegreesSigned(), true, tile->getSamples()), this->getTrigTable(origin.longitude.getDegreesSigned(), false, tile->getSamples()) );
+        tile->setTrigTablesEnabled(this->trig_tables_enabled);
+        tile->setXCondensation(this->getXCondensation());
+        tile->set3DProjection(this->is3D);
+        if (tile->getHoleFill().filled > 0) {
+            this->fill_tiles++;
+            this->fill_samples += tile->getHoleFill().filled;
+            this->fill_ms      += tile->getHoleFill().ms;
+        }
+        if (!tile->getMesh().indices.empty()) this->countMesh(tile.get());
+
+        // Połączenia z załadowanymi sąsiadami - odczyty przez krawędzie kafli bez wyszukiwania w mapie
+        short lat = origin.latitude.getDegreesSigned(), lon = origin.longitude.getDegreesSigned();
+        for (int di = -1; di <= 1; di++) {
+            for (int dj = -1; dj <= 1; dj++) {
+                if (di != 0 || dj != 0) tile->link(di, dj, this->findTile(lat + di, (lon + dj + 540) % 360 - 180));
+            }
+        }
+
+        tiles[key] = std::move( tile );
+        
+        this->loaded_keys.push_back(key);
+
+        this->extendLimits(origin);
+    }
+    // Pula wczytująca kafle w tle (tryb strumieniowy) i przebudowująca siatki adaptacyjne
+    TileLoader& getLoader() {
+        if (!this->loader) this->loader = std::make_unique<TileLoader>();
+        return *this->loader;
+    }
+    void countMesh(Tile const* tile) {
+        uint64_t cells = (uint64_t)(tile->getSamples() - 1) * (tile->getSamples() - 1);
+
+        this->mesh_tiles++;
+        this->mesh_triangles      += tile->getMesh().getTriangles();
+        this->mesh_grid_triangles += 2 * cells;
+        this->mesh_ms             += tile->getMesh().ms;
+    }
+    void extendLimits(Coordinates const& origin) {
+        if (!(this->unbounded_lat || this->unbounded_lon)) return;
+
+        // Pierwszy kafel, ustaw wirtualne granice
+        if (!this->limits_extended) {
+            short min_lat = origin.latitude .getDegreesSigned(),
+                  min_lon = origin.longitude.getDegreesSigned(),
+                  max_lat = origin.latitude. getDegreesSigned() + 1,
+                  max_lon = origin.longitude.getDegreesSigned() + 1;
+
+            if (!this->unbounded_lat) {
+                min_lat = this->limit_sw.latitude .getDegreesSigned();
+                max_lat = this->limit_ne.latitude .getDegreesSigned();
+            }
+            if (!this->unbounded_lon) {
+                min_lon = this->limit_sw.longitude.getDegreesSigned();
+                max_lon = this->limit_ne.longitude.getDegreesSigned();
+            }
+
+            this->limit_sw = Coordinates( min_lat, min_lon );
+            this->limit_ne = Coordinates( max_lat, max_lon );
+            this->limits_extended = true;
+        }
+        // Kolejny kafel, zaktualizuj wirtualne granice
+        else {
+            short min_lat = std::min( this->limit_sw.latitude .getDegreesSigned(),         origin.latitude .getDegreesSigned()      ),
+                  min_lon = std::min( this->limit_sw.longitude.getDegreesSigned(),         origin.longitude.getDegreesSigned()      ),
+                  max_lat = std::max( this->limit_ne.latitude .getDegreesSigned(), (short)(origin.latitude .getDegreesSigned() + 1) ),
+                  max_lon = std::max( this->limit_ne.longitude.getDegreesSigned(), (short)(origin.longitude.getDegreesSigned() + 1) );
+
+            if (!this->unbounded_lat) {
+                min_lat = this->limit_sw.latitude .getDegreesSigned();
+                max_lat = this->limit_ne.latitude .getDegreesSigned();
+            }
+            if (!this->unbounded_lon) {
+                min_lon = this->limit_sw.longitude.getDegreesSigned();
+                max_lon = this->limit_ne.longitude.getDegreesSigned();
+            }
+
+            this->limit_sw.latitude .setDegrees( min_lat );
+            this->limit_sw.longitude.setDegrees( min_lon );
+            this->limit_ne.latitude .setDegrees( max_lat );
+            this->limit_ne.longitude.setDegrees( max_lon );
+        }
+    }
+    // Wysłanie wysokości kafla na GPU przed rysowaniem; false - limit bajtów na klatkę wyczerpany,
+    // kafel czeka na kolejną klatkę (przynajmniej jeden na klatkę jest wysyłany)
+    bool prepareUpload(Tile* tile, size_t& uploaded_bytes) {
+        if (!tile->isUploaded()) {
+            if (uploaded_bytes > 0 && uploaded_bytes + tile->getGpuBytes() > this->upload_budget) {
+                this->uploads_deferred++;
+                return false;
+            }
+
+            auto start = std::chrono::high_resolution_clock::now();
+            tile->upload( this->upload_ring_enabled ? this->upload_ring.get() : nullptr );
+            this->upload_ms += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            this->upload_bytes += tile->getGpuBytes();
+
+            uploaded_bytes += tile->getGpuBytes();
+            this->gpu_resident++;
+            this->gpu_resident_bytes += tile->getGpuBytes();
+            this->resident.push_back(tile);
+        }
+        tile->last_drawn_frame = this->frame_index;
+
+        return true;
+    }
+    // Poziom piramidy przeglądowej dla bieżącego przybliżenia lub -1 (rysowanie kafli). Wybierany
+    // jest najrzadszy poziom, który ma jeszcze co najmniej jedną próbkę na piksel.
+    int selectOverviewLevel(glm::mat4 const& projection) const {
+        if (this->is3D || !this->overview_enabled || this->overview.getLevels() == 0) return -1;
+
+        GLint viewport[4] = { 0, 0, 0, 0 };
+        glGetIntegerv(GL_VIEWPORT, viewport);
+
+        // Rzutowanie ortogonalne - wysokość jednego stopnia w pikselach
+        float pixels = projection[1][1] * viewport[3] / 2.0f;
+        if (pixels <= 0.0f || pixels >= this->overview_pixels) return -1;
+
+        int level = (int)std::floor( std::log2( (OverviewPyramid::SAMPLES - 1) / pixels ) );
+
+        return std::clamp(level, 0, this->overview.getLevels() - 1);
+    }
+    // Węzły poziomu `level` w prostokącie otaczającym zasięg rysowania (bez przeglądania wszystkich węzłów)
+    void drawOverview(int level, glm::mat4 const& view, glm::mat4 const& projection, glm::vec3 const& position, float drawDistance, size_t& uploaded_bytes) {
+        auto& nodes = this->overview.getLevel(level);
+        short span = 1 << level;
+
+        int row_first = OverviewPyramid::row( std::max( (int)std::floor(position.y - drawDistance),  -90 ), level ),
+            row_last  = OverviewPyramid::row( std::min( (int)std::floor(position.y + drawDistance),   89 ), level ),
+            col_first = OverviewPyramid::col( std::max( (int)std::floor(position.x - drawDistance), -180 ), level ),
+            col_last  = OverviewPyramid::col( std::min( (int)std::floor(position.x + drawDistance),  179 ), level );
+
+        for (int r = row_first; r <= row_last; r++) {
+            for (int c = col_first; c <= col_last; c++) {
+                auto it = nodes.find( OverviewPyramid::key(r, c) );
+                if (it == nodes.end()) continue;
+
+                OverviewNode& node = it->second;
+                if (!this->inDrawRange(node.latitude, node.longitude, position, drawDistance, span)) continue;
+
+                if (!node.tile) {
+                    node.tile = std::make_unique<Tile>( Coordinates(node.latitude, node.longitude), Heights(node.heights.begin(), node.heights.end()), 
+                                                        OverviewPyramid::SAMPLES, v2d, v3d, f, EBO );
+                    node.tile->setSpan(span);
+                    node.tile->setOverlay(this->overlay_kind, this->overlay_bounds);
+                    node.tile->setHillshade(this->hillshade_enabled);
+                    node.tile->setXCondensation(this->getXCondensation());
+                }
+
+                if (!this->prepareUpload(node.tile.get(), uploaded_bytes)) continue;
+
+                node.tile->draw(view, projection, this->overview_count, this->overview_offset);
+                this->tilesRendered++;
+                this->triangles_rendered += this->overview_count / 3;
+            }
+        }
+    }
+    // Czy kafel (lub węzeł o boku `span` stopni) o danym narożniku jest w zasięgu rysowania z pozycji (lon, lat, wysokość)
+    bool inDrawRange(short lat, short lon, glm::vec3 const& position, float drawDistance, short span = 1) {
+        glm::vec2 targetCords(
+            glm::clamp( (double)position.x, lon + 0.0, lon + (double)span ),
+            glm::clamp( (double)position.y, lat + 0.0, lat + (double)span )
+        );
+
+        if (this->is3D)
+            return glm::length( this->transformToWorldPosition3D(glm::vec3(targetCords, 0.0f)) - this->transformToWorldPosition3D(position) ) <= drawDistance;
+
+        return glm::length( targetCords - glm::vec2(position.x, position.y) ) <= drawDistance;
+    }
+
+    // Bufor tekstury (RG32F) z różnicami (sin - sin narożnika, cos - cos narożnika) dla każdego
+    // z `samples` wierszy lub kolumn kafla o danym narożniku, liczonymi w podwójnej precyzji.
+    // Dzięki temu tile3d.vs wyznacza pozycję wyłącznie mnożeniami i dodawaniami.
+    GLuint getTrigTable(short degrees, bool latitude, int samples) {
+        auto& tables = latitude ? this->lat_tables : this->lon_tables;
+        int key = degrees * 4 + (samples - 1) / (Tile::BLOCK - 1);
+
+        auto it = tables.find(key);
+        if (it != tables.end()) return it->second.texture;
+
+        std::vector<float> values(samples * 2);
+        double angle0 = glm::radians( (double)degrees );
+
+        for (int i = 0; i < samples; i++) {
+            double angle = glm::radians( degrees + i / (double)(samples - 1) );
+
+            values[2 * i]     = std::sin(angle) - std::sin(angle0);
+            values[2 * i + 1] = std::cos(angle) - std::cos(angle0);
+        }
+
+        TrigTable table;
+        glGenBuffers(1, &table.buffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, table.buffer);
+        glBufferData(GL_TEXTURE_BUFFER, values.size() * sizeof(float), values.data(), GL_STATIC_DRAW);
+
+        glGenTextures(1, &table.texture);
+        glBindTexture(GL_TEXTURE_BUFFER, table.texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32F, table.buffer);
+
+        tables[key] = table;
+        return table.texture;
+    }
+    glm::dvec3 toUnitVector( glm::dvec2 const& lonLat ) const {
+        double latitude  = glm::radians(lonLat.y);
+        double longitude = glm::radians(lonLat.x);
+
+        return glm::dvec3(
+            cos(latitude) * cos(longitude),
+            sin(latitude),
+            cos(latitude) * sin(longitude)
+        );
+    }
+    ProfileSample profileSample(ProfileCursor& cursor, double distance, double lon, double lat) {
+        int lat_deg = (int)std::floor(lat), 
+            lon_deg = (int)std::floor(lon);
+
+        if (lat_deg != cursor.tile_lat || lon_deg != cursor.tile_lon) {
+            int di = lat_deg - cursor.tile_lat, dj = lon_deg - cursor.tile_lon;
+
+            // Przejście do sąsiedniego kafla po połączeniu, wyszukanie w mapie tylko po przerwie w danych
+            if (cursor.tile != nullptr && std::abs(di) <= 1 && std::abs(dj) <= 1) {
+                cursor.tile = cursor.tile->getNeighbour(di, dj);
+            } else {
+                cursor.tile = this->findTile(lat_deg, lon_deg);
+                cursor.tile_lookups++;
+            }
+            cursor.tile_lat = lat_deg;
+            cursor.tile_lon = lon_deg;
+        }
+
+        float height = cursor.tile != nullptr ?
+            cursor.tile->getHeightInterpolated( lat - lat_deg, lon - lon_deg ) :
+            Tile::NO_DATA;
 
+        return ProfileSample{ distance, lon, lat, height };
+    }
+    void propagateOverlay() {
+        for (int i = 0; i < this->loaded_keys.size(); i++) {
+            this->tiles[ this->loaded_keys[i] ]->setOverlay( this->overlay_kind, this->overlay_bounds );
+        }
+        this->overview.forEachTile([this](Tile* tile) { tile->setOverlay( this->overlay_kind, this->overlay_bounds ); });
+    }
     void propagateXCondensation() {
         float x_cond = this->getXCondensation();
 
         for (int i = 0; i < this->loaded_keys.size(); i++) {
             this->tiles[ this->loaded_keys[i] ]->setXCondensation( x_cond );
         }
+        this->overview.forEachTile([x_cond](Tile* tile) { tile->setXCondensation( x_cond ); });
     }
     glm::vec3 transformToWorldPosition3D( glm::vec3 const& pos ) {
         double latitude  = glm::radians(pos.y);
@@ -743,4 +3017,8 @@ private:
 };
 
 std::string Tile::path = "./data/";
+bool Tile::brick_layout = false;
+float Tile::mesh_error = 0.0f;
+const std::string TileIndex::FILE_NAME = ".tileindex";
+const std::string OverviewPyramid::FILE_NAME = ".overview";
 const std::string TileManager::NOT_LOADED = "tile_not_loaded";
\ No newline at end of file
@@ -0,0 +1,756 @@
+// ==========================================================================
+// TileServer: class definitions
+//
+// Michał Chawar
+// ==========================================================================
+// TileKey
+// TileCache
+// TileServerStats
+// TileServer
+// HttpClient
+//===========================================================================
+
+#pragma once
+
+// Gniazda POSIX - serwer niedostępny na Windows (MSYS2)
+#if !defined(_WIN32)
+
+#include <string>
+#include <vector>
+#include <list>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <memory>
+#include <functional>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <cmath>
+
+#include <sys/socket.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#include <TileManager.hpp>
+#include <MapRenderer.hpp>
+
+
+// ----------------------------------------
+//
+//      TILE KEY utilities
+//
+// ----------------------------------------
+
+// Kafel XYZ (Web Mercator, y od północy) - z, x, y oraz rodzaj (wysokości / mapa)
+struct TileKey {
+    constexpr static int MAX_ZOOM = 15;
+    constexpr static int SIZE     = 256;
+
+    enum Kind : uint8_t { Terrain, Map };
+
+    Kind kind;
+    int z, x, y;
+
+    bool operator==(TileKey const& other) const {
+        return this->kind == other.kind && this->z == other.z && this->x == other.x && this->y == other.y;
+    }
+    bool isValid() const {
+        return this->z >= 0 && this->z <= MAX_ZOOM && this->x >= 0 && this->y >= 0 && this->x < (1 << this->z) && this->y < (1 << this->z);
+    }
+    // Długość geograficzna krawędzi kafla (x w jednostkach kafli poziomu z)
+    static double longitude(double x, int z) {
+        return x / (1 << z) * 360.0 - 180.0;
+    }
+    // Szerokość geograficzna krawędzi kafla (y w jednostkach kafli poziomu z)
+    static double latitude(double y, int z) {
+        return glm::degrees( std::atan( std::sinh( M_PI * (1.0 - 2.0 * y / (1 << z)) ) ) );
+    }
+    // Odwrotność latitude: y (w jednostkach kafli poziomu z) dla szerokości lat
+    static double row(double lat, int z) {
+        return (1.0 - std::asinh( std::tan(glm::radians(lat)) ) / M_PI) / 2.0 * (1 << z);
+    }
+};
+
+struct TileKeyHash {
+    size_t operator()(TileKey const& key) const {
+        return ((size_t)key.kind << 62) ^ ((size_t)key.z << 56) ^ ((size_t)key.x << 28) ^ (size_t)key.y;
+    }
+};
+
+
+// ----------------------------------------
+//
+//      TILE CACHE class
+//
+// ----------------------------------------
+
+// Gotowa odpowiedź (PNG), nullptr - brak danych dla kafla
+using TileBody = std::shared_ptr<const std::string>;
+
+// Pamięć podręczna LRU gotowych kafli ograniczona liczbą bajtów. Równoczesne żądania tego
+// samego kafla są łączone - liczy go tylko pierwszy wątek, pozostałe czekają na jego wynik.
+class TileCache {
+public:
+    // Koszt wpisu bez danych (pusty kafel też jest zapamiętywany)
+    constexpr static size_t EMPTY_COST = 64;
+
+    TileCache(size_t capacity) : capacity(capacity) {}
+public:
+    TileBody get(TileKey const& key, std::function<TileBody()> const& compute) {
+        std::shared_future<TileBody> pending;
+        std::promise<TileBody> promise;
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->requests++;
+
+            auto it = this->entries.find(key);
+            if (it != this->entries.end()) {
+                this->lru.splice(this->lru.begin(), this->lru, it->second);
+                this->hits++;
+                return it->second->body;
+            }
+
+            auto flight = this->in_flight.find(key);
+            if (flight != this->in_flight.end()) {
+                pending = flight->second;
+                this->coalesced++;
+            } else {
+                this->in_flight.emplace(key, promise.get_future().share());
+                this->computed++;
+            }
+        }
+
+        if (pending.valid()) return pending.get();
+
+        TileBody body;
+        try {
+            body = compute();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            promise.set_exception(std::current_exception());
+            this->in_flight.erase(key);
+            throw;
+        }
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->insert(key, body);
+        promise.set_value(body);
+        this->in_flight.erase(key);
+
+        return body;
+    }
+    void clear() {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->lru.clear();
+        this->entries.clear();
+        this->bytes = 0;
+    }
+    void setCapacity(size_t capacity) {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->capacity = capacity;
+        this->evict();
+    }
+    void resetStats() {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->requests = this->hits = this->coalesced = this->computed = 0;
+    }
+    // Żądania, trafienia, połączone z liczonym już kaflem, policzone
+    void getStats(size_t& requests, size_t& hits, size_t& coalesced, size_t& computed, size_t& bytes) {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        requests  = this->requests;
+        hits      = this->hits;
+        coalesced = this->coalesced;
+        computed  = this->computed;
+        bytes     = this->bytes;
+    }
+private:
+    struct Entry {
+        TileKey key;
+        TileBody body;
+        size_t cost;
+    };
+
+    std::mutex mutex;
+    std::list<Entry> lru;
+    std::unordered_map<TileKey, std::list<Entry>::iterator, TileKeyHash> entries;
+    std::unordered_map<TileKey, std::shared_future<TileBody>, TileKeyHash> in_flight;
+
+    size_t capacity, bytes = 0;
+    size_t requests = 0, hits = 0, coalesced = 0, computed = 0;
+
+    void insert(TileKey const& key, TileBody const& body) {
+        size_t cost = body ? body->size() : EMPTY_COST;
+        if (cost > this->capacity) return;
+
+        this->lru.push_front( Entry{ key, body, cost } );
+        this->entries[key] = this->lru.begin();
+        this->bytes += cost;
+        this->evict();
+    }
+    void evict() {
+        while (this->bytes > this->capacity && !this->lru.empty()) {
+            this->bytes -= this->lru.back().cost;
+            this->entries.erase(this->lru.back().key);
+            this->lru.pop_back();
+        }
+    }
+};
+
+
+// ----------------------------------------
+//
+//      TILE SERVER class
+//
+// ----------------------------------------
+
+struct TileServerStats {
+    size_t requests = 0, hits = 0, coalesced = 0, computed = 0;
+    size_t cache_bytes = 0;
+    size_t errors = 0;                      // Odpowiedzi 4xx / 5xx
+};
+
+// Lokalny serwer HTTP/1.1 (127.0.0.1) z kaflami XYZ 256 x 256 z załadowanego TileManager:
+//   /terrain/{z}/{x}/{y}.png - wysokości w kodowaniu Terrarium (h + 32768 = R * 256 + G + B / 256),
+//                              liczone na CPU w wątkach puli z próbek kafli (interpolacja dwuliniowa)
+//   /map/{z}/{x}/{y}.png     - mapa 2D rysowana przez MapRenderer (wiersze przeliczane na Web Mercator);
+//                              OpenGL działa tylko w wątku kontekstu, więc rysowanie trafia do kolejki
+//                              obsługiwanej przez pump()
+//   /stats                   - liczniki żądań i pamięci podręcznej
+// Bezczynne połączenia keep-alive czeka na kolejne żądanie wątek nasłuchujący (poll), wątek puli
+// dostaje połączenie tylko na czas obsługi żądań, które już nadeszły - klientów może być więcej
+// niż wątków; także żądanie nadchodzące w częściach jest kompletowane w acceptLoop. Połączenie
+// bezczynne dłużej niż IDLE_TIMEOUT jest zamykane. Kafle TileManager
+// nie mogą być w tym czasie wczytywane ani usuwane (bez trybu strumieniowego).
+class TileServer {
+public:
+    constexpr static std::chrono::seconds IDLE_TIMEOUT{ 5 };
+    constexpr static int MAP_OVERSAMPLE = 2;        // Wierszy obrazu równoodległościowego na wiersz kafla mapy (zob. mapTile)
+
+    TileServer(TileManager& tileManager, MapRenderer& renderer, size_t cache_bytes = 256 << 20, unsigned int threads = 0)
+        : tileManager(tileManager), renderer(renderer), cache(cache_bytes) {
+        if (threads == 0) threads = std::max(4u, std::thread::hardware_concurrency());
+        this->thread_count = threads;
+    }
+    ~TileServer() {
+        this->stop();
+    }
+public:
+    // port = 0 - dowolny wolny port (zob. getPort)
+    void start(int port) {
+        this->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (this->listen_fd < 0) throw std::runtime_error("Nie można utworzyć gniazda serwera.");
+
+        int yes = 1;
+        setsockopt(this->listen_fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+        sockaddr_in address{};
+        address.sin_family      = AF_INET;
+        address.sin_port        = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        if (bind(this->listen_fd, (sockaddr*)&address, sizeof(address)) < 0 || listen(this->listen_fd, 128) < 0 || pipe(this->wake_fds) < 0) {
+            close(this->listen_fd);
+            this->listen_fd = -1;
+            throw std::runtime_error("Nie można nasłuchiwać na porcie " + std::to_string(port));
+        }
+
+        socklen_t length = sizeof(address);
+        getsockname(this->listen_fd, (sockaddr*)&address, &length);
+        this->port = ntohs(address.sin_port);
+
+        this->running = true;
+        this->listener = std::thread([this]() { this->acceptLoop(); });
+        for (unsigned int k = 0; k < this->thread_count; k++) {
+            this->workers.emplace_back([this]() { this->workLoop(); });
+        }
+    }
+    void stop() {
+        if (!this->running) return;
+        this->running = false;
+
+        this->wake();
+        this->listener.join();
+        close(this->listen_fd);
+
+        // Niewykonane zadania OpenGL kończą oczekujące żądania błędem (broken_promise)
+        {
+            std::lock_guard<std::mutex> lock(this->gl_mutex);
+            this->gl_tasks.clear();
+        }
+        {
+            std::lock_guard<std::mutex> lock(this->connections_mutex);
+            for (int fd : this->active) shutdown(fd, SHUT_RDWR);
+        }
+
+        this->connections_ready.notify_all();
+        this->gl_ready.notify_all();
+        for (std::thread& worker : this->workers) worker.join();
+        this->workers.clear();
+
+        for (Connection const& c : this->connections) close(c.fd);
+        for (Connection const& c : this->returned)    close(c.fd);
+        this->connections.clear();
+        this->returned.clear();
+
+        close(this->wake_fds[0]);
+        close(this->wake_fds[1]);
+    }
+    // Wykonuje zadania OpenGL z kolejki (wywoływane w wątku kontekstu), czeka najwyżej `timeout`
+    // na pierwsze zadanie. Zwraca liczbę wykonanych zadań.
+    unsigned int pump(std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(this->gl_mutex);
+        this->gl_ready.wait_for(lock, timeout, [this]() { return !this->gl_tasks.empty() || !this->running; });
+
+        unsigned int done = 0;
+        while (!this->gl_tasks.empty()) {
+            std::packaged_task<std::vector<uint8_t>()> task = std::move(this->gl_tasks.front());
+            this->gl_tasks.pop_front();
+
+            lock.unlock();
+            task();
+            done++;
+            lock.lock();
+        }
+        return done;
+    }
+    int getPort() const {
+        return this->port;
+    }
+    TileCache& getCache() {
+        return this->cache;
+    }
+    TileServerStats getStats() {
+        TileServerStats stats;
+        this->cache.getStats(stats.requests, stats.hits, stats.coalesced, stats.computed, stats.cache_bytes);
+        stats.errors = this->errors;
+        return stats;
+    }
+    // Odpowiedź na ścieżkę żądania (bez połączenia, np. do pomiarów), zwraca kod HTTP
+    int handle(std::string const& path, std::string& body, std::string& type) {
+        TileKey key;
+
+        if (path == "/stats") {
+            TileServerStats stats = this->getStats();
+            char text[256];
+            snprintf(text, sizeof(text), "{\"requests\": %zu, \"hits\": %zu, \"coalesced\": %zu, \"computed\": %zu, \"cache_bytes\": %zu, \"errors\": %zu}\n",
+                stats.requests, stats.hits, stats.coalesced, stats.computed, stats.cache_bytes, stats.errors);
+            body = text;
+            type = "application/json";
+            return 200;
+        }
+
+        if (parseTilePath(path, "/terrain/", key))
+            key.kind = TileKey::Terrain;
+        else if (parseTilePath(path, "/map/", key))
+            key.kind = TileKey::Map;
+        else
+            return 404;
+
+        if (!key.isValid()) return 404;
+
+        TileBody tile = this->cache.get(key, [this, &key]() {
+            return key.kind == TileKey::Terrain ? this->terrainTile(key) : this->mapTile(key);
+        });
+        if (!tile) return 404;
+
+        body = *tile;
+        type = "image/png";
+        return 200;
+    }
+    // Wiersz (ułamkowy, od północy) obrazu równoodległościowego kafla key o height wierszach,
+    // w którym leży szerokość środka wiersza py kafla Web Mercator
+    static double sourceRow(TileKey const& key, int py, int height) {
+        double lat_max = TileKey::latitude(key.y, key.z), lat_min = TileKey::latitude(key.y + 1, key.z);
+        double lat = TileKey::latitude(key.y + (py + 0.5) / TileKey::SIZE, key.z);
+
+        return (lat_max - lat) / (lat_max - lat_min) * height - 0.5;
+    }
+    // Obraz RGB kafla key w odwzorowaniu równoodległościowym (SIZE x height, wierszami od północy)
+    // na SIZE x SIZE w Web Mercator - interpolacja liniowa między wierszami źródła
+    static std::vector<uint8_t> reproject(TileKey const& key, std::vector<uint8_t> const& rgb, int height) {
+        const int size = TileKey::SIZE;
+        std::vector<uint8_t> result((size_t)size * size * 3);
+
+        for (int py = 0; py < size; py++) {
+            double s = std::clamp(sourceRow(key, py, height), 0.0, height - 1.0);
+            int r0 = (int)s, r1 = std::min(r0 + 1, height - 1);
+            float w = (float)(s - r0);
+
+            uint8_t const* a = &rgb[(size_t)r0 * size * 3];
+            uint8_t const* b = &rgb[(size_t)r1 * size * 3];
+            uint8_t* dst = &result[(size_t)py * size * 3];
+
+            for (int k = 0; k < size * 3; k++) dst[k] = (uint8_t)std::lround(a[k] + (b[k] - a[k]) * w);
+        }
+        return result;
+    }
+private:
+    TileManager& tileManager;
+    MapRenderer& renderer;
+    TileCache cache;
+
+    unsigned int thread_count;
+    int listen_fd = -1, port = 0;
+    std::atomic<bool> running{ false };
+    std::atomic<size_t> errors{ 0 };
+
+    std::thread listener;
+    std::vector<std::thread> workers;
+
+    // Połączenie z nieobsłużoną częścią odebranych danych i czasem ostatniej odpowiedzi
+    struct Connection {
+        int fd;
+        std::string buffer;
+        std::chrono::steady_clock::time_point idle_since;
+    };
+
+    std::mutex connections_mutex;
+    std::condition_variable connections_ready;
+    std::deque<Connection> connections;         // Z nowym żądaniem, czekające na wątek puli
+    std::vector<Connection> returned;           // Oddane przez wątki puli, do przejęcia przez acceptLoop
+    std::unordered_set<int> active;             // Połączenia obsługiwane przez wątki puli
+    int wake_fds[2] = { -1, -1 };               // Budzenie poll w acceptLoop (oddane połączenie, stop)
+
+    std::mutex gl_mutex;
+    std::condition_variable gl_ready;
+    std::deque<std::packaged_task<std::vector<uint8_t>()>> gl_tasks;
+
+    // Wysokości w środkach pikseli kafla; nullptr jeśli żaden piksel nie trafia w załadowany kafel
+    TileBody terrainTile(TileKey const& key) {
+        const int size = TileKey::SIZE;
+        std::vector<uint8_t> rgb((size_t)size * size * 3);
+
+        // Długości geograficzne kolumn wspólne dla wszystkich wierszy
+        std::vector<double> lons(size);
+        for (int px = 0; px < size; px++) lons[px] = TileKey::longitude(key.x + (px + 0.5) / size, key.z);
+
+        Tile const* tile = nullptr;
+        int tile_lat = INT32_MIN, tile_lon = INT32_MIN;
+        bool any = false;
+
+        for (int py = 0; py < size; py++) {
+            double lat = TileKey::latitude(key.y + (py + 0.5) / size, key.z);
+            int lat_deg = (int)std::floor(lat);
+
+            for (int px = 0; px < size; px++) {
+                int lon_deg = (int)std::floor(lons[px]);
+
+                if (lat_deg != tile_lat || lon_deg != tile_lon) {
+                    tile = this->tileManager.findTile(lat_deg, lon_deg);
+                    tile_lat = lat_deg;
+                    tile_lon = lon_deg;
+                }
+
+                float height = tile != nullptr ? tile->getHeightInterpolated(lat - lat_deg, lons[px] - lon_deg) : Tile::NO_DATA;
+                if (height == Tile::NO_DATA) height = 0.0f;
+                else any = true;
+
+                uint32_t value = (uint32_t)std::clamp( std::lround((height + 32768.0f) * 256.0f), 0L, (long)0xFFFFFF );
+                uint8_t* pixel = &rgb[((size_t)py * size + px) * 3];
+                pixel[0] = value >> 16;
+                pixel[1] = (value >> 8) & 0xFF;
+                pixel[2] = value & 0xFF;
+            }
+        }
+
+        if (!any) return nullptr;
+        return std::make_shared<const std::string>( ImageWriter::encodePng(size, size, rgb) );
+    }
+    // Obszar kafla rysowany w odwzorowaniu walcowym równoodległościowym widoku 2D (MAP_OVERSAMPLE
+    // razy więcej wierszy), wiersze przeliczane na Web Mercator (reproject). Rysowanie w wątku
+    // OpenGL, przeliczanie i kodowanie PNG tutaj.
+    TileBody mapTile(TileKey const& key) {
+        RenderJob job;
+        job.lon_min = TileKey::longitude(key.x,     key.z);
+        job.lon_max = TileKey::longitude(key.x + 1, key.z);
+        job.lat_max = TileKey::latitude (key.y,     key.z);
+        job.lat_min = TileKey::latitude (key.y + 1, key.z);
+        job.width  = TileKey::SIZE;
+        job.height = TileKey::SIZE * MAP_OVERSAMPLE;
+
+        std::packaged_task<std::vector<uint8_t>()> task([this, job]() { return this->renderer.renderImage(job); });
+        std::future<std::vector<uint8_t>> rgba = task.get_future();
+        {
+            std::lock_guard<std::mutex> lock(this->gl_mutex);
+            if (!this->running) return nullptr;
+            this->gl_tasks.push_back(std::move(task));
+        }
+        this->gl_ready.notify_one();
+
+        std::vector<uint8_t> rgb = reproject(key, ImageWriter::flipToRgb(job.width, job.height, rgba.get()), job.height);
+        return std::make_shared<const std::string>( ImageWriter::encodePng(TileKey::SIZE, TileKey::SIZE, rgb) );
+    }
+
+    void wake() {
+        char byte = 0;
+        if (write(this->wake_fds[1], &byte, 1) < 0) {}
+    }
+    // Nowe połączenia i bezczynne połączenia keep-alive: gotowe do odczytu trafiają do kolejki
+    // wątków puli, bezczynne dłużej niż IDLE_TIMEOUT są zamykane
+    void acceptLoop() {
+        std::vector<Connection> idle;
+        std::vector<pollfd> fds;
+
+        while (this->running) {
+            {
+                std::lock_guard<std::mutex> lock(this->connections_mutex);
+                for (Connection& c : this->returned) idle.push_back(std::move(c));
+                this->returned.clear();
+            }
+
+            fds.assign({ pollfd{ this->listen_fd, POLLIN, 0 }, pollfd{ this->wake_fds[0], POLLIN, 0 } });
+            for (Connection const& c : idle) fds.push_back( pollfd{ c.fd, POLLIN, 0 } );
+
+            if (poll(fds.data(), fds.size(), 1000) < 0) continue;
+            if (!this->running) break;
+
+            if (fds[1].revents & POLLIN) {
+                char bytes[64];
+                if (read(this->wake_fds[0], bytes, sizeof(bytes)) < 0) {}
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            std::vector<Connection> ready;
+
+            for (size_t k = idle.size(); k-- > 0; ) {
+                bool readable = fds[k + 2].revents != 0;
+                if (!readable && now - idle[k].idle_since < IDLE_TIMEOUT) continue;
+
+                if (readable) ready.push_back(std::move(idle[k]));
+                else          close(idle[k].fd);
+
+                idle[k] = std::move(idle.back());
+                idle.pop_back();
+            }
+
+            if (fds[0].revents & POLLIN) {
+                int fd = accept(this->listen_fd, nullptr, nullptr);
+                if (fd >= 0) {
+                    int yes = 1;
+                    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+
+                    idle.push_back( Connection{ fd, std::string(), now } );
+                }
+            }
+
+            if (ready.empty()) continue;
+            {
+                std::lock_guard<std::mutex> lock(this->connections_mutex);
+                for (Connection& c : ready) this->connections.push_back(std::move(c));
+            }
+            this->connections_ready.notify_all();
+        }
+
+        for (Connection const& c : idle) close(c.fd);
+    }
+    void workLoop() {
+        while (true) {
+            Connection connection;
+            {
+                std::unique_lock<std::mutex> lock(this->connections_mutex);
+                this->connections_ready.wait(lock, [this]() { return !this->running || !this->connections.empty(); });
+                if (!this->running) return;
+
+                connection = std::move(this->connections.front());
+                this->connections.pop_front();
+                this->active.insert(connection.fd);
+            }
+
+            bool keep_alive = this->serveConnection(connection);
+
+            {
+                std::lock_guard<std::mutex> lock(this->connections_mutex);
+                this->active.erase(connection.fd);
+
+                if (keep_alive && this->running) {
+                    // Niedokończone żądanie nie odnawia czasu bezczynności (IDLE_TIMEOUT od ostatniej odpowiedzi)
+                    if (connection.buffer.empty()) connection.idle_since = std::chrono::steady_clock::now();
+                    this->returned.push_back(std::move(connection));
+                } else {
+                    close(connection.fd);
+                    continue;
+                }
+            }
+            this->wake();
+        }
+    }
+    // Żądania GET połączenia gotowego do odczytu (ciała żądań nie są obsługiwane): pierwsze żądanie
+    // i następne, które już są w buforze. Odczyt bez czekania - niedokończone żądanie zostaje w buforze,
+    // a połączenie wraca do acceptLoop (wątek puli nie czeka na klienta). false - połączenie do zamknięcia.
+    bool serveConnection(Connection& connection) {
+        std::string& buffer = connection.buffer;
+        char chunk[4096];
+
+        do {
+            size_t end;
+            while ((end = buffer.find("\r\n\r\n")) == std::string::npos) {
+                ssize_t n = recv(connection.fd, chunk, sizeof(chunk), MSG_DONTWAIT);
+                if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return this->running;
+                if (n <= 0 || buffer.size() > 16384) return false;
+                buffer.append(chunk, n);
+            }
+
+            std::string head = buffer.substr(0, end);
+            buffer.erase(0, end + 4);
+
+            char method[8] = { 0 }, target[1024] = { 0 };
+            std::string body, type = "text/plain";
+            int status;
+
+            if (sscanf(head.c_str(), "%7s %1023s", method, target) != 2) {
+                status = 400;
+            } else if (std::strcmp(method, "GET") != 0) {
+                status = 405;
+            } else {
+                try {
+                    status = this->handle(target, body, type);
+                } catch (const std::exception& e) {
+                    status = 500;
+                    body = std::string(e.what()) + "\n";
+                }
+            }
+            if (status >= 400) this->errors++;
+
+            bool keep_alive = head.find("Connection: close") == std::string::npos && head.find("HTTP/1.0") == std::string::npos;
+
+            std::string response = "HTTP/1.1 " + std::to_string(status) + (status == 200 ? " OK" : " Error") + "\r\n"
+                + "Content-Type: " + type + "\r\n"
+                + "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                + (keep_alive ? "" : "Connection: close\r\n")
+                + "\r\n";
+            response += body;
+
+            if (!sendAll(connection.fd, response) || !keep_alive) return false;
+        } while (this->running && buffer.find("\r\n\r\n") != std::string::npos);
+
+        return this->running;
+    }
+    // Ścieżka prefix{z}/{x}/{y}.png - tylko cyfry w liczbach i nic po rozszerzeniu
+    static bool parseTilePath(std::string const& path, char const* prefix, TileKey& key) {
+        size_t length = std::strlen(prefix);
+        if (path.compare(0, length, prefix) != 0) return false;
+
+        size_t pos = length;
+        int* values[3] = { &key.z, &key.x, &key.y };
+
+        for (int k = 0; k < 3; k++) {
+            size_t first = pos;
+            long value = 0;
+
+            while (pos < path.size() && pos - first < 9 && std::isdigit( (unsigned char)path[pos] )) value = value * 10 + (path[pos++] - '0');
+            if (pos == first) return false;
+            *values[k] = (int)value;
+
+            char const* separator = k < 2 ? "/" : ".png";
+            if (path.compare(pos, std::strlen(separator), separator) != 0) return false;
+            pos += std::strlen(separator);
+        }
+
+        return pos == path.size();
+    }
+    static bool sendAll(int fd, std::string const& data) {
+        for (size_t sent = 0; sent < data.size(); ) {
+            ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) return false;
+            sent += n;
+        }
+        return true;
+    }
+};
+
+
+// ----------------------------------------
+//
+//      HTTP CLIENT class
+//
+// ----------------------------------------
+
+// Minimalny klient HTTP/1.1 z jednym połączeniem keep-alive do 127.0.0.1 (pomiary serwera)
+class HttpClient {
+public:
+    HttpClient(int port) : port(port) {}
+    ~HttpClient() {
+        if (this->fd >= 0) close(this->fd);
+    }
+public:
+    // Zwraca kod HTTP lub -1 przy błędzie połączenia
+    int get(std::string const& path, std::string& body) {
+        if (this->fd < 0 && !this->connect()) return -1;
+
+        std::string request = "GET " + path + " HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+        if (send(this->fd, request.data(), request.size(), MSG_NOSIGNAL) != (ssize_t)request.size()) return this->fail();
+
+        size_t end;
+        while ((end = this->buffer.find("\r\n\r\n")) == std::string::npos) {
+            if (!this->receive()) return this->fail();
+        }
+
+        int status = 0;
+        size_t length = 0;
+        std::string head = this->buffer.substr(0, end);
+        sscanf(head.c_str(), "HTTP/1.%*d %d", &status);
+
+        size_t field = head.find("Content-Length: ");
+        if (field != std::string::npos) length = std::stoul(head.substr(field + 16));
+
+        this->buffer.erase(0, end + 4);
+        while (this->buffer.size() < length) {
+            if (!this->receive()) return this->fail();
+        }
+
+        body = this->buffer.substr(0, length);
+        this->buffer.erase(0, length);
+
+        if (head.find("Connection: close") != std::string::npos) this->fail();
+        return status;
+    }
+private:
+    int port, fd = -1;
+    std::string buffer;
+
+    bool connect() {
+        this->fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (this->fd < 0) return false;
+
+        int yes = 1;
+        setsockopt(this->fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+
+        sockaddr_in address{};
+        address.sin_family      = AF_INET;
+        address.sin_port        = htons(this->port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        if (::connect(this->fd, (sockaddr*)&address, sizeof(address)) < 0) {
+            this->fail();
+            return false;
+        }
+        return true;
+    }
+    bool receive() {
+        char chunk[65536];
+        ssize_t n = recv(this->fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) return false;
+
+        this->buffer.append(chunk, n);
+        return true;
+    }
+    int fail() {
+        close(this->fd);
+        this->fd = -1;
+        this->buffer.clear();
+        return -1;
+    }
+};
+
+#endif
@@ -0,0 +1,107 @@
+// ==========================================================================
+// UploadRing: class definitions
+//
+// Michał Chawar
+// ==========================================================================
+// UploadRing
+//===========================================================================
+
+#pragma once
+
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+#include <epoxy/gl.h>
+
+
+// ----------------------------------------
+//
+//      UPLOAD RING class
+//
+// ----------------------------------------
+
+// Trwale zmapowany bufor pośredni (GL_ARB_buffer_storage) podzielony na sloty.
+// Dane kopiowane są do kolejnego slotu, a kopię do bufora docelowego wykonuje GPU
+// (glCopyBufferSubData), bez blokującego glBufferData. Slot jest ponownie używany
+// dopiero po sygnale jego płotu (fence).
+class UploadRing {
+public:
+    UploadRing(size_t slot_size, unsigned int slots) : slot_size(slot_size), fences(slots, nullptr) {
+        if (!(epoxy_gl_version() >= 44 || epoxy_has_gl_extension("GL_ARB_buffer_storage"))) return;
+
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        glGenBuffers(1, &this->buffer);
+        glBindBuffer(GL_COPY_READ_BUFFER, this->buffer);
+        glBufferStorage(GL_COPY_READ_BUFFER, slot_size * slots, nullptr, flags);
+
+        this->mapped = static_cast<unsigned char*>( glMapBufferRange(GL_COPY_READ_BUFFER, 0, slot_size * slots, flags) );
+    }
+    ~UploadRing() {
+        for (GLsync fence : this->fences) {
+            if (fence) glDeleteSync(fence);
+        }
+
+        if (this->buffer) {
+            if (this->mapped) {
+                glBindBuffer(GL_COPY_READ_BUFFER, this->buffer);
+                glUnmapBuffer(GL_COPY_READ_BUFFER);
+            }
+            glDeleteBuffers(1, &this->buffer);
+        }
+    }
+public:
+    bool isAvailable() const {
+        return this->mapped != nullptr;
+    }
+    // Kopiuje `size` bajtów na początek bufora `target`, którego pamięć musi być już
+    // zaalokowana. Dane większe od slotu przesyłane są w kolejnych slotach.
+    void upload(GLuint target, void const* data, size_t size) {
+        auto src = static_cast<unsigned char const*>(data);
+
+        for (size_t done = 0; done < size; done += this->slot_size) {
+            this->uploadSlot(target, done, src + done, std::min(this->slot_size, size - done));
+        }
+    }
+    unsigned int getWaits() const {
+        return this->waits;
+    }
+private:
+    void uploadSlot(GLuint target, size_t target_offset, unsigned char const* data, size_t size) {
+        GLsync& fence = this->fences[ this->next ];
+
+        if (fence) {
+            // Slot jeszcze w użyciu przez GPU - czekanie (liczone, powinno być rzadkie)
+            GLenum state = glClientWaitSync(fence, 0, 0);
+            if (state == GL_TIMEOUT_EXPIRED) {
+                this->waits++;
+                while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+            }
+
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+
+        size_t offset = this->next * this->slot_size;
+        std::memcpy(this->mapped + offset, data, size);
+
+        glBindBuffer(GL_COPY_READ_BUFFER,  this->buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, target);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offset, target_offset, size);
+
+        fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        this->next = (this->next + 1) % this->fences.size();
+    }
+
+    GLuint buffer = 0;
+    unsigned char* mapped = nullptr;
+
+    size_t slot_size;
+    std::vector<GLsync> fences;
+    unsigned int next = 0;
+
+    unsigned int waits = 0;
+};
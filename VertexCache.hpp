@@ -0,0 +1,155 @@
+// ==========================================================================
+// VertexCache: class definitions
+//
+// Michał Chawar
+// ==========================================================================
+// GridOrder
+// GridIndices
+// VertexCacheStats
+// VertexCacheSimulator
+//===========================================================================
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+
+// ----------------------------------------
+//
+//      GRID INDICES class
+//
+// ----------------------------------------
+
+enum class GridOrder {
+    RowMajor,       // Czworokąty wierszami przez cały blok
+    Strips          // Pasy kolumn o szerokości dobranej do pamięci podręcznej wierzchołków ("strip of strips")
+};
+
+// Indeksy siatki regularnej bloku side x side wierzchołków (wierszami od południa) z krokiem lod:
+// czworokąt w wierszu i i kolumnie j (wielokrotności lod) to trójkąty (i0, i1, i2), (i1, i3, i2),
+// przeciwnie do ruchu wskazówek zegara; ostatni wiersz i kolumna czworokątów dociągnięte do krawędzi bloku.
+// Przy kolejności wierszami z 1201 wierzchołkami w wierszu GPU nie korzysta z przetworzonych wierzchołków
+// poprzedniego wiersza - każdy wierzchołek przechodzi przez vertex shader dwa razy (ACMR ok. 1,0).
+// GridOrder::Strips przechodzi blok pasami po getBandWidth czworokątów: wiersz pasa zostawia w pamięci
+// podręcznej wierzchołki, które następny wiersz pasa odczytuje (ACMR ok. 0,5 + 1 / (2 * pas), przy
+// pamięci podręcznej 16 - pas 7 i ACMR 0,57).
+// Zbiór trójkątów (i ich obieg) jest w obu kolejnościach ten sam.
+class GridIndices {
+public:
+    constexpr static int CACHE_SIZE = 16;       // Zakładana pamięć podręczna wierzchołków po transformacji (FIFO)
+
+    // Czworokątów na bok bloku
+    static int getQuads(int side, int lod) {
+        return (side - 2) / lod + 1;
+    }
+    // Liczba indeksów (6 na czworokąt)
+    static size_t getCount(int side, int lod) {
+        size_t quads = getQuads(side, lod);
+        return quads * quads * 6;
+    }
+    // Szerokość pasa w czworokątach. Pierwszy wiersz pasa wstawia na przemian wierzchołki dolne i górne -
+    // 2 * (pas + 1), i jeśli nie zmieszczą się w FIFO, następny wiersz chybia dolnych wierzchołków, wstawia
+    // je ponownie na przemian z górnymi i tak do końca pasa (ACMR powyżej 1,0, gorzej niż wierszami).
+    static int getBandWidth(int cache) {
+        return std::max(cache / 2 - 1, 1);
+    }
+
+    // Szerokość pasa w czworokątach dla kolejności order (wierszami - jeden pas przez cały blok)
+    static int getBand(int side, int lod, GridOrder order, int cache = CACHE_SIZE) {
+        return order == GridOrder::Strips ? std::min(getBandWidth(cache), getQuads(side, lod)) : getQuads(side, lod);
+    }
+
+    static std::vector<unsigned int> build(int side, int lod, GridOrder order, int cache = CACHE_SIZE) {
+        std::vector<unsigned int> indices(getCount(side, lod));
+        build(indices.data(), side, lod, order, cache);
+
+        return indices;
+    }
+    // Zapis do out (getCount(side, lod) indeksów)
+    static void build(unsigned int* out, int side, int lod, GridOrder order, int cache = CACHE_SIZE) {
+        int quads = getQuads(side, lod), band = getBand(side, lod, order, cache);
+
+        for (int b0 = 0; b0 < quads; b0 += band) buildPart(out, side, lod, band, b0, 0, quads);
+    }
+    // Część indeksów: czworokąty pasa zaczynającego się w kolumnie b0 z wierszy [row0, row1), zapisywane
+    // w tym samym miejscu out (początek indeksów całego LOD) co przez build - części rozłączne można
+    // wypełniać z różnych wątków
+    static void buildPart(unsigned int* out, int side, int lod, int band, int b0, int row0, int row1) {
+        int quads = getQuads(side, lod);
+        int b1 = std::min(b0 + band, quads);
+
+        out += ((size_t)b0 * quads + (size_t)row0 * (b1 - b0)) * 6;
+
+        for (int qi = row0; qi < row1; qi++) {
+            for (int qj = b0; qj < b1; qj++) {
+                out = quad(out, side, lod, qi * lod, qj * lod);
+            }
+        }
+    }
+private:
+    static unsigned int* quad(unsigned int* out, int side, int lod, int i, int j) {
+        unsigned int i0 = i * side + j;
+        unsigned int i1 = std::min(i0 + lod, (unsigned int)((i + 1) * side - 1));
+        unsigned int i2 = std::min(i0 + side * lod, (unsigned int)(side * (side - 1) + j));
+        unsigned int i3 = std::min(i2 + lod, (i2 / side + 1) * side - 1);
+
+        out[0] = i0; out[1] = i1; out[2] = i2;
+        out[3] = i1; out[4] = i3; out[5] = i2;
+
+        return out + 6;
+    }
+};
+
+
+// ----------------------------------------
+//
+//      VERTEX CACHE SIMULATOR class
+//
+// ----------------------------------------
+
+struct VertexCacheStats {
+    uint64_t triangles = 0;
+    uint64_t transforms = 0;        // Wywołań vertex shadera (chybienia pamięci podręcznej)
+    uint64_t vertices = 0;          // Różnych wierzchołków
+
+    // Średnio wywołań vertex shadera na trójkąt (ACMR): siatka regularna od ok. 0,5 do 3,0
+    double getACMR() const {
+        return this->triangles > 0 ? (double)this->transforms / this->triangles : 0.0;
+    }
+    // Średnio wywołań na wierzchołek (ATVR): 1,0 - każdy wierzchołek przetworzony raz
+    double getATVR() const {
+        return this->vertices > 0 ? (double)this->transforms / this->vertices : 0.0;
+    }
+};
+
+// Pamięć podręczna wierzchołków po transformacji jako kolejka FIFO o stałym rozmiarze (model większości
+// GPU z siatkami indeksowanymi): wierzchołek spoza kolejki jest przetwarzany i dopisywany na jej koniec.
+class VertexCacheSimulator {
+public:
+    static VertexCacheStats run(unsigned int const* indices, size_t count, int cache_size) {
+        VertexCacheStats stats;
+        stats.triangles = count / 3;
+
+        unsigned int last = 0;
+        for (size_t k = 0; k < count; k++) last = std::max(last, indices[k]);
+
+        // Numer wstawienia wierzchołka do kolejki (0 - nie wstawiony); w kolejce, jeśli wśród ostatnich cache_size
+        std::vector<uint64_t> inserted((size_t)last + 1, 0);
+        uint64_t clock = 0;
+
+        for (size_t k = 0; k < count; k++) {
+            uint64_t& stamp = inserted[indices[k]];
+            if (stamp != 0 && clock - stamp < (uint64_t)cache_size) continue;
+
+            if (stamp == 0) stats.vertices++;
+            stamp = ++clock;
+            stats.transforms++;
+        }
+        return stats;
+    }
+    static VertexCacheStats run(std::vector<unsigned int> const& indices, int cache_size) {
+        return run(indices.data(), indices.size(), cache_size);
+    }
+};
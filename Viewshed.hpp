@@ -0,0 +1,277 @@
+// ==========================================================================
+// Viewshed: class definitions
+//
+// Michał Chawar
+// ==========================================================================
+// ViewshedResult
+// Viewshed
+//===========================================================================
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+#include <TileManager.hpp>
+
+
+// ----------------------------------------
+//
+//      VIEWSHED RESULT class
+//
+// ----------------------------------------
+
+class ViewshedResult {
+public:
+    // Wartości maski widoczności (zapisywane bezpośrednio do tekstury GL_R8)
+    constexpr static uint8_t OUTSIDE = 0;       // Poza zasięgiem analizy lub brak danych
+    constexpr static uint8_t HIDDEN  = 128;     // Niewidoczny z punktu obserwacji
+    constexpr static uint8_t VISIBLE = 255;     // Widoczny z punktu obserwacji
+
+    double lat_min = 0.0, lon_min = 0.0;    // Środek komórki (0, 0), czyli róg południowo-zachodni
+    double cell_size = 1.0 / 1200.0;        // Rozmiar komórki w stopniach (3")
+    int rows = 0, cols = 0;
+    std::vector<uint8_t> mask;              // Wierszami od południa, rows * cols wartości
+
+    unsigned int threads = 0;
+    float computeTimeMs = 0.0f;
+    float gatherTimeMs = 0.0f;              // W tym kopiowanie wysokości z kafli
+public:
+    uint8_t get(int row, int col) const {
+        return this->mask[(size_t)row * this->cols + col];
+    }
+    // Granice nakładki (lon, lat, szerokość, wysokość) - krawędzie skrajnych komórek
+    glm::vec4 getOverlayBounds() const {
+        return glm::vec4(
+            this->lon_min - this->cell_size / 2.0,
+            this->lat_min - this->cell_size / 2.0,
+            this->cols * this->cell_size,
+            this->rows * this->cell_size
+        );
+    }
+    unsigned int countVisible() const {
+        return std::count(this->mask.begin(), this->mask.end(), VISIBLE);
+    }
+};
+
+
+// ----------------------------------------
+//
+//      VIEWSHED class
+//
+// ----------------------------------------
+
+// Analiza widoczności z punktu metodą promieni wypuszczanych do każdej komórki
+// obwodu obszaru (R2). Obwód dzielony jest na sektory liczone w osobnych wątkach,
+// zapisujące do jednej maski (zob. compute).
+class Viewshed {
+public:
+    Viewshed(TileManager& tileManager) : tileManager(tileManager) {}
+public:
+    ViewshedResult compute(double lon, double lat, double radius = 50000.0, float observer_height = 10.0f, float target_height = 0.0f) {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        ViewshedResult result;
+
+        // Rozmiar komórki w metrach (w poziomie skrócony o cos szerokości geograficznej)
+        double earth_radius = this->tileManager.getEarthRadiusMeters();
+        this->cell_h = glm::radians(result.cell_size) * earth_radius;
+        this->cell_w = this->cell_h * std::cos(glm::radians(lat));
+        this->radius2 = radius * radius;
+        this->curvature = (1.0 - this->refraction) / (2.0 * earth_radius);
+        this->target_height = target_height;
+
+        this->half_rows = (int)std::ceil(radius / this->cell_h);
+        this->half_cols = (int)std::ceil(radius / this->cell_w);
+
+        result.rows = 2 * this->half_rows + 1;
+        result.cols = 2 * this->half_cols + 1;
+
+        int row0 = (int)std::lround(lat * 1200.0) - this->half_rows,
+            col0 = (int)std::lround(lon * 1200.0) - this->half_cols;
+
+        result.lat_min = row0 * result.cell_size;
+        result.lon_min = col0 * result.cell_size;
+
+        unsigned int n = this->threadCount;
+
+        this->gather(row0, col0, result.rows, result.cols, n);
+        result.gatherTimeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        float ground = this->heights[(size_t)this->half_rows * result.cols + this->half_cols];
+        this->observer = (ground == Tile::NO_DATA ? 0.0f : ground) + observer_height;
+
+        // Wspólna maska dla wszystkich wątków: komórki przy granicach sektorów mogą być odwiedzane przez
+        // promienie z obu stron - zapis tylko większej wartości (VISIBLE > HIDDEN > OUTSIDE), atomowo
+        size_t cells = (size_t)result.rows * result.cols;
+        std::unique_ptr<std::atomic<uint8_t>[]> shared(new std::atomic<uint8_t>[cells]);
+
+        int perimeter = 4 * this->half_rows + 4 * this->half_cols;
+        int sector = (perimeter + (int)n - 1) / (int)n;
+        size_t band = (cells + n - 1) / n;
+
+        std::vector<std::thread> workers;
+        for (unsigned int t = 0; t < n; t++) {
+            workers.emplace_back([&shared, t, band, cells]() {
+                for (size_t i = std::min(t * band, cells); i < std::min((t + 1) * band, cells); i++) shared[i].store(ViewshedResult::OUTSIDE, std::memory_order_relaxed);
+            });
+        }
+        for (auto& w : workers) w.join();
+        workers.clear();
+
+        for (unsigned int t = 0; t < n; t++) {
+            workers.emplace_back([this, &shared, &result, t, sector, perimeter]() {
+                this->sweep(std::min((int)t * sector, perimeter), std::min((int)(t + 1) * sector, perimeter), result.cols, shared.get());
+            });
+        }
+        for (auto& w : workers) w.join();
+        workers.clear();
+
+        // Wynik jako zwykłe bajty (tekstura nakładki) - równolegle, pasami
+        result.mask.resize(cells);
+        for (unsigned int t = 0; t < n; t++) {
+            workers.emplace_back([&shared, &result, t, band, cells]() {
+                for (size_t i = std::min(t * band, cells); i < std::min((t + 1) * band, cells); i++) result.mask[i] = shared[i].load(std::memory_order_relaxed);
+            });
+        }
+        for (auto& w : workers) w.join();
+
+        result.mask[(size_t)this->half_rows * result.cols + this->half_cols] = ViewshedResult::VISIBLE;
+
+        result.threads = n;
+        result.computeTimeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        return result;
+    }
+public:
+    void setThreadCount(unsigned int n) {
+        this->threadCount = std::max(1u, n);
+    }
+    unsigned int getThreadCount() const {
+        return this->threadCount;
+    }
+    // Współczynnik refrakcji atmosferycznej (0 - sama krzywizna Ziemi)
+    void setRefraction(double k) {
+        this->refraction = k;
+    }
+private:
+    TileManager& tileManager;
+    unsigned int threadCount = std::max(1u, std::thread::hardware_concurrency());
+    double refraction = 0.13;
+
+    // Stan bieżącego obliczenia (tylko do odczytu w wątkach)
+    std::vector<float> heights;
+    int half_rows, half_cols;
+    double cell_h, cell_w, radius2, curvature;
+    float observer, target_height;
+
+    static int floorDiv(int a, int b) {
+        return a / b - (a % b != 0 && (a < 0) != (b < 0));
+    }
+
+    // Kopiowanie wysokości z kafli do ciągłego rastra wokół obserwatora: kafle wyszukiwane raz,
+    // wiersze rastra kopiowane pasami w wątkach (Tile::getSample - bez sprawdzania zakresu)
+    void gather(int row0, int col0, int rows, int cols, unsigned int n) {
+        this->heights.assign((size_t)rows * cols, Tile::NO_DATA);
+
+        int lat_first = floorDiv(row0, 1200), lat_last = floorDiv(row0 + rows - 1, 1200),
+            lon_first = floorDiv(col0, 1200), lon_last = floorDiv(col0 + cols - 1, 1200);
+        int lon_count = lon_last - lon_first + 1;
+
+        std::vector<Tile const*> tiles;
+        for (int lat = lat_first; lat <= lat_last; lat++) {
+            for (int lon = lon_first; lon <= lon_last; lon++) tiles.push_back(this->tileManager.findTile(lat, lon));
+        }
+
+        auto copyRows = [&](int r_first, int r_last) {
+            for (int r = r_first; r < r_last; r++) {
+                int lat = floorDiv(r, 1200);
+                float* dst = &this->heights[(size_t)(r - row0) * cols];
+
+                for (int lon = lon_first; lon <= lon_last; lon++) {
+                    // Wspólna krawędź kafli z kafla północnego (wschodniego), bez niego - z sąsiada
+                    int tile_lat = lat, row = r - lat * 1200;
+                    Tile const* tile = tiles[(size_t)(lat - lat_first) * lon_count + (lon - lon_first)];
+                    if (tile == nullptr && row == 0 && lat > lat_first) {
+                        tile_lat = lat - 1;
+                        row = 1200;
+                        tile = tiles[(size_t)(tile_lat - lat_first) * lon_count + (lon - lon_first)];
+                    }
+                    if (tile == nullptr) continue;
+
+                    // Analiza na siatce 3" - z kafli 1" co trzecia próbka
+                    int step = (tile->getSamples() - 1) / 1200;
+                    int i = row * step;
+                    int c_begin = std::max(col0, lon * 1200), c_end = std::min(col0 + cols - 1, lon * 1200 + 1200);
+
+                    for (int c = c_begin; c <= c_end; c++) dst[c - col0] = tile->getSample(i, (c - lon * 1200) * step);
+                }
+            }
+        };
+
+        int band = (rows + (int)n - 1) / (int)n;
+        std::vector<std::thread> workers;
+        for (unsigned int t = 1; t < n; t++) {
+            workers.emplace_back(copyRows, row0 + std::min((int)t * band, rows), row0 + std::min((int)(t + 1) * band, rows));
+        }
+        copyRows(row0, row0 + std::min(band, rows));
+        for (auto& w : workers) w.join();
+    }
+
+    // Komórka obwodu o danym indeksie (względem obserwatora), przeciwnie do ruchu wskazówek zegara
+    void perimeterCell(int p, int& r, int& c) const {
+        int side_c = 2 * this->half_cols, side_r = 2 * this->half_rows;
+
+        if (p < side_c)                  { r = -this->half_rows; c = -this->half_cols + p; return; }
+        p -= side_c;
+        if (p < side_r)                  { c =  this->half_cols; r = -this->half_rows + p; return; }
+        p -= side_r;
+        if (p < side_c)                  { r =  this->half_rows; c =  this->half_cols - p; return; }
+        p -= side_c;
+                                           c = -this->half_cols; r =  this->half_rows - p;
+    }
+
+    void sweep(int begin, int end, int cols, std::atomic<uint8_t>* mask) const {
+        for (int p = begin; p < end; p++) {
+            int pr, pc;
+            this->perimeterCell(p, pr, pc);
+
+            int steps = std::max(std::abs(pr), std::abs(pc));
+            double max_slope = -std::numeric_limits<double>::infinity();
+
+            for (int k = 1; k <= steps; k++) {
+                int r = (int)std::lround((double)k * pr / steps),
+                    c = (int)std::lround((double)k * pc / steps);
+
+                double dy = r * this->cell_h, dx = c * this->cell_w;
+                double d2 = dx * dx + dy * dy;
+                if (d2 > this->radius2) break;
+
+                size_t idx = (size_t)(r + this->half_rows) * cols + (c + this->half_cols);
+                float h = this->heights[idx];
+                if (h == Tile::NO_DATA) continue;
+
+                // Obniżenie terenu wynikające z krzywizny Ziemi (z poprawką na refrakcję)
+                double d = std::sqrt(d2);
+                double drop = d2 * this->curvature;
+                double terrain_slope = (h - drop - this->observer) / d;
+                double target_slope  = (h + this->target_height - drop - this->observer) / d;
+
+                uint8_t v = target_slope >= max_slope ? ViewshedResult::VISIBLE : ViewshedResult::HIDDEN;
+                uint8_t current = mask[idx].load(std::memory_order_relaxed);
+                while (current < v && !mask[idx].compare_exchange_weak(current, v, std::memory_order_relaxed)) {}
+
+                if (terrain_slope > max_slope) max_slope = terrain_slope;
+            }
+        }
+    }
+};
@@ -0,0 +1,9 @@
+#version 330 
+#extension GL_ARB_explicit_uniform_location : require
+
+in float major;
+out vec4 color;
+
+void main(void) {
+    color = vec4(mix(vec3(0.35, 0.2, 0.1), vec3(0.1, 0.05, 0.0), major), 1.0);
+}
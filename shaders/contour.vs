@@ -0,0 +1,18 @@
+#version 330 
+#extension GL_ARB_explicit_uniform_location : require
+#extension GL_ARB_shading_language_420pack : require
+
+layout(location = 0)  in      vec3  point;            // długość, szerokość (stopnie), wysokość warstwicy
+
+layout(location = 4)  uniform float x_condensation;
+layout(location = 5)  uniform float interval;         // odstęp warstwic (m)
+layout(location = 14) uniform mat4 view;
+layout(location = 15) uniform mat4 projection;
+
+out float major;
+
+void main(void) {
+    // Co piąta warstwica - zasadnicza
+    major = abs(mod(point.z / interval + 0.5, 5.0) - 0.5) < 0.25 ? 1.0 : 0.0;
+    gl_Position = projection * view * vec4(point.x * x_condensation, point.y, 0.0, 1.0);
+}
@@ -3,8 +3,51 @@
 #extension GL_ARB_shading_language_420pack : require
 
 in vec3 fragColor;
+in vec2 geoCoords;
+in float shade;
+in float coverage;
+in float filled;
 out vec4 color;
 
+layout(location = 7)  uniform   int  overlay_mode;       // OverlayKind: 0 - brak, 1 - widoczność, 2-4 - analiza rzeźby
+layout(location = 8)  uniform  vec4  overlay_bounds;
+layout(binding  = 0)  uniform sampler2D overlay;
+
+// Skala analizy rzeźby dla wartości v w (0, 1]: nachylenie i szorstkość od zieleni przez żółć do czerwieni,
+// ekspozycja - koło barw (północ czerwona, wschód żółtozielony, południe turkusowy, zachód fioletowy)
+vec3 analysisColor(int mode, float v) {
+    if (mode == 3) {
+        vec3 k = abs(fract(v + vec3(0.0, 2.0, 1.0) / 3.0) * 6.0 - 3.0);
+        return clamp(k - 1.0, 0.0, 1.0);
+    }
+    return v < 0.5 ? mix(vec3(0.0, 0.6, 0.0), vec3(1.0, 1.0, 0.0), v * 2.0)
+                   : mix(vec3(1.0, 1.0, 0.0), vec3(0.8, 0.0, 0.0), v * 2.0 - 1.0);
+}
+
 void main() {
-    color = vec4(fragColor, 1.0);
+    // Część węzła piramidy przeglądowej poza załadowanymi kaflami
+    if (coverage < 0.5) discard;
+
+    vec3 c = fragColor * shade;
+
+    // Podgląd wypełnionych braków danych
+    if (filled > 0.0) c = mix(c, vec3(1.0, 0.0, 1.0), 0.6 * filled);
+
+    // Nakładka maski widoczności: 0 - poza zasięgiem, 0.5 - niewidoczny, 1 - widoczny;
+    // analizy rzeźby: 0 - brak wartości, dalej wartość przeskalowana do (0, 1]
+    if (overlay_mode != 0) {
+        vec2 uv = (geoCoords - overlay_bounds.xy) / overlay_bounds.zw;
+
+        if (uv.x >= 0.0 && uv.x <= 1.0 && uv.y >= 0.0 && uv.y <= 1.0) {
+            float v = texture(overlay, uv).r;
+
+            if (overlay_mode == 1) {
+                if      (v > 0.75) c = mix(c, vec3(1.0, 1.0, 0.0), 0.45);
+                else if (v > 0.25) c *= 0.35;
+            }
+            else if (v > 0.0) c = mix(c, analysisColor(overlay_mode, v), 0.65);
+        }
+    }
+
+    color = vec4(c, 1.0);
 }
\ No newline at end of file
@@ -7,11 +7,21 @@ layout(location = 0)  in      float height;
 layout(location = 4)  uniform float x_condensation;
 layout(location = 5)  uniform   int  latitude_degrees;
 layout(location = 6)  uniform   int longitude_degrees;
+layout(location = 9)  uniform   int  hillshade_enabled;
+layout(location = 13) uniform   int  tile_samples;      // próbek na bok kafla (1201, 3601, węzeł piramidy 241)
+layout(location = 16) uniform   int  tile_span;         // bok kafla w stopniach (węzły piramidy: 2^poziom)
+layout(location = 17) uniform   int  fill_mask_enabled;
+layout(binding  = 1)  uniform samplerBuffer heights;
+layout(binding  = 4)  uniform samplerBuffer fill_mask;  // 1 - próbka z wypełnionego braku danych
 
 layout(location = 14) uniform mat4 view;
 layout(location = 15) uniform mat4 projection;
 
 out vec3 fragColor;
+out vec2 geoCoords;
+out float shade;
+out float coverage;
+out float filled;
 
 vec3 heightToColor(float ht) {
     if (ht < 0.0) return vec3(0.0, 0.0, 1.0);
@@ -21,13 +31,66 @@ vec3 heightToColor(float ht) {
     else return vec3(1.0, ht / 2000.0 - 1.0, ht / 2000.0 - 1.0);
 }
 
+// Indeks próbki (i, j) w buforze wysokości ułożonym w bloki 1201x1201 (kafle 1" - 3x3 bloki
+// o wspólnych krawędziach, zob. Tile::texelIndex); mniejsze kafle to jeden blok
+int texelIndex(int i, int j) {
+    int side   = min(tile_samples, 1201),
+        blocks = (tile_samples - 1) / (side - 1);
+    int bi = min(i / (side - 1), blocks - 1),
+        bj = min(j / (side - 1), blocks - 1);
+
+    return ((bi * blocks + bj) * side + (i - bi * (side - 1))) * side + (j - bj * (side - 1));
+}
+
+// Cieniowanie rzeźby: normalna z różnic centralnych wysokości sąsiednich próbek (odczyt z bufora
+// wysokości), oświetlenie z północnego zachodu pod kątem 45°. Płaski teren daje wartość 1.0.
+float hillshade(int i, int j, float cos_latitude) {
+    int last = tile_samples - 1;
+    int w = max(j - 1, 0), e = min(j + 1, last),
+        s = max(i - 1, 0), n = min(i + 1, last);
+
+    float h  = height;
+    float hw = texelFetch(heights, texelIndex(i, w)).r, he = texelFetch(heights, texelIndex(i, e)).r,
+          hs = texelFetch(heights, texelIndex(s, j)).r, hn = texelFetch(heights, texelIndex(n, j)).r;
+
+    // Brak danych (-1000) traktowany jak wysokość bieżącej próbki
+    if (hw < -999.0) hw = h;
+    if (he < -999.0) he = h;
+    if (hs < -999.0) hs = h;
+    if (hn < -999.0) hn = h;
+
+    float cell = 6378000.0 * radians(float(tile_span) / float(last));
+    float dzdx = (he - hw) / (float(e - w) * cell * cos_latitude);
+    float dzdy = (hn - hs) / (float(n - s) * cell);
+
+    // Przewyższenie dla czytelności rzeźby na nizinach
+    vec3 normal = normalize(vec3(-dzdx * 3.0, -dzdy * 3.0, 1.0));
+    vec3 light  = normalize(vec3(-0.5, 0.5, 0.7071));
+
+    return clamp(dot(normal, light) / light.z, 0.0, 1.5);
+}
+
 void main() {
-    float x = (gl_VertexID % 1201) / 1200.0;
-    float y = (gl_VertexID / 1201) / 1200.0;
+    // Współrzędne próbki w kafelku z numeru wierzchołka (bloki po 1201x1201)
+    int side   = min(tile_samples, 1201),
+        blocks = (tile_samples - 1) / (side - 1);
+    int block = gl_VertexID / (side * side),
+        local = gl_VertexID % (side * side);
+
+    int i = (block / blocks) * (side - 1) + local / side,
+        j = (block % blocks) * (side - 1) + local % side;
+
+    float x = j * float(tile_span) / float(tile_samples - 1);
+    float y = i * float(tile_span) / float(tile_samples - 1);
+
+    geoCoords = vec2(x + longitude_degrees, y + latitude_degrees);
 
     x = (x + longitude_degrees) * x_condensation;
     y = (y +  latitude_degrees);
 
     fragColor = heightToColor(height);
+    filled = fill_mask_enabled != 0 ? texelFetch(fill_mask, texelIndex(i, j)).r : 0.0;
+    coverage = height < -30000.0 ? 0.0 : 1.0;       // obszar bez kafli w węźle piramidy
+    shade = hillshade_enabled != 0 ? hillshade(i, j, cos(radians(geoCoords.y))) : 1.0;
     gl_Position = projection * view * vec4(x, y, 0.0, 1.0);
 }
\ No newline at end of file
@@ -6,11 +6,25 @@ layout(location = 0)  in      float height;
 
 layout(location = 5)  uniform   int  latitude_degrees;
 layout(location = 6)  uniform   int longitude_degrees;
+layout(location = 9)  uniform   int  hillshade_enabled;
+layout(location = 10) uniform  vec3  tile_origin;       // narożnik kafla względem kamery
+layout(location = 11) uniform  vec4  tile_trig;         // cos/sin szerokości i długości narożnika
+layout(location = 12) uniform   int  trig_tables;
+layout(binding  = 2)  uniform samplerBuffer lat_table;  // (sin - sin lat0, cos - cos lat0) dla wierszy
+layout(binding  = 3)  uniform samplerBuffer lon_table;  // (sin - sin lon0, cos - cos lon0) dla kolumn
+layout(location = 13) uniform   int  tile_samples;      // próbek na bok kafla (1201, 3601, węzeł piramidy 241)
+layout(location = 17) uniform   int  fill_mask_enabled;
+layout(binding  = 1)  uniform samplerBuffer heights;
+layout(binding  = 4)  uniform samplerBuffer fill_mask;  // 1 - próbka z wypełnionego braku danych
 
 layout(location = 14) uniform mat4 view;
 layout(location = 15) uniform mat4 projection;
 
 out vec3 fragColor;
+out vec2 geoCoords;
+out float shade;
+out float coverage;
+out float filled;
 
 vec3 heightToColor(float ht) {
     if (ht < 0.0) return vec3(0.0, 0.0, 1.0);
@@ -20,29 +34,107 @@ vec3 heightToColor(float ht) {
     else return vec3(1.0, ht / 2000.0 - 1.0, ht / 2000.0 - 1.0);
 }
 
+// Indeks próbki (i, j) w buforze wysokości ułożonym w bloki 1201x1201 (kafle 1" - 3x3 bloki
+// o wspólnych krawędziach, zob. Tile::texelIndex); mniejsze kafle to jeden blok
+int texelIndex(int i, int j) {
+    int side   = min(tile_samples, 1201),
+        blocks = (tile_samples - 1) / (side - 1);
+    int bi = min(i / (side - 1), blocks - 1),
+        bj = min(j / (side - 1), blocks - 1);
+
+    return ((bi * blocks + bj) * side + (i - bi * (side - 1))) * side + (j - bj * (side - 1));
+}
+
+// Cieniowanie rzeźby: normalna z różnic centralnych wysokości sąsiednich próbek (odczyt z bufora
+// wysokości), oświetlenie z północnego zachodu pod kątem 45°. Płaski teren daje wartość 1.0.
+float hillshade(int i, int j, float cos_latitude) {
+    int last = tile_samples - 1;
+    int w = max(j - 1, 0), e = min(j + 1, last),
+        s = max(i - 1, 0), n = min(i + 1, last);
+
+    float h  = height;
+    float hw = texelFetch(heights, texelIndex(i, w)).r, he = texelFetch(heights, texelIndex(i, e)).r,
+          hs = texelFetch(heights, texelIndex(s, j)).r, hn = texelFetch(heights, texelIndex(n, j)).r;
+
+    // Brak danych (-1000) traktowany jak wysokość bieżącej próbki
+    if (hw < -999.0) hw = h;
+    if (he < -999.0) he = h;
+    if (hs < -999.0) hs = h;
+    if (hn < -999.0) hn = h;
+
+    float cell = 6378000.0 * radians(1.0 / float(last));
+    float dzdx = (he - hw) / (float(e - w) * cell * cos_latitude);
+    float dzdy = (hn - hs) / (float(n - s) * cell);
+
+    // Przewyższenie dla czytelności rzeźby na nizinach
+    vec3 normal = normalize(vec3(-dzdx * 3.0, -dzdy * 3.0, 1.0));
+    vec3 light  = normalize(vec3(-0.5, 0.5, 0.7071));
+
+    return clamp(dot(normal, light) / light.z, 0.0, 1.5);
+}
+
 void main() {
     float earth_radius = 637800.0;
 
-    float x = (gl_VertexID % 1201) / 1200.0;
-    float y = (gl_VertexID / 1201) / 1200.0;
+    // Współrzędne próbki w kafelku z numeru wierzchołka (bloki po 1201x1201)
+    int side   = min(tile_samples, 1201),
+        blocks = (tile_samples - 1) / (side - 1);
+    int block = gl_VertexID / (side * side),
+        local = gl_VertexID % (side * side);
+
+    int i = (block / blocks) * (side - 1) + local / side,
+        j = (block % blocks) * (side - 1) + local % side;
+
+    float x = j / float(tile_samples - 1);
+    float y = i / float(tile_samples - 1);
+
+    geoCoords = vec2(x + longitude_degrees, y + latitude_degrees);
+
+    // Pozycja względem kamery: narożnik kafla (podwójna precyzja na CPU) + małe przesunięcie
+    // wewnątrz kafla, bez odejmowania dużych liczb.
+    float cos_lat0 = tile_trig.x, sin_lat0 = tile_trig.y,
+          cos_lon0 = tile_trig.z, sin_lon0 = tile_trig.w;
 
-    x = (x + longitude_degrees);
-    y = (y +  latitude_degrees);
+    float d_sin_lat, d_cos_lat, d_sin_lon, d_cos_lon;
 
-    float longitude_radians = radians(x);
-    float  latitude_radians = radians(y);
+    if (trig_tables != 0) {
+        // Różnice sin/cos wiersza i kolumny z tablic liczonych na CPU
+        vec2 lat_diff = texelFetch(lat_table, i).rg,
+             lon_diff = texelFetch(lon_table, j).rg;
 
-    float radius = earth_radius + height / 10.0;
-    vec3 position = vec3(
-        cos(latitude_radians) * cos(longitude_radians),
-        sin(latitude_radians),
-        cos(latitude_radians) * sin(longitude_radians)
+        d_sin_lat = lat_diff.x;  d_cos_lat = lat_diff.y;
+        d_sin_lon = lon_diff.x;  d_cos_lon = lon_diff.y;
+    } else {
+        // Różnice sin/cos ze wzorów na połowę kąta
+        float sy = sin(radians(y) * 0.5), cy = cos(radians(y) * 0.5),
+              sx = sin(radians(x) * 0.5), cx = cos(radians(x) * 0.5);
+
+        d_sin_lat =  2.0 * (cos_lat0 * cy - sin_lat0 * sy) * sy;        // sin(lat) - sin(lat0)
+        d_cos_lat = -2.0 * (sin_lat0 * cy + cos_lat0 * sy) * sy;        // cos(lat) - cos(lat0)
+        d_sin_lon =  2.0 * (cos_lon0 * cx - sin_lon0 * sx) * sx;        // sin(lon) - sin(lon0)
+        d_cos_lon = -2.0 * (sin_lon0 * cx + cos_lon0 * sx) * sx;        // cos(lon) - cos(lon0)
+    }
+
+    float cos_lat = cos_lat0 + d_cos_lat;
+
+    vec3 offset = vec3(
+        cos_lat * d_cos_lon + d_cos_lat * cos_lon0,
+        d_sin_lat,
+        cos_lat * d_sin_lon + d_cos_lat * sin_lon0
+    );
+    vec3 up = vec3(
+        cos_lat * (cos_lon0 + d_cos_lon),
+        sin_lat0 + d_sin_lat,
+        cos_lat * (sin_lon0 + d_sin_lon)
     );
 
-    position *= radius;
+    vec3 position = tile_origin + offset * earth_radius + up * (height / 10.0);
 
     // Przekazanie koloru
     fragColor = heightToColor(height);
+    filled = fill_mask_enabled != 0 ? texelFetch(fill_mask, texelIndex(i, j)).r : 0.0;
+    coverage = 1.0;
+    shade = hillshade_enabled != 0 ? hillshade(i, j, cos_lat) : 1.0;
 
     // Przekształcenie w przestrzeni świata do przestrzeni widoku/projekcji
     gl_Position = projection * view * vec4(position, 1.0);